@@ -0,0 +1,123 @@
+#version 330 core
+
+/**
+ * Renders the sky-view LUT.
+ * Every texel stores the in-scattered luminance for a view direction.
+ * U - The azimuth relative to the sun, mapped from [0, PI] to [0, 1]
+ * V - The elevation, mapped non-linearly from [-PI/2, PI/2] to [0, 1],
+ *     which puts more texels around the horizon.
+ * All distances are in kilometers.
+ */
+
+in vec2 ioUV;
+
+out vec4 FragColor;
+
+uniform sampler2D u_TransmittanceLut;
+uniform vec3 u_SunDirection;
+
+const float PI = 3.14159265;
+
+const float GROUND_RADIUS = 6360.0;
+const float ATMOSPHERE_RADIUS = 6460.0;
+const float VIEW_HEIGHT = GROUND_RADIUS + 0.2;
+
+const vec3 RAYLEIGH_SCATTERING = vec3(5.802, 13.558, 33.1) * 1e-3;
+const float RAYLEIGH_SCALE_HEIGHT = 8.0;
+const float MIE_SCATTERING = 3.996e-3;
+const float MIE_EXTINCTION = 4.440e-3;
+const float MIE_SCALE_HEIGHT = 1.2;
+const float MIE_ASYMMETRY = 0.8;
+const vec3 OZONE_ABSORPTION = vec3(0.650, 1.881, 0.085) * 1e-3;
+
+// Cheap stand-in for multiple scattering, added isotropically.
+const float MULTIPLE_SCATTERING_FACTOR = 0.1;
+
+const int STEPS = 30;
+
+vec3 extinctionAt(float altitude)
+{
+    float rayleighDensity = exp(-altitude / RAYLEIGH_SCALE_HEIGHT);
+    float mieDensity = exp(-altitude / MIE_SCALE_HEIGHT);
+    float ozoneDensity = max(0.0, 1.0 - abs(altitude - 25.0) / 15.0);
+    return RAYLEIGH_SCATTERING * rayleighDensity + MIE_EXTINCTION * mieDensity + OZONE_ABSORPTION * ozoneDensity;
+}
+
+float raySphereIntersection(vec3 origin, vec3 direction, float radius)
+{
+    float b = dot(origin, direction);
+    float c = dot(origin, origin) - radius * radius;
+    float discriminant = b * b - c;
+    if (discriminant < 0.0)
+        return -1.0;
+    float root = sqrt(discriminant);
+    if (-b - root >= 0.0)
+        return -b - root;
+    if (-b + root >= 0.0)
+        return -b + root;
+    return -1.0;
+}
+
+vec3 sampleTransmittance(float height, float cosZenith)
+{
+    vec2 uv = vec2(cosZenith * 0.5 + 0.5, (height - GROUND_RADIUS) / (ATMOSPHERE_RADIUS - GROUND_RADIUS));
+    return texture(u_TransmittanceLut, uv).rgb;
+}
+
+float rayleighPhase(float cosTheta)
+{
+    return 3.0 / (16.0 * PI) * (1.0 + cosTheta * cosTheta);
+}
+
+float miePhase(float cosTheta)
+{
+    float g2 = MIE_ASYMMETRY * MIE_ASYMMETRY;
+    return 3.0 / (8.0 * PI) * ((1.0 - g2) * (1.0 + cosTheta * cosTheta)) /
+           ((2.0 + g2) * pow(1.0 + g2 - 2.0 * MIE_ASYMMETRY * cosTheta, 1.5));
+}
+
+void main()
+{
+    float azimuth = ioUV.x * PI;
+    float v = ioUV.y * 2.0 - 1.0;
+    float elevation = sign(v) * v * v * PI * 0.5;
+
+    // The LUT is parametrized relative to the sun, only its elevation matters.
+    vec3 sunDirection = vec3(sqrt(max(0.0, 1.0 - u_SunDirection.y * u_SunDirection.y)), u_SunDirection.y, 0.0);
+    vec3 viewDirection = vec3(cos(elevation) * cos(azimuth), sin(elevation), cos(elevation) * sin(azimuth));
+    vec3 origin = vec3(0.0, VIEW_HEIGHT, 0.0);
+
+    float groundDistance = raySphereIntersection(origin, viewDirection, GROUND_RADIUS);
+    float distance = groundDistance > 0.0 ? groundDistance
+                                          : raySphereIntersection(origin, viewDirection, ATMOSPHERE_RADIUS);
+    float stepSize = distance / float(STEPS);
+
+    float cosTheta = dot(viewDirection, sunDirection);
+    float phaseRayleigh = rayleighPhase(cosTheta);
+    float phaseMie = miePhase(cosTheta);
+
+    vec3 luminance = vec3(0.0);
+    vec3 transmittance = vec3(1.0);
+
+    for (int i = 0; i < STEPS; i++)
+    {
+        vec3 samplePosition = origin + viewDirection * (float(i) + 0.5) * stepSize;
+        float height = length(samplePosition);
+        float altitude = height - GROUND_RADIUS;
+
+        vec3 rayleighScattering = RAYLEIGH_SCATTERING * exp(-altitude / RAYLEIGH_SCALE_HEIGHT);
+        float mieScattering = MIE_SCATTERING * exp(-altitude / MIE_SCALE_HEIGHT);
+        vec3 extinction = extinctionAt(altitude);
+        vec3 sampleTransmittanceStep = exp(-extinction * stepSize);
+
+        vec3 sunTransmittance = sampleTransmittance(height, dot(samplePosition / height, sunDirection));
+        vec3 scattering = (rayleighScattering * phaseRayleigh + mieScattering * phaseMie) * sunTransmittance
+                        + (rayleighScattering + mieScattering) * MULTIPLE_SCATTERING_FACTOR;
+
+        // Analytical integration of the scattering over the step
+        luminance += transmittance * (scattering - scattering * sampleTransmittanceStep) / extinction;
+        transmittance *= sampleTransmittanceStep;
+    }
+
+    FragColor = vec4(luminance, 1.0);
+}
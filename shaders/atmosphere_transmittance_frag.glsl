@@ -0,0 +1,77 @@
+#version 330 core
+
+/**
+ * Renders the transmittance LUT.
+ * Every texel stores the transmittance from a point in the atmosphere
+ * towards the top of the atmosphere.
+ * U - The cosine of the zenith angle, mapped from [-1, 1] to [0, 1]
+ * V - The altitude, mapped from [ground, top] to [0, 1]
+ * All distances are in kilometers.
+ */
+
+in vec2 ioUV;
+
+out vec4 FragColor;
+
+const float GROUND_RADIUS = 6360.0;
+const float ATMOSPHERE_RADIUS = 6460.0;
+
+const vec3 RAYLEIGH_SCATTERING = vec3(5.802, 13.558, 33.1) * 1e-3;
+const float RAYLEIGH_SCALE_HEIGHT = 8.0;
+const float MIE_EXTINCTION = 4.440e-3;
+const float MIE_SCALE_HEIGHT = 1.2;
+const vec3 OZONE_ABSORPTION = vec3(0.650, 1.881, 0.085) * 1e-3;
+
+const int STEPS = 40;
+
+vec3 extinctionAt(float altitude)
+{
+    float rayleighDensity = exp(-altitude / RAYLEIGH_SCALE_HEIGHT);
+    float mieDensity = exp(-altitude / MIE_SCALE_HEIGHT);
+    float ozoneDensity = max(0.0, 1.0 - abs(altitude - 25.0) / 15.0);
+    return RAYLEIGH_SCATTERING * rayleighDensity + MIE_EXTINCTION * mieDensity + OZONE_ABSORPTION * ozoneDensity;
+}
+
+// Distance to the nearest intersection in front of the origin, or -1 if there's none.
+float raySphereIntersection(vec3 origin, vec3 direction, float radius)
+{
+    float b = dot(origin, direction);
+    float c = dot(origin, origin) - radius * radius;
+    float discriminant = b * b - c;
+    if (discriminant < 0.0)
+        return -1.0;
+    float root = sqrt(discriminant);
+    if (-b - root >= 0.0)
+        return -b - root;
+    if (-b + root >= 0.0)
+        return -b + root;
+    return -1.0;
+}
+
+void main()
+{
+    float cosZenith = ioUV.x * 2.0 - 1.0;
+    float height = mix(GROUND_RADIUS, ATMOSPHERE_RADIUS, ioUV.y);
+
+    vec3 origin = vec3(0.0, height, 0.0);
+    vec3 direction = vec3(sqrt(max(0.0, 1.0 - cosZenith * cosZenith)), cosZenith, 0.0);
+
+    // Rays that hit the ground are fully absorbed.
+    if (raySphereIntersection(origin, direction, GROUND_RADIUS) > 0.0)
+    {
+        FragColor = vec4(0.0, 0.0, 0.0, 1.0);
+        return;
+    }
+
+    float distance = raySphereIntersection(origin, direction, ATMOSPHERE_RADIUS);
+    float stepSize = distance / float(STEPS);
+    vec3 opticalDepth = vec3(0.0);
+
+    for (int i = 0; i < STEPS; i++)
+    {
+        vec3 samplePosition = origin + direction * (float(i) + 0.5) * stepSize;
+        opticalDepth += extinctionAt(length(samplePosition) - GROUND_RADIUS) * stepSize;
+    }
+
+    FragColor = vec4(exp(-opticalDepth), 1.0);
+}
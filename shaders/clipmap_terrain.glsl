@@ -0,0 +1,37 @@
+// The vertices of the geometry clipmap, shared by the world and shadow depth shaders,
+// so the shadows are cast by the same surface that is drawn.
+// The including shader declares u_Heightmap, u_HeightmapCellSize, u_ClipmapCellCount and u_ClipmapGridOffset.
+
+float clipmapHeightAt(ivec2 grid, int level)
+{
+    // The height textures of the levels are addressed toroidally
+    int mask = textureSize(u_Heightmap, 0).x - 1;
+    return texelFetch(u_Heightmap, ivec3(grid & mask, level), 0).r;
+}
+
+// Get the world space position and the normal of a vertex of a clipmap level.
+// `local` is the vertex within the grid of the level, `instanceData` the origin of the level and the level.
+vec3 getClipmapVertex(ivec2 local, vec3 instanceData, out vec3 normal)
+{
+    ivec2 grid = ivec2(instanceData.xy) + local;
+    int level = int(instanceData.z);
+    float cellSize = u_HeightmapCellSize * exp2(instanceData.z);
+
+    float heightLeft = clipmapHeightAt(grid - ivec2(1, 0), level);
+    float heightRight = clipmapHeightAt(grid + ivec2(1, 0), level);
+    float heightBack = clipmapHeightAt(grid - ivec2(0, 1), level);
+    float heightFront = clipmapHeightAt(grid + ivec2(0, 1), level);
+    float height = clipmapHeightAt(grid, level);
+
+    // The odd vertices on the border of a level lie halfway an edge of the coarser level,
+    // move them onto that edge so there are no cracks between the levels.
+    if ( ( local.x == 0 || local.x == u_ClipmapCellCount ) && ( local.y & 1 ) == 1 )
+        height = ( heightBack + heightFront ) * 0.5;
+    else if ( ( local.y == 0 || local.y == u_ClipmapCellCount ) && ( local.x & 1 ) == 1 )
+        height = ( heightLeft + heightRight ) * 0.5;
+
+    normal = normalize(vec3(heightLeft - heightRight, 2.0 * cellSize, heightBack - heightFront));
+    return vec3(float(grid.x) * cellSize + u_ClipmapGridOffset,
+                height,
+                float(grid.y) * cellSize + u_ClipmapGridOffset);
+}
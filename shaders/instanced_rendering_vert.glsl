@@ -0,0 +1,30 @@
+#version 330 core
+
+layout(location = 0) in vec3 position;
+layout(location = 1) in vec3 normal;
+layout(location = 3) in mat4 instanceMatrix; // Occupies locations 3 up to and including 6
+
+out vec3 ioFragPos;       // The position of the fragment in world space
+out vec3 ioNormal;        // The normal vector of the fragment
+out vec3 ioPosition;      // The position of the fragment, used for coloring
+out vec3 ioWorldPosition; // The position of the fragment in world space, used for shadows
+out float ioViewDepth;    // The distance of the fragment along the view direction
+
+uniform mat4 u_ModelMatrix;
+uniform mat4 u_ViewMatrix;
+uniform mat4 u_ProjectionMatrix;
+
+uniform mat4 u_ModelViewProjectionMatrix;
+
+void main()
+{
+    vec4 worldPosition = instanceMatrix * vec4(position, 1.0);
+
+    ioNormal = normalize(mat3(instanceMatrix) * normal);
+    ioFragPos = vec3(u_ModelMatrix * worldPosition);
+    ioPosition = worldPosition.xyz;
+    ioWorldPosition = worldPosition.xyz;
+    ioViewDepth = -(u_ViewMatrix * u_ModelMatrix * worldPosition).z;
+
+    gl_Position = u_ModelViewProjectionMatrix * worldPosition;
+}
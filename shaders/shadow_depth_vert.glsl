@@ -0,0 +1,39 @@
+#version 330 core
+
+layout(location = 0) in vec3 position;
+layout(location = 3) in vec3 instanceData; // Height map or clipmap terrain, see world_rendering_vert.glsl
+
+uniform mat4 u_LightViewProjectionMatrix;
+
+const int TERRAIN_RENDER_HEIGHTMAP = 1;
+const int TERRAIN_RENDER_CLIPMAP = 2;
+
+uniform int u_TerrainMode;
+uniform sampler2DArray u_Heightmap;
+uniform float u_HeightmapCellSize;
+uniform int u_ClipmapCellCount;
+uniform float u_ClipmapGridOffset;
+
+#include "clipmap_terrain.glsl"
+
+void main()
+{
+    vec3 vertexPosition = position;
+
+    if ( u_TerrainMode == TERRAIN_RENDER_HEIGHTMAP )
+    {
+        ivec3 texel = ivec3(ivec2(position.xz) + ivec2(1), int(instanceData.z));
+        vertexPosition = vec3(instanceData.x + position.x * u_HeightmapCellSize,
+                              texelFetch(u_Heightmap, texel, 0).r,
+                              instanceData.y + position.z * u_HeightmapCellSize);
+    }
+    else if ( u_TerrainMode == TERRAIN_RENDER_CLIPMAP )
+    {
+        vec3 normal;
+        vertexPosition = getClipmapVertex(ivec2(position.xz), instanceData, normal);
+    }
+
+    // Vertices below the water level are moved to the water surface in the world shader,
+    // approximate that here so the ocean floor doesn't cast shadows onto the water.
+    gl_Position = u_LightViewProjectionMatrix * vec4(vertexPosition.x, max(vertexPosition.y, 0.0), vertexPosition.z, 1.0);
+}
@@ -1,58 +1,57 @@
 #version 330 core
 
-in vec4 FragPos;
+/**
+ * Draws the sky from the precomputed atmosphere LUTs.
+ * This shader must not write gl_FragDepth or discard, otherwise
+ * the early depth test against the already drawn terrain is lost.
+ */
+
+in vec3 ioDirection;
 
 out vec4 FragColor;
 
 /** Sun parameters */
-uniform float u_SunSize;
+uniform float u_SunSize; // Angular radius, in radians
 uniform float u_SunIntensity;
 uniform vec4 u_SunColor;
 uniform vec3 u_SunPosition;
 
-uniform vec2 u_CameraRotation;
-uniform vec2 u_Resolution;
+uniform sampler2D u_TransmittanceLut;
+uniform sampler2D u_SkyViewLut;
+uniform vec3 u_SkyViewSunDirection;
 
-uniform mat4 u_ViewMatrix;
-uniform mat4 u_ModelMatrix;
-uniform mat4 u_ProjectionMatrix;
+const float PI = 3.14159265;
+const float EXPOSURE = 10.0;
 
-const vec4 skyMaxRefractionColor = vec4(.23, .64, .97, 1.0);
-const vec4 skyMinRefractionColor = vec4(1.0, 1.0, 1.0, 1.0);
+const float GROUND_RADIUS = 6360.0;
+const float ATMOSPHERE_RADIUS = 6460.0;
+const float VIEW_HEIGHT = GROUND_RADIUS + 0.2;
 
 void main()
 {
-
-    // Project the sun position to screen space
-    vec4 sunPosView = u_ViewMatrix * u_ModelMatrix * vec4(u_SunPosition, 1.0);
-    vec4 sunPosScreen = u_ProjectionMatrix * sunPosView;
-
-    vec4 resultingColor = mix(skyMinRefractionColor, skyMaxRefractionColor, gl_FragCoord.y / u_Resolution.y);
-
-    sunPosScreen /= sunPosScreen.w;
-
-    // Convert from normalized device coordinates to screen coordinates
-    sunPosScreen.xy = sunPosScreen.xy * 0.5 + 0.5;
-
-    // Get the fragment's screen space position
-    vec2 fragCoord = gl_FragCoord.xy / u_Resolution; // Assuming a window size of 800x600, adjust as necessary
-
-    // Compute distance from fragment to sun's screen position
-    float dist = length(fragCoord - sunPosScreen.xy);
-
-    // if sun nearby, draw sun :D
-    if (dist < u_SunSize && sunPosScreen.z < 1.0 && sunPosScreen.z > 0.0) {
-        // now instead of radial gradient, use
-
-        float intensity = (1.0 - dist / u_SunSize) * 1.5;
-
-        resultingColor = vec4(
-                min(1, max(0, resultingColor.r + (u_SunColor.r - resultingColor.r) * intensity)),
-                min(1, max(0, resultingColor.g + (u_SunColor.g - resultingColor.g) * intensity)),
-                min(1, max(0, resultingColor.b + (u_SunColor.b - resultingColor.b) * intensity)),
-                1.0
-        );
+    vec3 direction = normalize(ioDirection);
+    vec3 sunDirection = normalize(u_SunPosition);
+
+    // Azimuth relative to the sun the LUT was rendered with
+    float cosAzimuth = 1.0;
+    if (length(direction.xz) > 1e-4 && length(u_SkyViewSunDirection.xz) > 1e-4)
+        cosAzimuth = dot(normalize(direction.xz), normalize(u_SkyViewSunDirection.xz));
+
+    float elevation = asin(clamp(direction.y, -1.0, 1.0));
+    float v = 0.5 + 0.5 * sign(elevation) * sqrt(abs(elevation) / (PI * 0.5));
+    vec2 uv = vec2(acos(clamp(cosAzimuth, -1.0, 1.0)) / PI, v);
+
+    vec3 luminance = texture(u_SkyViewLut, uv).rgb * u_SunIntensity;
+
+    // Sun disc, attenuated by the atmosphere in front of it
+    float sunCosAngle = dot(direction, sunDirection);
+    if (sunCosAngle > cos(u_SunSize))
+    {
+        float intensity = smoothstep(cos(u_SunSize), cos(u_SunSize * 0.5), sunCosAngle);
+        vec2 transmittanceUV = vec2(direction.y * 0.5 + 0.5,
+                                    (VIEW_HEIGHT - GROUND_RADIUS) / (ATMOSPHERE_RADIUS - GROUND_RADIUS));
+        luminance += u_SunColor.rgb * texture(u_TransmittanceLut, transmittanceUV).rgb * intensity * u_SunIntensity;
     }
 
-    FragColor = resultingColor;
-}
\ No newline at end of file
+    FragColor = vec4(1.0 - exp(-luminance * EXPOSURE), 1.0);
+}
@@ -2,19 +2,17 @@
 
 layout(location = 0) in vec3 position;
 
-//out vec4 FragModelPos;
-out vec4 FragPos;
-
-uniform mat4 u_ModelMatrix;
-uniform mat4 u_ViewMatrix;
-uniform mat4 u_ProjectionMatrix;
-uniform vec3 u_CameraPosition;
+out vec3 ioDirection;
 
 uniform mat4 u_ModelViewProjectionMatrix;
 
 void main()
 {
-    gl_Position = u_ModelViewProjectionMatrix * vec4(position, 1.0);
-    FragPos = u_ModelMatrix * vec4(position, 1.0);
-    //FragModelPos = u_ModelMatrix * vec4(position, 1.0);
-}
\ No newline at end of file
+    // Force the skybox onto the far plane. It is drawn last, so with GL_LEQUAL
+    // only the pixels that weren't covered by anything else pass the depth test.
+    gl_Position = (u_ModelViewProjectionMatrix * vec4(position, 1.0)).xyww;
+
+    // The skybox model matrix only rotates the cube, so the object space
+    // position is the world space view direction.
+    ioDirection = position;
+}
@@ -3,6 +3,8 @@
 in vec3 ioFragPos;
 in vec3 ioNormal;
 in vec3 ioPosition;
+in vec3 ioWorldPosition;
+in float ioViewDepth;
 
 uniform vec3 u_SunPosition;
 uniform float u_FogDensity;
@@ -13,6 +15,12 @@ out vec4 FragColor;
 
 uniform vec3 u_CameraPosition;
 
+/** Cascaded shadow map parameters */
+const int SHADOW_CASCADE_COUNT = 4;
+uniform sampler2DArrayShadow u_ShadowMap;
+uniform mat4 u_ShadowCascadeMatrices[SHADOW_CASCADE_COUNT];
+uniform float u_ShadowCascadeSplits[SHADOW_CASCADE_COUNT];
+
 const vec3 LIGHT_COLOR = vec3(1.0, 1.0, 1.0);
 
 /**struct {
@@ -28,6 +36,43 @@ struct {
     vec3 specular;
 } Material;*/
 
+/**
+ * Returns how much of the sunlight reaches the fragment,
+ * 0 being fully shadowed, 1 being fully lit.
+ */
+float shadowFactor(vec3 normal, vec3 lightDir)
+{
+    int cascade = -1;
+    for (int i = 0; i < SHADOW_CASCADE_COUNT; i++)
+    {
+        if (ioViewDepth <= u_ShadowCascadeSplits[i])
+        {
+            cascade = i;
+            break;
+        }
+    }
+
+    if (cascade < 0)
+        return 1.0;
+
+    vec4 lightSpacePosition = u_ShadowCascadeMatrices[cascade] * vec4(ioWorldPosition, 1.0);
+    vec3 shadowCoordinate = lightSpacePosition.xyz * 0.5 + 0.5;
+    float bias = max(0.0005 * (1.0 - dot(normal, lightDir)), 0.0001);
+
+    // 3x3 percentage closer filtering
+    vec2 texelSize = 1.0 / vec2(textureSize(u_ShadowMap, 0).xy);
+    float lit = 0.0;
+    for (int x = -1; x <= 1; x++)
+    {
+        for (int y = -1; y <= 1; y++)
+        {
+            lit += texture(u_ShadowMap, vec4(shadowCoordinate.xy + vec2(x, y) * texelSize,
+                                             float(cascade), shadowCoordinate.z - bias));
+        }
+    }
+    return lit / 9.0;
+}
+
 void main()
 {
     vec3 objectColor = vec3(1, 1, .9);
@@ -56,7 +101,8 @@ void main()
     float spec = pow(max(dot(viewDir, reflectDir), 0.0), 32);
     vec3 specular = specularStrength * spec * u_SunColor.rgb;
 
-    vec3 result = (ambient + diffuse + specular) * objectColor;
+    float shadow = shadowFactor(normal, normalize(u_SunPosition));
+    vec3 result = (ambient + shadow * (diffuse + specular)) * objectColor;
 
     FragColor = vec4(result, 1);
 }
\ No newline at end of file
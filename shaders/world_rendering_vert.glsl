@@ -2,10 +2,14 @@
 
 layout(location = 0) in vec3 position;
 layout(location = 1) in vec3 normal;
+layout(location = 3) in vec3 instanceData; // Height map terrain: origin of the chunk (x, z) and texture layer
+                                           // Clipmap terrain: origin of the level in grid cells (x, z) and level
 
 out vec3 ioFragPos;  // The position of the fragment in world space
 out vec3 ioNormal;   // The normal vector of the fragment
 out vec3 ioPosition; // The position of the fragment in object space
+out vec3 ioWorldPosition; // The displaced position of the fragment in world space
+out float ioViewDepth;    // The distance of the fragment along the view direction
 
 uniform mat4 u_ModelMatrix;
 uniform mat4 u_ViewMatrix;
@@ -15,6 +19,18 @@ uniform mat4 u_ModelViewProjectionMatrix;
 
 uniform float u_time;
 
+// Matches the TERRAIN_RENDER_* modes of the world.
+// For the height map and clipmap terrain the position attribute holds the grid coordinates of the vertex.
+const int TERRAIN_RENDER_MESH = 0;
+const int TERRAIN_RENDER_HEIGHTMAP = 1;
+const int TERRAIN_RENDER_CLIPMAP = 2;
+
+uniform int u_TerrainMode;
+uniform sampler2DArray u_Heightmap;
+uniform float u_HeightmapCellSize; // The cell size of the chunks and of the finest clipmap level
+uniform int u_ClipmapCellCount;
+uniform float u_ClipmapGridOffset;
+
 const float water_level = 0.0;
 const float large_waveheight = 1.0f;
 const float small_waveheight = 1.0f;
@@ -105,28 +121,60 @@ float waveFunction( vec2 p )
     return height;
 }
 
+float heightAt(ivec2 texel, int layer)
+{
+    return texelFetch(u_Heightmap, ivec3(texel, layer), 0).r;
+}
+
+#include "clipmap_terrain.glsl"
+
 void main()
 {
-    vec3 resultingPosition = position;
-    ioNormal = normal;
-    ioFragPos = vec3(u_ModelMatrix * vec4(position, 1.0));
-    if ( position.y <= 0)
+    vec3 vertexPosition = position;
+    vec3 vertexNormal = normal;
+
+    if ( u_TerrainMode == TERRAIN_RENDER_HEIGHTMAP )
+    {
+        // Skip the apron of the height grid
+        ivec2 texel = ivec2(vertexPosition.xz) + ivec2(1);
+        int layer = int(instanceData.z);
+        float heightLeft = heightAt(texel - ivec2(1, 0), layer);
+        float heightRight = heightAt(texel + ivec2(1, 0), layer);
+        float heightBack = heightAt(texel - ivec2(0, 1), layer);
+        float heightFront = heightAt(texel + ivec2(0, 1), layer);
+
+        vertexNormal = normalize(vec3(heightLeft - heightRight, 2.0 * u_HeightmapCellSize, heightBack - heightFront));
+        vertexPosition = vec3(instanceData.x + vertexPosition.x * u_HeightmapCellSize,
+                              heightAt(texel, layer),
+                              instanceData.y + vertexPosition.z * u_HeightmapCellSize);
+    }
+    else if ( u_TerrainMode == TERRAIN_RENDER_CLIPMAP )
+    {
+        vertexPosition = getClipmapVertex(ivec2(vertexPosition.xz), instanceData, vertexNormal);
+    }
+
+    vec3 resultingPosition = vertexPosition;
+    ioNormal = vertexNormal;
+    ioFragPos = vec3(u_ModelMatrix * vec4(vertexPosition, 1.0));
+    if ( vertexPosition.y <= 0)
     {
-        float y = waveFunction(vec2(position.x, position.z));
+        float y = waveFunction(vec2(vertexPosition.x, vertexPosition.z));
         float delta = .05;
 
         // Calculate the two vectors from the origin vector (delta V)
-        float udy = waveFunction(vec2(position.x + delta, position.z)) - y;
-        float vdy = waveFunction(vec2(position.x, position.z + delta)) - y;
+        float udy = waveFunction(vec2(vertexPosition.x + delta, vertexPosition.z)) - y;
+        float vdy = waveFunction(vec2(vertexPosition.x, vertexPosition.z + delta)) - y;
         vec3 u = vec3(delta, udy, 0);
         vec3 v = vec3(0, vdy, delta);
         ioNormal = normalize(cross(u, v));
-        ioNormal = normalize(vec3(waveFunction(position.xz-.1) - waveFunction(position.xz+.1), 1.0, waveFunction(position.xz-.1) - waveFunction(position.xz+.1)));
+        ioNormal = normalize(vec3(waveFunction(vertexPosition.xz-.1) - waveFunction(vertexPosition.xz+.1), 1.0, waveFunction(vertexPosition.xz-.1) - waveFunction(vertexPosition.xz+.1)));
         resultingPosition.y = y;
     }
 
     ioNormal = normalize(ioNormal);
 
     gl_Position = u_ModelViewProjectionMatrix * vec4(resultingPosition, 1.0);
-    ioPosition = position;
+    ioPosition = vertexPosition;
+    ioWorldPosition = resultingPosition;
+    ioViewDepth = -(u_ViewMatrix * u_ModelMatrix * vec4(resultingPosition, 1.0)).z;
 }
\ No newline at end of file
@@ -6,9 +6,17 @@
 #include "world/entity/player.h"
 #include "world/noise.h"
 #include "world/world.h"
+#include "rendering/world_renderer.h"
+#include "net/chunk_server.h"
 #include "rendering/culling/frustum.h"
+#include "rendering/sky/atmosphere.h"
+#include "rendering/shadow/cascaded_shadow_map.h"
+#include "rendering/frame_governor.h"
+#include "rendering/render_stats.h"
+#include "threading/task_graph.h"
 
 #include <filesystem>
+#include <cstring>
 
 
 using namespace std::chrono;
@@ -17,10 +25,19 @@ using namespace std::chrono;
 
 #define NEAR_PLANE 0.1f
 #define FAR_PLANE 50000.0f
+#define CLIPMAP_FAR_PLANE 400000.0f // The clipmap reaches about ten times further than the chunks
+#define CLIPMAP_NEAR_PLANE 4.0f      // Keeps the far to near ratio at 1e5, so distant terrain doesn't z-fight
 #define SKYBOX_SIZE (FAR_PLANE / 2)
 #define FOV 70.0f
+#define TARGET_FRAME_TIME (1.0f / 60.0f)
+#define FRAME_WORKER_COUNT (2)
+#define FRAME_TRACE_PATH "frame_trace.json"
+#define WORLD_SAVE_DIRECTORY "save"
+#define TERRAIN_BRUSH_RADIUS (100.0f)
+#define TERRAIN_BRUSH_STRENGTH (10.0f)
 
 bool wireframe = false;
+bool exportFrameTrace = false;
 
 /** Window related variables */
 GLint width, height;
@@ -28,22 +45,59 @@ GLFWwindow *mainWindow;
 
 /** World object related variables */
 Player player = Player();
+Transformation camera; // The player transformation at the start of the frame, used by all rendering
 World *world;
+WorldRenderer *worldRenderer;
 glm::vec3 sunPosition = glm::normalize(glm::vec3(5.0f, 5.0f, 3.0f));
 
 /** Rendering related variables */
 Shader *worldShader, *skyboxShader;
+Shader *transmittanceShader, *skyViewShader;
+Shader *shadowDepthShader, *instancedShader;
+Atmosphere *atmosphere;
+CascadedShadowMap *shadowMap;
+FrameGovernor *frameGovernor;
 VBO *skybox;
 Frustum *viewFrustum;
 
+/** Frame scheduling related variables */
+TaskGraph *frameGraph;
+JobSystem *frameJobs;
+
 const glm::vec2 scrollFactor = glm::vec2(1.f, 1.f);
 
 void assembleSkyboxMesh();
 
+void sendStandardShaderUniforms(Shader &shader);
+
 void keyCallback(GLFWwindow *window, int key, int scancode, int action, int mods);
 
-int main()
+void buildFrameGraph(float &deltaTime, float &timePassed, float &nearPlane, float &farPlane);
+
+int main(int argc, char **argv)
 {
+    // --chunk-server [socket] [--seed seed] runs a headless chunk server, --connect [socket] fetches the chunks
+    // from one, --pipeline-stats periodically logs how long the chunks take to appear
+    const char *chunkServerPath = nullptr;
+    const char *servedSocketPath = nullptr;
+    uint32_t servedSeed = 0;
+    for ( int i = 1; i < argc; i++ ) {
+        bool hasPath = i + 1 < argc && argv[ i + 1 ][ 0 ] != '-';
+        if ( strcmp(argv[ i ], "--chunk-server") == 0 )
+            servedSocketPath = hasPath ? argv[ i + 1 ] : CHUNK_SERVER_SOCKET_PATH;
+        if ( strcmp(argv[ i ], "--seed") == 0 && i + 1 < argc )
+            servedSeed = (uint32_t) strtoul(argv[ i + 1 ], nullptr, 10);
+        if ( strcmp(argv[ i ], "--connect") == 0 )
+            chunkServerPath = hasPath ? argv[ i + 1 ] : CHUNK_SERVER_SOCKET_PATH;
+        if ( strcmp(argv[ i ], "--pipeline-stats") == 0 )
+            World::pipelineStatsInterval = WORLD_PIPELINE_STATS_INTERVAL;
+    }
+    if ( servedSocketPath ) {
+        // The server generates a single seed, clients with a save of another seed generate their chunks themselves
+        ChunkServer server(servedSocketPath, servedSeed, CHUNK_SERVER_WORKER_COUNT, CHUNK_SERVER_CACHE_CAPACITY);
+        return server.run();
+    }
+
     if ( !glfwInit()) {
         std::cout << "Failed to initialize GLFW" << std::endl;
         exit(1);
@@ -98,14 +152,62 @@ int main()
             "/Users/lucawarm/Jetbrains/CLion/graphics-test/shaders/world_rendering_frag.glsl",
             "/Users/lucawarm/Jetbrains/CLion/graphics-test/shaders/world_rendering_vert.glsl"
             );
+    transmittanceShader = new Shader(
+            "/Users/lucawarm/Jetbrains/CLion/graphics-test/shaders/atmosphere_transmittance_frag.glsl",
+            "/Users/lucawarm/Jetbrains/CLion/graphics-test/shaders/fullscreen_vert.glsl"
+            );
+    skyViewShader = new Shader(
+            "/Users/lucawarm/Jetbrains/CLion/graphics-test/shaders/atmosphere_sky_view_frag.glsl",
+            "/Users/lucawarm/Jetbrains/CLion/graphics-test/shaders/fullscreen_vert.glsl"
+            );
+    instancedShader = new Shader(
+            "/Users/lucawarm/Jetbrains/CLion/graphics-test/shaders/world_rendering_frag.glsl",
+            "/Users/lucawarm/Jetbrains/CLion/graphics-test/shaders/instanced_rendering_vert.glsl"
+            );
+    shadowDepthShader = new Shader(
+            "/Users/lucawarm/Jetbrains/CLion/graphics-test/shaders/shadow_depth_frag.glsl",
+            "/Users/lucawarm/Jetbrains/CLion/graphics-test/shaders/shadow_depth_vert.glsl"
+            );
+    atmosphere = new Atmosphere(transmittanceShader, skyViewShader);
+
+    // The terrain shaders either read the chunk meshes, or the height map or clipmap texture arrays
+    for ( Shader *terrainShader: { worldShader, shadowDepthShader } ) {
+        terrainShader->bind();
+        terrainShader->uniformInt("u_TerrainMode", WorldRenderer::terrainRenderMode);
+        terrainShader->uniformInt("u_Heightmap", HEIGHTMAP_TERRAIN_TEXTURE_UNIT);
+        terrainShader->uniformFloat("u_HeightmapCellSize", CHUNK_COORDINATE_SCALING_FACTOR);
+        terrainShader->uniformInt("u_ClipmapCellCount", CLIPMAP_CELL_COUNT);
+        terrainShader->uniformFloat("u_ClipmapGridOffset", -0.5f * CHUNK_COORDINATE_SCALING_FACTOR);
+    }
 
+    shadowMap = new CascadedShadowMap(shadowDepthShader);
+    frameGovernor = new FrameGovernor(TARGET_FRAME_TIME);
+
+    // The stored chunks are loaded as they're streamed in around the player
+    world->openStorage(WORLD_SAVE_DIRECTORY);
+    if ( chunkServerPath )
+        world->connectChunkServer(chunkServerPath);
+    world->loadEntities({ &player });
+    worldRenderer = new WorldRenderer(world);
+
+    // Generate and upload the terrain around the player before the first frame, instead of a chunk per frame
+    double warmStartBegin = ChunkPipelineStats::now();
+    int reportedPercentage = -1;
+    world->warmStart(&player, [&reportedPercentage](size_t added, size_t total) {
+        int percentage = (int) ( added * 100 / total );
+        if ( percentage / 10 == reportedPercentage / 10 && added < total )
+            return;
+        reportedPercentage = percentage;
+        std::cout << "Generating terrain: " << added << " / " << total << " chunks (" << percentage << "%)" << std::endl;
+    });
+    std::cout << "Terrain warm start took " << ChunkPipelineStats::now() - warmStartBegin << "s" << std::endl;
     world->startWorldGeneration(&player);
     world->worldObjects->push_back(&player);
 
     assembleSkyboxMesh();
 
     viewFrustum = new Frustum(
-            &player,
+            &camera,
             glm::mat4(1.0f) ,
             glm::mat4(1.0f)
             );
@@ -115,6 +217,9 @@ int main()
     float deltaTime = 1.0;
     float timePassed = 0.0;
 
+    float farPlane = WorldRenderer::terrainRenderMode == TERRAIN_RENDER_CLIPMAP ? CLIPMAP_FAR_PLANE : FAR_PLANE;
+    float nearPlane = WorldRenderer::terrainRenderMode == TERRAIN_RENDER_CLIPMAP ? CLIPMAP_NEAR_PLANE : NEAR_PLANE;
+
     Renderer::setRenderMode(RENDER_MODE_3D);
 
     glEnable(GL_ALPHA);
@@ -129,43 +234,133 @@ int main()
     // Send constants to the shader
     skyboxShader->bind();
 
+    frameJobs = new JobSystem(FRAME_WORKER_COUNT);
+    frameGraph = new TaskGraph();
+    buildFrameGraph(deltaTime, timePassed, nearPlane, farPlane);
+
     while ( !glfwWindowShouldClose(mainWindow)) {
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-        glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+        duration frameStart = system_clock::now().time_since_epoch();
+
+        frameGraph->execute(frameJobs);
+
+        if ( exportFrameTrace ) {
+            exportFrameTrace = false;
+            if ( frameGraph->exportTrace(FRAME_TRACE_PATH)) {
+                std::cout << "Frame trace written to " << FRAME_TRACE_PATH << ", critical path:" << std::endl;
+                for ( int task: frameGraph->getCriticalPath())
+                    std::cout << "  " << frameGraph->getTaskName(task) << " - "
+                              << frameGraph->getTaskDuration(task) * 1000.0 << "ms" << std::endl;
+            }
+        }
 
-        /** Skybox rendering */
-        skyboxShader->bind();
-        Renderer::resetMatrices();
-        Renderer::rotateX(glm::radians(player.pitch));
-        Renderer::rotateY(glm::radians(player.yaw));
-        Renderer::scale(SKYBOX_SIZE);
-        Renderer::computeMatrices(FOV, NEAR_PLANE, FAR_PLANE, (float) width, (float) height);
-        Renderer::updateFrustum(viewFrustum);
+        // Measured before swapping the buffers, so the time spent waiting for the vertical sync isn't included.
+        frameGovernor->update(worldRenderer, (float) duration_cast<microseconds>(
+                system_clock::now().time_since_epoch() - frameStart).count() / 1000000.0f);
+        RenderStats::endFrame();
 
-        // Send the uniforms to the shader
-        skyboxShader->uniformVec2("u_Resolution", (float) width, (float) height);
-        skyboxShader->uniformFloat("u_SunSize", World::sunSize);
-        skyboxShader->uniformFloat("u_SunIntensity", World::sunIntensity);
-        skyboxShader->uniformFloat("u_SunAmbient", World::sunAmbient);
-        skyboxShader->uniformVec3("u_SunPosition", World::sunPosition);
-        skyboxShader->uniformVec4("u_SunColor", World::sunColor);
-        skyboxShader->uniformFloat("u_FogDensity", World::fogDensity);
+        glfwSwapBuffers(mainWindow);
+        glfwPollEvents();
 
-        Renderer::pushMatrices(skyboxShader->getProgramId());
-        skybox->draw(deltaTime);
+        // Update delta time
+        lastTime = currentTime;
+        currentTime = system_clock::now().time_since_epoch();
+        deltaTime = (float) duration_cast<microseconds>(currentTime - lastTime).count() / 1000000.0f;
+        timePassed += deltaTime;
+    }
+    // Stops the world generation, and frees the chunk meshes, the atmosphere's
+    // textures and the shadow cascades while the context is still there
+    delete worldRenderer;
+    delete atmosphere;
+    delete shadowMap;
+    glfwDestroyWindow(mainWindow);
+    glfwTerminate();
+
+    world->save();
+
+    // Free up some memory
+    delete frameJobs;
+    delete frameGraph;
+    delete skybox;
+    delete frameGovernor;
+    delete shadowDepthShader;
+    delete instancedShader;
+    delete transmittanceShader;
+    delete skyViewShader;
+    delete skyboxShader;
+    delete worldShader;
+    delete world;
 
+    return 0;
+}
+
+/**
+ * Builds the task graph that is executed every frame.
+ * The order between the stages follows from the resources they use. Everything touching
+ * OpenGL or GLFW input runs on the main thread, the entity update runs on a frame worker,
+ * overlapping the sky and shadow passes.
+ */
+void buildFrameGraph(float &deltaTime, float &timePassed, float &nearPlane, float &farPlane)
+{
+    int entities = frameGraph->addResource("entities");
+    int cameraState = frameGraph->addResource("camera");
+    int gl = frameGraph->addResource("gl");
+
+    int input = frameGraph->addTask("input", [&deltaTime] {
+        glm::vec3 direction = glm::vec3(
+                ( glfwGetKey(mainWindow, GLFW_KEY_W) - glfwGetKey(mainWindow, GLFW_KEY_S)),
+                ( glfwGetKey(mainWindow, GLFW_KEY_SPACE) - glfwGetKey(mainWindow, GLFW_KEY_LEFT_SHIFT)),
+                ( glfwGetKey(mainWindow, GLFW_KEY_D) - glfwGetKey(mainWindow, GLFW_KEY_A))
+        );
+        player.applyInput(direction, deltaTime);
+    }, TASK_GRAPH_MAIN_THREAD);
+    frameGraph->writes(input, entities);
+
+    int cameraSetup = frameGraph->addTask("camera", [&nearPlane, &farPlane] {
+        camera = player;
         Renderer::resetMatrices();
-        Renderer::translate(glm::vec4(player.position, 1.0f));
-        Renderer::rotate(glm::vec4(glm::radians(player.pitch), glm::radians(player.yaw), 0.0, 0.0));
+        Renderer::translate(glm::vec4(camera.position, 1.0f));
+        Renderer::rotate(glm::vec4(glm::radians(camera.pitch), glm::radians(camera.yaw), 0.0, 0.0));
 
-        /** World rendering section */
+        Renderer::computeMatrices(FOV, nearPlane, farPlane, (float) width, (float) height);
+        Renderer::updateFrustum(viewFrustum);
+    }, TASK_GRAPH_MAIN_THREAD);
+    frameGraph->reads(cameraSetup, entities);
+    frameGraph->writes(cameraSetup, cameraState);
+
+    int update = frameGraph->addTask("update", [&deltaTime] {
+        world->update(deltaTime);
+    }, TASK_GRAPH_ANY_THREAD);
+    frameGraph->writes(update, entities);
+
+    int clear = frameGraph->addTask("clear", [] {
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+    }, TASK_GRAPH_MAIN_THREAD);
+    frameGraph->writes(clear, gl);
+
+    // Refresh the sky LUTs, this only does work when the sun has moved.
+    int sky = frameGraph->addTask("atmosphere", [] {
+        atmosphere->update(World::sunPosition);
+    }, TASK_GRAPH_MAIN_THREAD);
+    frameGraph->writes(sky, gl);
+
+    // Re-render the shadow cascades that are out of date
+    int shadows = frameGraph->addTask("shadows", [] {
+        shadowMap->update(worldRenderer, Renderer::getViewMatrix(), Renderer::getModelMatrix(),
+                          FOV, (float) width / (float) height, World::sunPosition);
+    }, TASK_GRAPH_MAIN_THREAD);
+    frameGraph->reads(shadows, cameraState);
+    frameGraph->writes(shadows, gl);
+
+    /** World rendering section, the drawables of the world read the entities */
+    int worldRendering = frameGraph->addTask("world", [&deltaTime, &timePassed] {
         worldShader->bind();
-        Renderer::computeMatrices(FOV, NEAR_PLANE, FAR_PLANE, (float) width, (float) height);
         Renderer::pushMatrices(worldShader->getProgramId());
+        shadowMap->bind(worldShader);
 
         // Provide camera position to shader
         worldShader->uniformVec3("u_SunPosition", sunPosition.x, sunPosition.y, sunPosition.z);
-        worldShader->uniformVec3("u_CameraPosition", player.position.x, player.position.y, player.position.z);
+        worldShader->uniformVec3("u_CameraPosition", camera.position.x, camera.position.y, camera.position.z);
         worldShader->uniformFloat("u_time", timePassed);
 
         worldShader->uniformFloat("u_SunIntensity", World::sunIntensity);
@@ -174,28 +369,52 @@ int main()
         worldShader->uniformVec4("u_SunColor", World::sunColor);
         worldShader->uniformFloat("u_FogDensity", World::fogDensity);
 
-        world->render(deltaTime, viewFrustum);
-        world->update(deltaTime);
-
-        glfwSwapBuffers(mainWindow);
-        glfwPollEvents();
+        worldRenderer->render(deltaTime, viewFrustum);
+    }, TASK_GRAPH_MAIN_THREAD);
+    frameGraph->reads(worldRendering, cameraState);
+    frameGraph->reads(worldRendering, entities);
+    frameGraph->writes(worldRendering, gl);
+
+    /** Instanced rendering section, draws everything that was submitted while rendering the world */
+    int instanced = frameGraph->addTask("instanced", [] {
+        instancedShader->bind();
+        Renderer::pushMatrices(instancedShader->getProgramId());
+        instancedShader->uniformVec3("u_CameraPosition", camera.position);
+        sendStandardShaderUniforms(*instancedShader);
+        shadowMap->bind(instancedShader);
+        worldRenderer->instancedRenderer->flush();
+    }, TASK_GRAPH_MAIN_THREAD);
+    frameGraph->reads(instanced, cameraState);
+    frameGraph->writes(instanced, gl);
+
+    /**
+     * Skybox rendering.
+     * This is drawn last, so the depth test rejects all pixels that are covered by terrain.
+     */
+    int skyboxRendering = frameGraph->addTask("skybox", [&deltaTime, &nearPlane, &farPlane] {
+        skyboxShader->bind();
+        Renderer::resetMatrices();
+        Renderer::rotateX(glm::radians(camera.pitch));
+        Renderer::rotateY(glm::radians(camera.yaw));
+        Renderer::scale(SKYBOX_SIZE);
+        Renderer::computeMatrices(FOV, nearPlane, farPlane, (float) width, (float) height);
 
-        // Update delta time
-        lastTime = currentTime;
-        currentTime = system_clock::now().time_since_epoch();
-        deltaTime = (float) duration_cast<microseconds>(currentTime - lastTime).count() / 1000000.0f;
-        timePassed += deltaTime;
-    }
-    glfwDestroyWindow(mainWindow);
-    glfwTerminate();
+        // Send the uniforms to the shader
+        skyboxShader->uniformFloat("u_SunSize", World::sunSize);
+        skyboxShader->uniformFloat("u_SunIntensity", World::sunIntensity);
+        skyboxShader->uniformVec3("u_SunPosition", World::sunPosition);
+        skyboxShader->uniformVec4("u_SunColor", World::sunColor);
+        atmosphere->bind(skyboxShader);
 
-    // Free up some memory
-    delete skybox;
-    delete skyboxShader;
-    delete worldShader;
-    delete world;
+        Renderer::pushMatrices(skyboxShader->getProgramId());
+        glDepthMask(GL_FALSE);
+        skybox->draw(deltaTime);
+        glDepthMask(GL_TRUE);
+    }, TASK_GRAPH_MAIN_THREAD);
+    frameGraph->reads(skyboxRendering, cameraState);
+    frameGraph->writes(skyboxRendering, gl);
 
-    return 0;
+    frameGraph->compile();
 }
 
 /**
@@ -255,6 +474,23 @@ void keyCallback(GLFWwindow *window, int key, int scancode, int action, int mods
                 wireframe = !wireframe;
                 glPolygonMode(GL_FRONT_AND_BACK, wireframe ? GL_LINE : GL_FILL);
                 break;
+            case GLFW_KEY_T:
+                exportFrameTrace = true;
+                break;
+            case GLFW_KEY_P:
+                RenderStats::log(std::cout);
+                break;
+            // Terrain editing around the player
+            case GLFW_KEY_R:
+                world->raiseTerrain(player.position.x, player.position.z, TERRAIN_BRUSH_RADIUS, TERRAIN_BRUSH_STRENGTH);
+                break;
+            case GLFW_KEY_F:
+                world->lowerTerrain(player.position.x, player.position.z, TERRAIN_BRUSH_RADIUS, TERRAIN_BRUSH_STRENGTH);
+                break;
+            case GLFW_KEY_G:
+                world->flattenTerrain(player.position.x, player.position.z, TERRAIN_BRUSH_RADIUS,
+                                      world->getHeightAt(player.position.x, player.position.z));
+                break;
             default:
                 break;
         }
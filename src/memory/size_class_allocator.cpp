@@ -0,0 +1,53 @@
+//
+// Created by Luca Warmenhoven on 17/10/2026.
+//
+
+#include "size_class_allocator.h"
+#include "slab_pool.h"
+#include <new>
+
+/**
+ * Get the size class of an allocation, or -1 when it's too large for the pools.
+ */
+static int getSizeClass(size_t size)
+{
+    int sizeClass = 0;
+    size_t classSize = SIZE_CLASS_MIN_SIZE;
+    while ( classSize < size ) {
+        classSize <<= 1;
+        sizeClass++;
+    }
+    return sizeClass < SIZE_CLASS_COUNT ? sizeClass : -1;
+}
+
+static SlabPool *getPool(int sizeClass)
+{
+    // Created on first use, and never destroyed, as coroutine frames can outlive static destruction
+    static SlabPool **pools = [] {
+        auto **created = new SlabPool *[SIZE_CLASS_COUNT];
+        for ( int i = 0; i < SIZE_CLASS_COUNT; i++ )
+            created[ i ] = new SlabPool((size_t) SIZE_CLASS_MIN_SIZE << i, SIZE_CLASS_BLOCKS_PER_SLAB, false);
+        return created;
+    }();
+    return pools[ sizeClass ];
+}
+
+void *SizeClassAllocator::allocate(size_t size)
+{
+    int sizeClass = getSizeClass(size);
+    if ( sizeClass < 0 )
+        return ::operator new(size);
+    return getPool(sizeClass)->allocate();
+}
+
+void SizeClassAllocator::release(void *memory, size_t size)
+{
+    if ( !memory )
+        return;
+
+    int sizeClass = getSizeClass(size);
+    if ( sizeClass < 0 )
+        ::operator delete(memory);
+    else
+        getPool(sizeClass)->release(memory);
+}
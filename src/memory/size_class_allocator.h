@@ -0,0 +1,31 @@
+//
+// Created by Luca Warmenhoven on 17/10/2026.
+//
+
+#ifndef GRAPHICS_TEST_SIZE_CLASS_ALLOCATOR_H
+#define GRAPHICS_TEST_SIZE_CLASS_ALLOCATOR_H
+
+#include <cstddef>
+
+#define SIZE_CLASS_MIN_SIZE (64)
+#define SIZE_CLASS_COUNT (10) // Power of two classes from 64 bytes up to and including 32 KB
+#define SIZE_CLASS_BLOCKS_PER_SLAB (64)
+
+/**
+ * Allocator for variably sized, short or medium lived allocations, such as coroutine frames
+ * and the vegetation of chunks. Sizes are rounded up to a power of two and served
+ * from a SlabPool per size class. Larger allocations go to the general purpose heap.
+ */
+class SizeClassAllocator
+{
+public:
+
+    static void *allocate(size_t size);
+
+    /**
+     * Releases an allocation. The size has to be the same as the one it was allocated with.
+     */
+    static void release(void *memory, size_t size);
+};
+
+#endif //GRAPHICS_TEST_SIZE_CLASS_ALLOCATOR_H
@@ -0,0 +1,108 @@
+//
+// Created by Luca Warmenhoven on 17/10/2026.
+//
+
+#include "slab_pool.h"
+#include <sys/mman.h>
+#include <algorithm>
+#include <new>
+
+#ifdef __APPLE__
+#include <mach/vm_statistics.h>
+#endif
+
+/**
+ * Maps a slab of memory, trying huge pages first when requested.
+ */
+static void *mapSlab(size_t size, bool hugePages)
+{
+    void *memory = MAP_FAILED;
+    if ( hugePages ) {
+#if defined(__linux__) && defined(MAP_HUGETLB)
+        memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+#elif defined(__APPLE__) && defined(VM_FLAGS_SUPERPAGE_SIZE_2MB)
+        memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS,
+                      VM_FLAGS_SUPERPAGE_SIZE_2MB, 0);
+#endif
+    }
+
+    // Fall back to regular pages when no huge pages are reserved
+    if ( memory == MAP_FAILED ) {
+        memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+        if ( hugePages && memory != MAP_FAILED )
+            madvise(memory, size, MADV_HUGEPAGE);
+#endif
+    }
+    return memory == MAP_FAILED ? nullptr : memory;
+}
+
+SlabPool::SlabPool(size_t blockSize, size_t blocksPerSlab, bool hugePages)
+{
+    this->blockSize = ( std::max(blockSize, sizeof(void *)) + SLAB_POOL_ALIGNMENT - 1 ) &
+                      ~(size_t) ( SLAB_POOL_ALIGNMENT - 1 );
+    this->hugePages = hugePages;
+    this->freeList = nullptr;
+    this->allocatedCount = 0;
+
+    // Round the slabs up to whole (huge) pages, and use the remainder for extra blocks
+    size_t pageSize = hugePages ? SLAB_POOL_HUGE_PAGE_SIZE : 4096;
+    this->slabSize = ( this->blockSize * std::max(blocksPerSlab, (size_t) 1) + pageSize - 1 ) & ~( pageSize - 1 );
+    this->blocksPerSlab = this->slabSize / this->blockSize;
+}
+
+SlabPool::~SlabPool()
+{
+    for ( void *slab: this->slabs )
+        munmap(slab, this->slabSize);
+}
+
+void SlabPool::grow()
+{
+    auto *slab = (char *) mapSlab(this->slabSize, this->hugePages);
+    if ( !slab )
+        throw std::bad_alloc();
+    this->slabs.push_back(slab);
+
+    // Thread the new blocks onto the free list, in address order
+    for ( size_t i = this->blocksPerSlab; i-- > 0; ) {
+        void *block = slab + i * this->blockSize;
+        *(void **) block = this->freeList;
+        this->freeList = block;
+    }
+}
+
+void *SlabPool::allocate()
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+    if ( !this->freeList )
+        this->grow();
+
+    void *block = this->freeList;
+    this->freeList = *(void **) block;
+    this->allocatedCount++;
+    return block;
+}
+
+void SlabPool::release(void *block)
+{
+    if ( !block )
+        return;
+
+    std::lock_guard<std::mutex> lock(this->mutex);
+    *(void **) block = this->freeList;
+    this->freeList = block;
+    this->allocatedCount--;
+}
+
+size_t SlabPool::getAllocatedCount()
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+    return this->allocatedCount;
+}
+
+size_t SlabPool::getCapacity()
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+    return this->slabs.size() * this->blocksPerSlab;
+}
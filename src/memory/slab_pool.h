@@ -0,0 +1,74 @@
+//
+// Created by Luca Warmenhoven on 17/10/2026.
+//
+
+#ifndef GRAPHICS_TEST_SLAB_POOL_H
+#define GRAPHICS_TEST_SLAB_POOL_H
+
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+#define SLAB_POOL_ALIGNMENT (64) // Blocks are aligned to cache lines, so blocks used by different threads don't share one
+#define SLAB_POOL_HUGE_PAGE_SIZE (2 * 1024 * 1024)
+
+/**
+ * Pool of fixed-size memory blocks, allocated from the OS in large slabs.
+ *
+ * Released blocks are kept in a free list and handed out again, the slabs are only
+ * returned to the OS when the pool is destroyed. This keeps allocations that are
+ * made and freed at a high rate, such as those of streamed chunks, off the general purpose heap.
+ * The pool is safe to use from multiple threads.
+ */
+class SlabPool
+{
+
+private:
+
+    size_t blockSize;
+    size_t blocksPerSlab;
+    size_t slabSize;
+    bool hugePages;
+
+    std::vector<void *> slabs;
+
+    /** Released blocks, linked through their first bytes */
+    void *freeList;
+    size_t allocatedCount;
+
+    std::mutex mutex;
+
+    void grow();
+
+public:
+
+    /**
+     * @param blockSize The size of every block, rounded up to SLAB_POOL_ALIGNMENT
+     * @param blocksPerSlab The minimum amount of blocks that is allocated from the OS at once
+     * @param hugePages Whether to back the slabs by huge pages, when the OS provides them
+     */
+    SlabPool(size_t blockSize, size_t blocksPerSlab, bool hugePages);
+
+    ~SlabPool();
+
+    void *allocate();
+
+    /**
+     * Returns a block to the pool. The block must have been allocated by this pool.
+     */
+    void release(void *block);
+
+    size_t getBlockSize() const { return blockSize; }
+
+    /**
+     * Get the amount of blocks that are currently handed out.
+     */
+    size_t getAllocatedCount();
+
+    /**
+     * Get the amount of blocks the pool can hand out without allocating another slab.
+     */
+    size_t getCapacity();
+};
+
+#endif //GRAPHICS_TEST_SLAB_POOL_H
@@ -0,0 +1,173 @@
+//
+// Created by Luca Warmenhoven on 17/10/2026.
+//
+
+#include "chunk_client.h"
+#include "../world/height_map_codec.h"
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <csignal>
+#include <cstring>
+#include <iostream>
+#include <vector>
+#include <algorithm>
+
+ChunkClient::ChunkClient(const char *socketPath, int chunkSize, uint32_t seed)
+{
+    this->chunkSize = chunkSize;
+    this->seed = seed;
+
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    strncpy(address.sun_path, socketPath, sizeof(address.sun_path) - 1);
+
+    this->connection = socket(AF_UNIX, SOCK_STREAM, 0);
+    if ( this->connection < 0 || connect(this->connection, (sockaddr *) &address, sizeof(address)) != 0 ) {
+        std::cerr << "Failed to connect to the chunk server at " << socketPath << ": " << strerror(errno)
+                  << ", chunks are generated locally." << std::endl;
+        if ( this->connection >= 0 )
+            close(this->connection);
+        this->connection = -1;
+        return;
+    }
+
+    // A server that goes away while a batch is sent shouldn't stop the client
+    signal(SIGPIPE, SIG_IGN);
+    this->connected = true;
+    this->running = true;
+    this->connectionThread = new std::thread(&ChunkClient::connectionFn, this);
+}
+
+ChunkClient::~ChunkClient()
+{
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->running = false;
+    }
+    this->condition.notify_all();
+    if ( this->connectionThread ) {
+        this->connectionThread->join();
+        delete this->connectionThread;
+    }
+    if ( this->connection >= 0 )
+        close(this->connection);
+}
+
+bool ChunkClient::isConnected() const
+{
+    return this->connected;
+}
+
+bool ChunkClient::fetch(int32_t x, int32_t z, uint16_t *quantized, float &minimum, float &scale)
+{
+    glm::ivec2 chunk(x, z);
+    chunk_fetch_result_t result = { quantized, 0, 0, false };
+    this->fetch(&chunk, 1, &result);
+    minimum = result.minimum;
+    scale = result.scale;
+    return result.fetched;
+}
+
+size_t ChunkClient::fetch(const glm::ivec2 *chunks, size_t count, chunk_fetch_result_t *results)
+{
+    // Only referenced by the connection thread while this thread waits for them
+    static thread_local std::vector<chunk_fetch_t> fetches;
+    fetches.resize(count);
+    for ( size_t i = 0; i < count; i++ ) {
+        fetches[ i ] = { chunks[ i ].x, chunks[ i ].y, results[ i ].quantized, 0, 0, false, false };
+        results[ i ].fetched = false;
+    }
+    {
+        std::unique_lock<std::mutex> lock(this->mutex);
+        if ( count == 0 || !this->connected || !this->running )
+            return 0;
+        for ( chunk_fetch_t &fetch: fetches )
+            this->queue.push_back(&fetch);
+        this->condition.notify_all();
+        this->condition.wait(lock, [] {
+            return std::all_of(fetches.begin(), fetches.end(), [](const chunk_fetch_t &fetch) { return fetch.done; });
+        });
+    }
+
+    size_t fetched = 0;
+    for ( size_t i = 0; i < count; i++ ) {
+        results[ i ].minimum = fetches[ i ].minimum;
+        results[ i ].scale = fetches[ i ].scale;
+        results[ i ].fetched = fetches[ i ].found;
+        fetched += fetches[ i ].found ? 1 : 0;
+    }
+    return fetched;
+}
+
+/*
+ * Sends the queued fetches in batches, and hands out the answers.
+ * The fetches that queue up while a batch is in flight form the next batch.
+ */
+void ChunkClient::connectionFn()
+{
+    std::vector<chunk_fetch_t *> batch;
+    std::vector<uint8_t> encoded;
+    chunk_request_t requests[ CHUNK_PROTOCOL_MAX_BATCH ];
+
+    std::unique_lock<std::mutex> lock(this->mutex);
+    while ( true ) {
+        this->condition.wait(lock, [this] { return !this->queue.empty() || !this->running; });
+        if ( !this->running || !this->connected )
+            break;
+
+        batch.clear();
+        while ( !this->queue.empty() && batch.size() < CHUNK_PROTOCOL_MAX_BATCH ) {
+            batch.push_back(this->queue.front());
+            this->queue.pop_front();
+        }
+        lock.unlock();
+
+        chunk_request_header_t header = { CHUNK_PROTOCOL_MAGIC, CHUNK_PROTOCOL_VERSION,
+                                          (uint32_t) this->chunkSize, this->seed, (uint32_t) batch.size() };
+        for ( size_t i = 0; i < batch.size(); i++ )
+            requests[ i ] = { batch[ i ]->x, batch[ i ]->z };
+        chunk_response_header_t responseHeader;
+        bool succeeded = writeFully(this->connection, &header, sizeof(header)) &&
+                         writeFully(this->connection, requests, sizeof(chunk_request_t) * batch.size()) &&
+                         readFully(this->connection, &responseHeader, sizeof(responseHeader)) &&
+                         responseHeader.magic == CHUNK_PROTOCOL_MAGIC && responseHeader.count == batch.size();
+
+        // The answers arrive in the order of the requests
+        for ( size_t i = 0; i < batch.size() && succeeded; i++ ) {
+            chunk_response_t response;
+            succeeded = readFully(this->connection, &response, sizeof(response)) &&
+                        response.x == batch[ i ]->x && response.z == batch[ i ]->z &&
+                        response.encoded_size <= CHUNK_PROTOCOL_MAX_ENCODED_SIZE;
+            if ( !succeeded )
+                break;
+            encoded.resize(response.encoded_size);
+            succeeded = readFully(this->connection, encoded.data(), encoded.size());
+            if ( !succeeded )
+                break;
+
+            // A chunk that doesn't decode is generated locally, the following answers are still intact
+            if ( !HeightMapCodec::decode(encoded.data(), encoded.size(), this->chunkSize * this->chunkSize,
+                                         this->chunkSize, batch[ i ]->quantized))
+                continue;
+            batch[ i ]->minimum = response.minimum;
+            batch[ i ]->scale = response.scale;
+            batch[ i ]->found = true;
+        }
+
+        lock.lock();
+        if ( !succeeded ) {
+            std::cerr << "Lost the connection to the chunk server, chunks are generated locally." << std::endl;
+            this->connected = false;
+        }
+        for ( chunk_fetch_t *fetch: batch )
+            fetch->done = true;
+        this->condition.notify_all();
+    }
+
+    // Nothing is sent anymore, let the waiting fetches fail
+    for ( chunk_fetch_t *fetch: this->queue )
+        fetch->done = true;
+    this->queue.clear();
+    this->condition.notify_all();
+}
@@ -0,0 +1,101 @@
+//
+// Created by Luca Warmenhoven on 17/10/2026.
+//
+
+#ifndef GRAPHICS_TEST_CHUNK_CLIENT_H
+#define GRAPHICS_TEST_CHUNK_CLIENT_H
+
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <string>
+#include <condition_variable>
+#include <glm/glm.hpp>
+#include "chunk_protocol.h"
+
+/**
+ * A chunk that's waiting to be fetched from the chunk server.
+ */
+typedef struct {
+    int32_t x;
+    int32_t z;
+    uint16_t *quantized;
+    float minimum;
+    float scale;
+    bool done;
+    bool found;
+} chunk_fetch_t;
+
+/**
+ * The answer for a chunk of a batched fetch, see ChunkClient::fetch.
+ */
+typedef struct {
+    uint16_t *quantized; // The destination of the height map, set by the caller
+    float minimum;
+    float scale;
+    bool fetched;
+} chunk_fetch_result_t;
+
+/**
+ * Fetches the height maps of chunks from a ChunkServer.
+ *
+ * The fetches of all threads are collected by a single connection thread, which sends them
+ * to the server in batches of up to CHUNK_PROTOCOL_MAX_BATCH chunks. When the connection is lost
+ * every fetch fails, so the caller can generate the chunk itself instead.
+ */
+class ChunkClient
+{
+
+private:
+
+    int connection = -1;
+    int chunkSize;
+    uint32_t seed;
+    std::thread *connectionThread = nullptr;
+
+    /** The fetches that haven't been sent yet, guarded by mutex */
+    std::deque<chunk_fetch_t *> queue;
+    std::mutex mutex;
+    std::condition_variable condition;
+    bool running = false;
+    std::atomic<bool> connected = false;
+
+    void connectionFn();
+
+public:
+
+    /**
+     * Connects to the chunk server listening on the provided socket.
+     * @param chunkSize The amount of height map samples along each side of a chunk
+     * @param seed The seed of the terrain, a server generating another terrain refuses the requests
+     */
+    ChunkClient(const char *socketPath, int chunkSize, uint32_t seed);
+
+    ~ChunkClient();
+
+    bool isConnected() const;
+
+    /**
+     * Fetches the quantized height map of a chunk, blocking until the batch it was sent in is answered.
+     * Safe to call from any thread.
+     *
+     * @param x The x coordinate of the chunk, in height map cells
+     * @param z The z coordinate of the chunk, in height map cells
+     * @return Whether the chunk was fetched
+     */
+    bool fetch(int32_t x, int32_t z, uint16_t *quantized, float &minimum, float &scale);
+
+    /**
+     * Fetches the quantized height maps of several chunks, blocking until all of them are answered.
+     * The chunks are queued together, so they're sent in as few batches as possible.
+     * Safe to call from any thread.
+     *
+     * @param chunks The coordinates of the chunks, in height map cells
+     * @param results The answer for every chunk, where `quantized` has to be set beforehand
+     * @return The amount of chunks that were fetched
+     */
+    size_t fetch(const glm::ivec2 *chunks, size_t count, chunk_fetch_result_t *results);
+};
+
+#endif //GRAPHICS_TEST_CHUNK_CLIENT_H
@@ -0,0 +1,37 @@
+//
+// Created by Luca Warmenhoven on 17/10/2026.
+//
+
+#include "chunk_protocol.h"
+#include <unistd.h>
+#include <cerrno>
+
+bool readFully(int socket, void *data, size_t size)
+{
+    auto *bytes = (uint8_t *) data;
+    while ( size > 0 ) {
+        ssize_t count = read(socket, bytes, size);
+        if ( count < 0 && errno == EINTR )
+            continue;
+        if ( count <= 0 )
+            return false;
+        bytes += count;
+        size -= count;
+    }
+    return true;
+}
+
+bool writeFully(int socket, const void *data, size_t size)
+{
+    auto *bytes = (const uint8_t *) data;
+    while ( size > 0 ) {
+        ssize_t count = write(socket, bytes, size);
+        if ( count < 0 && errno == EINTR )
+            continue;
+        if ( count <= 0 )
+            return false;
+        bytes += count;
+        size -= count;
+    }
+    return true;
+}
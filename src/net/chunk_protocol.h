@@ -0,0 +1,64 @@
+//
+// Created by Luca Warmenhoven on 17/10/2026.
+//
+
+#ifndef GRAPHICS_TEST_CHUNK_PROTOCOL_H
+#define GRAPHICS_TEST_CHUNK_PROTOCOL_H
+
+#include <cstdint>
+#include <cstddef>
+
+/*
+ * The protocol between the chunk server and its clients, over a stream socket.
+ *
+ * A client sends a batch of requests: a chunk_request_header_t followed by `count` chunk_request_t.
+ * The server answers with a chunk_response_header_t, followed by a chunk_response_t for every
+ * requested chunk in the same order, each followed by the HeightMapCodec encoding of its height map.
+ */
+
+#define CHUNK_PROTOCOL_MAGIC (0x43485447) // "GTHC"
+#define CHUNK_PROTOCOL_VERSION (2)
+#define CHUNK_PROTOCOL_MAX_BATCH (64)
+#define CHUNK_PROTOCOL_MAX_ENCODED_SIZE (1 << 20)
+
+#define CHUNK_SERVER_SOCKET_PATH "/tmp/graphics-test-chunks.sock"
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t chunk_size; // Has to match between the server and the client
+    uint32_t seed;       // The seed of the terrain, see TerrainGenerator::setSeed. Has to match as well
+    uint32_t count;
+} chunk_request_header_t;
+
+typedef struct {
+    int32_t x; // In height map cells
+    int32_t z;
+} chunk_request_t;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t count;
+} chunk_response_header_t;
+
+typedef struct {
+    int32_t x;
+    int32_t z;
+    float minimum; // The quantization of the height map, see HeightMapCodec
+    float scale;
+    uint32_t encoded_size;
+} chunk_response_t;
+
+/**
+ * Reads exactly `size` bytes from a socket, retrying on partial reads.
+ * @return Whether all bytes were read before the connection closed or failed
+ */
+bool readFully(int socket, void *data, size_t size);
+
+/**
+ * Writes exactly `size` bytes to a socket, retrying on partial writes.
+ * @return Whether all bytes were written
+ */
+bool writeFully(int socket, const void *data, size_t size);
+
+#endif //GRAPHICS_TEST_CHUNK_PROTOCOL_H
@@ -0,0 +1,186 @@
+//
+// Created by Luca Warmenhoven on 17/10/2026.
+//
+
+#include "chunk_server.h"
+#include "../world/world.h"
+#include "../world/terrain_generator.h"
+#include "../world/height_map_codec.h"
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <csignal>
+#include <cstring>
+#include <iostream>
+#include <condition_variable>
+
+static uint64_t chunk_key(int32_t x, int32_t z)
+{
+    return ((uint64_t) (uint32_t) x << 32 ) | (uint32_t) z;
+}
+
+ChunkServer::ChunkServer(const char *socketPath, uint32_t seed, int workerCount, size_t cacheCapacity)
+{
+    this->socketPath = socketPath;
+    this->seed = seed;
+    this->cacheCapacity = cacheCapacity;
+    this->jobs = new JobSystem(workerCount);
+}
+
+ChunkServer::~ChunkServer()
+{
+    delete this->jobs;
+}
+
+bool ChunkServer::lookup(int32_t x, int32_t z, chunk_server_entry_t &entry)
+{
+    std::lock_guard<std::mutex> lock(this->cacheMutex);
+    auto cached = this->cacheEntries.find(chunk_key(x, z));
+    if ( cached == this->cacheEntries.end())
+        return false;
+
+    this->cache.splice(this->cache.begin(), this->cache, cached->second);
+    entry = *cached->second;
+    return true;
+}
+
+void ChunkServer::insert(const chunk_server_entry_t &entry)
+{
+    uint64_t key = chunk_key(entry.header.x, entry.header.z);
+    std::lock_guard<std::mutex> lock(this->cacheMutex);
+
+    // Another client might have requested the same chunk in the meantime
+    if ( this->cacheEntries.find(key) != this->cacheEntries.end())
+        return;
+
+    this->cache.push_front(entry);
+    this->cacheEntries[ key ] = this->cache.begin();
+    if ( this->cache.size() > this->cacheCapacity ) {
+        chunk_server_entry_t &last = this->cache.back();
+        this->cacheEntries.erase(chunk_key(last.header.x, last.header.z));
+        this->cache.pop_back();
+    }
+}
+
+/**
+ * Generates the height map of a chunk, the same samples World::generateChunk stores in the chunk.
+ */
+void ChunkServer::generate(int32_t x, int32_t z, chunk_server_entry_t &entry)
+{
+    float heights[ CHUNK_SIZE * CHUNK_SIZE ];
+    uint16_t quantized[ CHUNK_SIZE * CHUNK_SIZE ];
+
+    TerrainGenerator::getChunkHeights(x, z, heights);
+    entry.header.x = x;
+    entry.header.z = z;
+    HeightMapCodec::quantize(heights, CHUNK_SIZE * CHUNK_SIZE, quantized, entry.header.minimum, entry.header.scale);
+    HeightMapCodec::encode(quantized, CHUNK_SIZE * CHUNK_SIZE, CHUNK_SIZE, entry.encoded);
+    entry.header.encoded_size = (uint32_t) entry.encoded.size();
+}
+
+void ChunkServer::serveClient(int client)
+{
+    chunk_request_header_t header;
+    chunk_request_t requests[ CHUNK_PROTOCOL_MAX_BATCH ];
+    std::vector<chunk_server_entry_t> entries;
+
+    while ( readFully(client, &header, sizeof(header))) {
+        if ( header.magic != CHUNK_PROTOCOL_MAGIC || header.version != CHUNK_PROTOCOL_VERSION ||
+             header.chunk_size != CHUNK_SIZE || header.count > CHUNK_PROTOCOL_MAX_BATCH ) {
+            std::cerr << "Invalid chunk request, disconnecting the client." << std::endl;
+            break;
+        }
+        // The server only generates the terrain of its own seed, the client generates its chunks itself then
+        if ( header.seed != this->seed ) {
+            std::cerr << "Chunks requested for seed " << header.seed << ", but the server generates seed "
+                      << this->seed << ". Disconnecting the client." << std::endl;
+            break;
+        }
+        if ( !readFully(client, requests, sizeof(chunk_request_t) * header.count))
+            break;
+
+        // Serve what's cached, and generate the rest of the batch in parallel.
+        // The misses are counted before the first job is submitted, the jobs only ever decrement the count.
+        entries.resize(header.count);
+        uint32_t misses[ CHUNK_PROTOCOL_MAX_BATCH ];
+        uint32_t missCount = 0;
+        for ( uint32_t i = 0; i < header.count; i++ ) {
+            if ( this->lookup(requests[ i ].x, requests[ i ].z, entries[ i ] )) {
+                this->cacheHits++;
+                continue;
+            }
+            this->cacheMisses++;
+            misses[ missCount++ ] = i;
+        }
+
+        std::mutex batchMutex;
+        std::condition_variable batchCondition;
+        uint32_t remaining = missCount;
+        for ( uint32_t miss = 0; miss < missCount; miss++ ) {
+            uint32_t i = misses[ miss ];
+            this->jobs->submit([this, &entries, &requests, &batchMutex, &batchCondition, &remaining, i] {
+                generate(requests[ i ].x, requests[ i ].z, entries[ i ]);
+                this->insert(entries[ i ]);
+
+                std::lock_guard<std::mutex> lock(batchMutex);
+                if ( --remaining == 0 )
+                    batchCondition.notify_one();
+            });
+        }
+        {
+            std::unique_lock<std::mutex> lock(batchMutex);
+            batchCondition.wait(lock, [&remaining] { return remaining == 0; });
+        }
+
+        chunk_response_header_t responseHeader = { CHUNK_PROTOCOL_MAGIC, header.count };
+        bool written = writeFully(client, &responseHeader, sizeof(responseHeader));
+        for ( uint32_t i = 0; i < header.count && written; i++ )
+            written = writeFully(client, &entries[ i ].header, sizeof(chunk_response_t)) &&
+                      writeFully(client, entries[ i ].encoded.data(), entries[ i ].encoded.size());
+        if ( !written )
+            break;
+    }
+    close(client);
+    std::cout << "Chunk server client disconnected, " << this->cacheHits << " cache hits, "
+              << this->cacheMisses << " misses." << std::endl;
+}
+
+int ChunkServer::run()
+{
+    // Clients that disconnect while a response is written shouldn't stop the server
+    signal(SIGPIPE, SIG_IGN);
+    TerrainGenerator::setSeed(this->seed);
+
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    if ( this->socketPath.size() >= sizeof(address.sun_path)) {
+        std::cerr << "Chunk server socket path is too long: " << this->socketPath << std::endl;
+        return 1;
+    }
+    strncpy(address.sun_path, this->socketPath.c_str(), sizeof(address.sun_path) - 1);
+
+    int server = socket(AF_UNIX, SOCK_STREAM, 0);
+    unlink(this->socketPath.c_str());
+    if ( server < 0 || bind(server, (sockaddr *) &address, sizeof(address)) != 0 || listen(server, 16) != 0 ) {
+        std::cerr << "Failed to listen on " << this->socketPath << ": " << strerror(errno) << std::endl;
+        if ( server >= 0 )
+            close(server);
+        return 1;
+    }
+    std::cout << "Chunk server listening on " << this->socketPath << ", generating seed " << this->seed
+              << std::endl;
+
+    while ( true ) {
+        int client = accept(server, nullptr, nullptr);
+        if ( client < 0 ) {
+            if ( errno == EINTR )
+                continue;
+            std::cerr << "Failed to accept a chunk server client: " << strerror(errno) << std::endl;
+            break;
+        }
+        std::thread(&ChunkServer::serveClient, this, client).detach();
+    }
+    close(server);
+    unlink(this->socketPath.c_str());
+    return 1;
+}
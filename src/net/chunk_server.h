@@ -0,0 +1,84 @@
+//
+// Created by Luca Warmenhoven on 17/10/2026.
+//
+
+#ifndef GRAPHICS_TEST_CHUNK_SERVER_H
+#define GRAPHICS_TEST_CHUNK_SERVER_H
+
+#include <list>
+#include <mutex>
+#include <atomic>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include "chunk_protocol.h"
+#include "../threading/job_system.h"
+
+#define CHUNK_SERVER_WORKER_COUNT (4)
+#define CHUNK_SERVER_CACHE_CAPACITY (4096) // In chunks, about 3 KB each
+
+typedef struct {
+    chunk_response_t header;
+    std::vector<uint8_t> encoded;
+} chunk_server_entry_t;
+
+/**
+ * Headless server that generates the height maps of chunks on behalf of its clients,
+ * so clients exploring the same world don't all generate the same terrain.
+ *
+ * Every client connection is served by its own thread. The chunks of a request batch that
+ * aren't cached are generated in parallel by the workers, and kept in a least recently used cache.
+ */
+class ChunkServer
+{
+
+private:
+
+    std::string socketPath;
+    uint32_t seed;
+    JobSystem *jobs;
+
+    /** The encoded chunks, most recently used first */
+    std::list<chunk_server_entry_t> cache;
+    std::unordered_map<uint64_t, std::list<chunk_server_entry_t>::iterator> cacheEntries;
+    size_t cacheCapacity;
+    std::mutex cacheMutex;
+
+    std::atomic<unsigned long> cacheHits = 0;
+    std::atomic<unsigned long> cacheMisses = 0;
+
+    /**
+     * Copies a cached chunk into the provided entry, and marks it as most recently used.
+     */
+    bool lookup(int32_t x, int32_t z, chunk_server_entry_t &entry);
+
+    void insert(const chunk_server_entry_t &entry);
+
+    static void generate(int32_t x, int32_t z, chunk_server_entry_t &entry);
+
+    /**
+     * Answers the request batches of a client until it disconnects.
+     */
+    void serveClient(int client);
+
+public:
+
+    /**
+     * @param socketPath The path of the Unix domain socket to listen on
+     * @param seed The seed the terrain is generated with, requests for another seed are refused
+     * @param workerCount The amount of workers that generate chunks
+     * @param cacheCapacity The maximum amount of chunks kept in memory
+     */
+    ChunkServer(const char *socketPath, uint32_t seed, int workerCount, size_t cacheCapacity);
+
+    ~ChunkServer();
+
+    /**
+     * Accepts and serves clients until the process is stopped.
+     * Sets the seed of the TerrainGenerator, nothing else in the process should sample the terrain.
+     * @return The exit code of the process, non-zero when the socket couldn't be opened
+     */
+    int run();
+};
+
+#endif //GRAPHICS_TEST_CHUNK_SERVER_H
@@ -3,6 +3,7 @@
 //
 
 #include "frustum.h"
+#include <cstring>
 
 void Frustum::updateViewProjectionMatrix(glm::mat4 viewMatrix, glm::mat4 projectionMatrix)
 {
@@ -64,6 +65,33 @@ Frustum::Frustum(Transformation *source, glm::mat4 viewMatrix, glm::mat4 project
     this->updateViewProjectionMatrix(viewMatrix, projectionMatrix);
 }
 
+Frustum::Frustum(const Frustum &other)
+{
+    this->planes = (Plane *) malloc(FRUSTUM_PLANES * sizeof(Plane));
+    *this = other;
+}
+
+Frustum &Frustum::operator=(const Frustum &other)
+{
+    if ( this == &other )
+        return *this;
+
+    memcpy(this->planes, other.planes, FRUSTUM_PLANES * sizeof(Plane));
+    this->viewProjectionMatrix = other.viewProjectionMatrix;
+    this->sourceSnapshot = other.sourceSnapshot;
+
+    // A detached frustum has to keep pointing at its own snapshot
+    this->source = other.source == &other.sourceSnapshot ? &this->sourceSnapshot : other.source;
+    return *this;
+}
+
+void Frustum::detachSource()
+{
+    if ( this->source != &this->sourceSnapshot )
+        this->sourceSnapshot = *this->source;
+    this->source = &this->sourceSnapshot;
+}
+
 // Calculate the distance to a normal of a plane
 float Frustum::distanceToNormal(glm::vec3 normal, glm::vec3 point)
 {
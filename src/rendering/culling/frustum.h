@@ -28,6 +28,9 @@ private:
 
     float distanceToPlane(Plane *plane, glm::vec3 point);
 
+    /** Copy of the source, used after `detachSource` has been called */
+    Transformation sourceSnapshot;
+
 
 public:
 
@@ -43,6 +46,16 @@ public:
      */
     Frustum(Transformation *source, glm::mat4 viewMatrix, glm::mat4 projectionMatrix);
 
+    Frustum(const Frustum &other);
+
+    Frustum &operator=(const Frustum &other);
+
+    /**
+     * Replaces the source by a copy of its current state.
+     * This allows the frustum to be used on another thread while the source keeps moving.
+     */
+    void detachSource();
+
 
     /**
      * Function for updating the view and projection matrix of the frustum.
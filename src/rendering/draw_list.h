@@ -0,0 +1,62 @@
+//
+// Created by Luca Warmenhoven on 17/10/2026.
+//
+
+#ifndef GRAPHICS_TEST_DRAW_LIST_H
+#define GRAPHICS_TEST_DRAW_LIST_H
+
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+#include "vbo.h"
+#include "model/mesh.h"
+
+typedef struct {
+    int slot;
+    float x;
+    float z;
+} draw_list_heightmap_t;
+
+typedef struct {
+    Mesh *mesh;
+    glm::mat4 transform;
+} draw_list_instance_t;
+
+/**
+ * The draw calls of a single frame.
+ * Building a draw list doesn't touch OpenGL, so it can be done on any thread,
+ * after which the thread owning the context submits it.
+ */
+class DrawList
+{
+public:
+    /** The chunk meshes to draw */
+    std::vector<VBO *> meshes;
+
+    /** The chunks to submit to the height map terrain renderer */
+    std::vector<draw_list_heightmap_t> heightmapChunks;
+
+    /** The instances to submit to the instanced renderer */
+    std::vector<draw_list_instance_t> instances;
+
+    /** The position of the camera the list was built for */
+    glm::vec3 cameraPosition;
+
+    /** The amount of loaded chunks that made it into the list, and that were culled */
+    uint64_t chunksDrawn = 0;
+    uint64_t chunksCulled = 0;
+
+    /**
+     * Empties the list, keeping the allocated memory for the next frame.
+     */
+    void clear()
+    {
+        meshes.clear();
+        heightmapChunks.clear();
+        instances.clear();
+        chunksDrawn = 0;
+        chunksCulled = 0;
+    }
+};
+
+#endif //GRAPHICS_TEST_DRAW_LIST_H
@@ -0,0 +1,81 @@
+//
+// Created by Luca Warmenhoven on 17/10/2026.
+//
+
+#include "frame_governor.h"
+#include "world_renderer.h"
+
+#include <algorithm>
+
+FrameGovernor::FrameGovernor(float targetFrameTime)
+{
+    this->targetFrameTime = targetFrameTime;
+    this->sampleCount = 0;
+    this->level = INITIAL_LEVEL;
+    this->headroomWindows = 0;
+    this->improveDelay = FRAME_GOVERNOR_IMPROVE_DELAY;
+    this->justImproved = false;
+    this->percentileFrameTime = 0.0f;
+}
+
+void FrameGovernor::apply(WorldRenderer *renderer) const
+{
+    const frame_governor_level_t &settings = LEVELS[ this->level ];
+
+    // Leave one hardware thread for the render thread
+    int maxWorkers = std::max(1, (int) std::thread::hardware_concurrency() - 1);
+
+    renderer->world->drawDistance = settings.draw_distance;
+    renderer->lodBias = settings.lod_bias;
+    renderer->world->uploadBudget = settings.upload_budget;
+    renderer->world->setGenerationWorkerCount(std::min(settings.worker_count, maxWorkers));
+}
+
+void FrameGovernor::update(WorldRenderer *renderer, float frameTime)
+{
+    this->samples[ this->sampleCount++ ] = frameTime;
+    if ( this->sampleCount < FRAME_GOVERNOR_WINDOW )
+        return;
+
+    // Windows don't overlap, so every decision is based on frames rendered with the current settings.
+    this->sampleCount = 0;
+    int percentileIndex = (int) ( FRAME_GOVERNOR_PERCENTILE * ( FRAME_GOVERNOR_WINDOW - 1 ));
+    std::nth_element(this->samples, this->samples + percentileIndex, this->samples + FRAME_GOVERNOR_WINDOW);
+    this->percentileFrameTime = this->samples[ percentileIndex ];
+
+    bool improvedLastWindow = this->justImproved;
+    this->justImproved = false;
+
+    if ( this->percentileFrameTime > this->targetFrameTime * FRAME_GOVERNOR_DEGRADE_THRESHOLD ) {
+        this->headroomWindows = 0;
+        if ( this->level == 0 )
+            return;
+
+        // The previous raise couldn't be sustained, wait longer before trying again
+        if ( improvedLastWindow )
+            this->improveDelay = std::min(this->improveDelay * 2, FRAME_GOVERNOR_MAX_IMPROVE_DELAY);
+
+        this->level--;
+        this->apply(renderer);
+    } else if ( this->percentileFrameTime < this->targetFrameTime * FRAME_GOVERNOR_IMPROVE_THRESHOLD ) {
+        if ( ++this->headroomWindows < this->improveDelay || this->level == LEVEL_COUNT - 1 )
+            return;
+
+        this->headroomWindows = 0;
+        this->justImproved = true;
+        this->level++;
+        this->apply(renderer);
+    } else {
+        this->headroomWindows = 0;
+    }
+}
+
+int FrameGovernor::getLevel() const
+{
+    return this->level;
+}
+
+float FrameGovernor::getPercentileFrameTime() const
+{
+    return this->percentileFrameTime;
+}
@@ -0,0 +1,104 @@
+//
+// Created by Luca Warmenhoven on 17/10/2026.
+//
+
+#ifndef GRAPHICS_TEST_FRAME_GOVERNOR_H
+#define GRAPHICS_TEST_FRAME_GOVERNOR_H
+
+class WorldRenderer;
+
+// The amount of frames over which the frame time percentile is measured
+#define FRAME_GOVERNOR_WINDOW (120)
+#define FRAME_GOVERNOR_PERCENTILE (0.95f)
+
+// The quality is lowered when the percentile exceeds the target by this factor,
+// and raised when it stays below the target by this factor.
+#define FRAME_GOVERNOR_DEGRADE_THRESHOLD (1.1f)
+#define FRAME_GOVERNOR_IMPROVE_THRESHOLD (0.7f)
+
+// The amount of consecutive windows with headroom before the quality is raised.
+// Doubled every time a raise has to be reverted right away, up to the maximum.
+#define FRAME_GOVERNOR_IMPROVE_DELAY (3)
+#define FRAME_GOVERNOR_MAX_IMPROVE_DELAY (32)
+
+/**
+ * The settings of a single quality level.
+ */
+typedef struct {
+    int draw_distance;  // In chunks
+    float lod_bias;     // Multiplier for the maximum error of the adaptive mesher
+    int upload_budget;  // Chunks uploaded to the GPU per frame
+    int worker_count;   // Chunk generation workers
+} frame_governor_level_t;
+
+/**
+ * Adjusts the quality settings of the world to hold a target frame time.
+ *
+ * The frame times are collected in windows of FRAME_GOVERNOR_WINDOW frames.
+ * At the end of every window the percentile frame time is compared to the target,
+ * and the quality is moved one level down or up. The thresholds are asymmetric and
+ * raising the quality requires multiple windows with headroom, so the governor
+ * doesn't oscillate between two levels.
+ */
+class FrameGovernor
+{
+
+private:
+
+    float targetFrameTime;
+
+    float samples[FRAME_GOVERNOR_WINDOW];
+    int sampleCount;
+
+    int level;
+    int headroomWindows;
+    int improveDelay;
+
+    /** Whether the level was raised at the end of the previous window */
+    bool justImproved;
+
+    float percentileFrameTime;
+
+    void apply(WorldRenderer *renderer) const;
+
+public:
+
+    /**
+     * The quality levels, from lowest to highest.
+     */
+    static constexpr frame_governor_level_t LEVELS[] = {
+            { 6,  3.0f,  1, 1 },
+            { 8,  2.0f,  1, 1 },
+            { 10, 1.5f,  1, 2 },
+            { 12, 1.25f, 2, 2 },
+            { 15, 1.0f,  2, 2 }, // Matches the initial settings of the world
+            { 18, 0.75f, 3, 3 },
+            { 22, 0.5f,  4, 4 },
+    };
+    static constexpr int LEVEL_COUNT = sizeof(LEVELS) / sizeof(LEVELS[0]);
+    static constexpr int INITIAL_LEVEL = 4;
+
+    /**
+     * @param targetFrameTime The frame time to hold, in seconds.
+     */
+    explicit FrameGovernor(float targetFrameTime);
+
+    /**
+     * Records the time of a frame, and adjusts the settings of the world
+     * at the end of every window.
+     *
+     * @param frameTime The time spent on the frame, in seconds. This should exclude
+     *                  the time spent waiting for the vertical sync, otherwise there's
+     *                  never any headroom.
+     */
+    void update(WorldRenderer *renderer, float frameTime);
+
+    int getLevel() const;
+
+    /**
+     * Get the percentile frame time of the last completed window, in seconds.
+     */
+    float getPercentileFrameTime() const;
+};
+
+#endif //GRAPHICS_TEST_FRAME_GOVERNOR_H
@@ -0,0 +1,57 @@
+//
+// Created by Luca Warmenhoven on 17/10/2026.
+//
+
+#include "framebuffer.h"
+
+FrameBuffer::FrameBuffer()
+{
+    glGenFramebuffers(1, &this->framebufferId);
+    this->previousViewport[ 0 ] = this->previousViewport[ 1 ] = 0;
+    this->previousViewport[ 2 ] = this->previousViewport[ 3 ] = 0;
+}
+
+FrameBuffer::~FrameBuffer()
+{
+    glDeleteFramebuffers(1, &this->framebufferId);
+}
+
+void FrameBuffer::attachColorTexture(GLuint textureId)
+{
+    glBindFramebuffer(GL_FRAMEBUFFER, this->framebufferId);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, textureId, 0);
+    glDrawBuffer(GL_COLOR_ATTACHMENT0);
+    glReadBuffer(GL_COLOR_ATTACHMENT0);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void FrameBuffer::attachDepthTextureLayer(GLuint textureId, int layer)
+{
+    glBindFramebuffer(GL_FRAMEBUFFER, this->framebufferId);
+    glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, textureId, 0, layer);
+    glDrawBuffer(GL_NONE);
+    glReadBuffer(GL_NONE);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+bool FrameBuffer::isComplete() const
+{
+    glBindFramebuffer(GL_FRAMEBUFFER, this->framebufferId);
+    GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    return status == GL_FRAMEBUFFER_COMPLETE;
+}
+
+void FrameBuffer::bind(int width, int height)
+{
+    glGetIntegerv(GL_VIEWPORT, this->previousViewport);
+    glBindFramebuffer(GL_FRAMEBUFFER, this->framebufferId);
+    glViewport(0, 0, width, height);
+}
+
+void FrameBuffer::unbind()
+{
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glViewport(this->previousViewport[ 0 ], this->previousViewport[ 1 ],
+               this->previousViewport[ 2 ], this->previousViewport[ 3 ]);
+}
@@ -0,0 +1,70 @@
+//
+// Created by Luca Warmenhoven on 17/10/2026.
+//
+
+#ifndef GRAPHICS_TEST_FRAMEBUFFER_H
+#define GRAPHICS_TEST_FRAMEBUFFER_H
+
+#include "renderer.h"
+
+/**
+ * An off-screen render target.
+ * Textures are created by the owner of the frame buffer, this class
+ * only takes care of attaching them and switching the render target.
+ */
+class FrameBuffer
+{
+
+private:
+
+    /** The ID of the frame buffer object */
+    GLuint framebufferId;
+
+    /** The viewport that was active before binding this frame buffer */
+    GLint previousViewport[4];
+
+public:
+
+    /**
+     * Constructor for creating a new, empty frame buffer.
+     */
+    FrameBuffer();
+
+    /**
+     * Destructor for the frame buffer.
+     * This does not delete the attached textures.
+     */
+    ~FrameBuffer();
+
+    /**
+     * Attaches a 2D texture as the (only) color attachment.
+     * @param textureId The texture to render into.
+     */
+    void attachColorTexture(GLuint textureId);
+
+    /**
+     * Attaches a single layer of a depth texture array as the depth attachment.
+     * No color attachment will be written to when using this.
+     * @param textureId The depth texture array to render into.
+     * @param layer The layer of the texture array.
+     */
+    void attachDepthTextureLayer(GLuint textureId, int layer);
+
+    /**
+     * Whether the frame buffer is complete and can be rendered to.
+     */
+    bool isComplete() const;
+
+    /**
+     * Binds the frame buffer and sets the viewport to the provided size.
+     * The previous viewport is restored when calling `unbind()`.
+     */
+    void bind(int width, int height);
+
+    /**
+     * Binds the default frame buffer and restores the previous viewport.
+     */
+    void unbind();
+};
+
+#endif //GRAPHICS_TEST_FRAMEBUFFER_H
@@ -0,0 +1,71 @@
+//
+// Created by Luca Warmenhoven on 17/10/2026.
+//
+
+#include "instanced_renderer.h"
+#include "render_stats.h"
+
+InstancedRenderer::~InstancedRenderer()
+{
+    for ( auto &groupPair: this->groups )
+        glDeleteBuffers(1, &groupPair.second.instanceBufferId);
+}
+
+void InstancedRenderer::submit(Mesh *mesh, const glm::mat4 &transform)
+{
+    auto group = this->groups.find(mesh);
+
+    // First time this Mesh is drawn, attach an instance buffer to it.
+    if ( group == this->groups.end()) {
+        instance_group_t newGroup = {};
+        glGenBuffers(1, &newGroup.instanceBufferId);
+        newGroup.instanceBufferCapacity = 0;
+        mesh->getBuffer()->withInstanceBuffer(newGroup.instanceBufferId);
+        group = this->groups.insert({ mesh, newGroup }).first;
+    }
+    group->second.transforms.push_back(transform);
+}
+
+void InstancedRenderer::flush()
+{
+    for ( auto &groupPair: this->groups ) {
+        instance_group_t &group = groupPair.second;
+        if ( group.transforms.empty())
+            continue;
+
+        glBindBuffer(GL_ARRAY_BUFFER, group.instanceBufferId);
+
+        // Orphan the previous storage, so we don't have to wait for the
+        // previous frame's draw calls to finish reading from it.
+        if ( group.transforms.size() > group.instanceBufferCapacity )
+            group.instanceBufferCapacity = std::max(group.transforms.size(), group.instanceBufferCapacity * 2);
+        glBufferData(GL_ARRAY_BUFFER, group.instanceBufferCapacity * sizeof(glm::mat4), nullptr, GL_STREAM_DRAW);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, group.transforms.size() * sizeof(glm::mat4), group.transforms.data());
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        RenderStats::add(RENDER_STAT_UPLOAD_BYTES, group.transforms.size() * sizeof(glm::mat4));
+
+        groupPair.first->getBuffer()->drawInstanced((GLsizei) group.transforms.size());
+        group.transforms.clear();
+    }
+}
+
+InstancedDrawable::InstancedDrawable(Mesh *mesh, InstancedRenderer *renderer, vec3 position, vec3 scale,
+                                     vec3 rotation) : Drawable(position, scale, rotation)
+{
+    this->mesh = mesh;
+    this->renderer = renderer;
+}
+
+glm::mat4 InstancedDrawable::getTransform() const
+{
+    glm::mat4 transform = glm::translate(glm::mat4(1.0f), this->position);
+    transform = glm::rotate(transform, this->rotation.y, glm::vec3(0.0f, 1.0f, 0.0f));
+    transform = glm::rotate(transform, this->rotation.x, glm::vec3(1.0f, 0.0f, 0.0f));
+    transform = glm::rotate(transform, this->rotation.z, glm::vec3(0.0f, 0.0f, 1.0f));
+    return glm::scale(transform, this->scale);
+}
+
+void InstancedDrawable::draw(float deltaTime)
+{
+    this->renderer->submit(this->mesh, this->getTransform());
+}
@@ -0,0 +1,84 @@
+//
+// Created by Luca Warmenhoven on 17/10/2026.
+//
+
+#ifndef GRAPHICS_TEST_INSTANCED_RENDERER_H
+#define GRAPHICS_TEST_INSTANCED_RENDERER_H
+
+#include <unordered_map>
+#include "renderer.h"
+#include "model/mesh.h"
+
+/**
+ * Struct containing all instances of a single Mesh that
+ * have been submitted during the current frame.
+ */
+typedef struct {
+    GLuint instanceBufferId;
+    size_t instanceBufferCapacity; // In instances
+    std::vector<glm::mat4> transforms;
+} instance_group_t;
+
+/**
+ * Renderer that draws all submitted instances that share a Mesh
+ * with a single draw call.
+ *
+ * The model matrices of all instances are packed into a per-instance
+ * attribute buffer, which is uploaded once per frame when flushing.
+ * A Mesh can only be used by a single InstancedRenderer, as its VAO
+ * references the instance buffer of that renderer.
+ */
+class InstancedRenderer
+{
+
+private:
+    std::unordered_map<Mesh *, instance_group_t> groups;
+
+public:
+
+    ~InstancedRenderer();
+
+    /**
+     * Submits an instance of a Mesh for drawing during the next flush.
+     * @param mesh The Mesh to draw.
+     * @param transform The model matrix of the instance.
+     */
+    void submit(Mesh *mesh, const glm::mat4 &transform);
+
+    /**
+     * Uploads the transforms of all submitted instances and draws every
+     * group of instances with one instanced draw call.
+     * The shader and its uniforms have to be set up by the caller.
+     * All submitted instances are cleared afterwards.
+     */
+    void flush();
+};
+
+/**
+ * A drawable that doesn't draw itself directly, but submits itself
+ * to an InstancedRenderer. All InstancedDrawables sharing a Mesh are
+ * then drawn at once.
+ */
+class InstancedDrawable : public Drawable
+{
+
+private:
+    Mesh *mesh;
+    InstancedRenderer *renderer;
+
+public:
+
+    InstancedDrawable(Mesh *mesh, InstancedRenderer *renderer, vec3 position, vec3 scale, vec3 rotation);
+
+    /**
+     * Get the model matrix of this drawable, built from its position, rotation and scale.
+     */
+    glm::mat4 getTransform() const;
+
+    /**
+     * Submits this drawable to its InstancedRenderer.
+     */
+    void draw(float deltaTime) override;
+};
+
+#endif //GRAPHICS_TEST_INSTANCED_RENDERER_H
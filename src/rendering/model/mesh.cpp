@@ -16,6 +16,11 @@ void Mesh::draw(float deltaTime)
     this->buffer->draw(deltaTime);
 }
 
+VBO *Mesh::getBuffer() const
+{
+    return this->buffer;
+}
+
 Mesh::~Mesh()
 {
     delete this->buffer;
@@ -38,6 +38,11 @@ public:
      */
     void draw(float deltaTime);
 
+    /**
+     * Get the buffer containing the geometry of this Mesh.
+     */
+    VBO *getBuffer() const;
+
 };
 
 
@@ -0,0 +1,82 @@
+//
+// Created by Luca Warmenhoven on 17/10/2026.
+//
+
+#include "render_stats.h"
+#include <algorithm>
+#include <iomanip>
+
+static const char *COUNTER_NAMES[RENDER_STAT_COUNT] = {
+        "draw calls", "triangles", "vao binds", "program binds", "uniforms", "upload bytes", "chunks drawn",
+        "chunks culled"
+};
+
+uint64_t RenderStats::current[RENDER_STAT_COUNT];
+uint64_t RenderStats::history[RENDER_STATS_WINDOW][RENDER_STAT_COUNT];
+uint64_t RenderStats::windowTotals[RENDER_STAT_COUNT];
+int RenderStats::historyIndex = 0;
+uint64_t RenderStats::frameCount = 0;
+
+void RenderStats::endFrame()
+{
+    // The oldest frame in the history leaves the window as the current one enters it
+    for ( int counter = 0; counter < RENDER_STAT_COUNT; counter++ ) {
+        windowTotals[ counter ] += current[ counter ] - history[ historyIndex ][ counter ];
+        history[ historyIndex ][ counter ] = current[ counter ];
+        current[ counter ] = 0;
+    }
+    historyIndex = ( historyIndex + 1 ) % RENDER_STATS_WINDOW;
+    frameCount++;
+}
+
+const char *RenderStats::getCounterName(int counter)
+{
+    return COUNTER_NAMES[ counter ];
+}
+
+uint64_t RenderStats::getLastFrame(int counter)
+{
+    if ( frameCount == 0 )
+        return 0;
+    return history[ ( historyIndex + RENDER_STATS_WINDOW - 1 ) % RENDER_STATS_WINDOW ][ counter ];
+}
+
+double RenderStats::getAverage(int counter)
+{
+    uint64_t frames = std::min(frameCount, (uint64_t) RENDER_STATS_WINDOW);
+    return frames == 0 ? 0.0 : (double) windowTotals[ counter ] / (double) frames;
+}
+
+uint64_t RenderStats::getFrameCount()
+{
+    return frameCount;
+}
+
+void RenderStats::reset()
+{
+    for ( int counter = 0; counter < RENDER_STAT_COUNT; counter++ ) {
+        current[ counter ] = 0;
+        windowTotals[ counter ] = 0;
+        for ( auto &frame: history )
+            frame[ counter ] = 0;
+    }
+    historyIndex = 0;
+    frameCount = 0;
+}
+
+void RenderStats::log(std::ostream &out)
+{
+    std::ios_base::fmtflags flags = out.flags();
+    std::streamsize precision = out.precision();
+
+    out << "Render stats over " << std::min(frameCount, (uint64_t) RENDER_STATS_WINDOW)
+        << " frames (last frame, average):" << std::endl;
+    out << std::fixed << std::setprecision(1);
+    for ( int counter = 0; counter < RENDER_STAT_COUNT; counter++ ) {
+        out << "  " << std::left << std::setw(14) << getCounterName(counter) << std::right
+            << std::setw(12) << getLastFrame(counter)
+            << std::setw(14) << getAverage(counter) << std::endl;
+    }
+    out.flags(flags);
+    out.precision(precision);
+}
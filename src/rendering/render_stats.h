@@ -0,0 +1,85 @@
+//
+// Created by Luca Warmenhoven on 17/10/2026.
+//
+
+#ifndef GRAPHICS_TEST_RENDER_STATS_H
+#define GRAPHICS_TEST_RENDER_STATS_H
+
+#include <cstdint>
+#include <ostream>
+
+// The counters of a frame
+#define RENDER_STAT_DRAW_CALLS (0)
+#define RENDER_STAT_TRIANGLES (1)       // Triangles submitted by triangle draw calls, all instances included
+#define RENDER_STAT_VAO_BINDS (2)       // Binds of a vertex array, not counting unbinds
+#define RENDER_STAT_PROGRAM_BINDS (3)   // Binds of a shader program, not counting unbinds
+#define RENDER_STAT_UNIFORM_UPLOADS (4)
+#define RENDER_STAT_UPLOAD_BYTES (5)    // Bytes written to buffers and textures
+#define RENDER_STAT_CHUNKS_DRAWN (6)
+#define RENDER_STAT_CHUNKS_CULLED (7)   // Loaded chunks outside the view frustum or the draw distance
+#define RENDER_STAT_COUNT (8)
+
+// The amount of frames the averages are taken over
+#define RENDER_STATS_WINDOW (120)
+
+/**
+ * Counts the work the renderer submits to OpenGL every frame, so regressions in the
+ * submission show up as numbers instead of as a lower frame rate.
+ *
+ * The counters are incremented by the VBOs, shaders and the world renderer as they
+ * call into OpenGL, and moved into the history by `endFrame`. The averages are taken
+ * over the last RENDER_STATS_WINDOW frames.
+ * Only the thread owning the OpenGL context may use the stats.
+ */
+class RenderStats
+{
+
+private:
+    static uint64_t current[RENDER_STAT_COUNT];
+    static uint64_t history[RENDER_STATS_WINDOW][RENDER_STAT_COUNT];
+
+    /** The sums of the frames in the history */
+    static uint64_t windowTotals[RENDER_STAT_COUNT];
+
+    static int historyIndex;
+    static uint64_t frameCount;
+
+public:
+
+    static void add(int counter, uint64_t amount = 1)
+    {
+        current[ counter ] += amount;
+    }
+
+    /**
+     * Ends the current frame, moving its counters into the history.
+     * Called once per frame, after the last draw call.
+     */
+    static void endFrame();
+
+    static const char *getCounterName(int counter);
+
+    /**
+     * Get the value of a counter in the last finished frame.
+     */
+    static uint64_t getLastFrame(int counter);
+
+    /**
+     * Get the mean value of a counter over the last RENDER_STATS_WINDOW frames, or fewer when fewer have finished.
+     */
+    static double getAverage(int counter);
+
+    /**
+     * Get the amount of frames that have finished since the stats were reset.
+     */
+    static uint64_t getFrameCount();
+
+    static void reset();
+
+    /**
+     * Writes a line per counter with its value in the last frame and its average.
+     */
+    static void log(std::ostream &out);
+};
+
+#endif //GRAPHICS_TEST_RENDER_STATS_H
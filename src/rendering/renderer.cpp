@@ -3,9 +3,10 @@
 //
 
 #include "renderer.h"
+#include "render_stats.h"
 
-std::vector<matrix_stack_entry_t> Renderer::matrixStack = {};
-matrix_stack_entry_t Renderer::currentMatrix = {
+thread_local std::vector<matrix_stack_entry_t> Renderer::matrixStack = {};
+thread_local matrix_stack_entry_t Renderer::currentMatrix = {
         glm::mat4(1.0f),
         glm::mat4(1.0f),
         glm::mat4(1.0f),
@@ -15,7 +16,14 @@ matrix_stack_entry_t Renderer::currentMatrix = {
         glm::vec3(1.0f),
 };
 
-unsigned char Renderer::renderMode = RENDER_MODE_3D;
+thread_local unsigned char Renderer::renderMode = RENDER_MODE_3D;
+
+Drawable::Drawable(vec3 position, vec3 scale, vec3 rotation)
+{
+    this->position = position;
+    this->scale = scale;
+    this->rotation = rotation;
+}
 
 void Renderer::computeMatrices(float fov, float zNear, float zFar, float width, float height)
 {
@@ -83,6 +91,8 @@ void Renderer::pushMatrices(GLuint shaderProgramId)
             1, GL_FALSE, glm::value_ptr(Renderer::currentMatrix.modelViewProjectionMatrix)
     );
 
+    RenderStats::add(RENDER_STAT_UNIFORM_UPLOADS, 4);
+
     if ( Renderer::renderMode == RENDER_MODE_3D ) {
         glEnable(GL_DEPTH_TEST);
         glDepthFunc(GL_LEQUAL);
@@ -22,6 +22,8 @@ using namespace glm;
 #define VBO_POSITION_INDEX 0
 #define VBO_NORMAL_INDEX 1
 #define VBO_UV_INDEX 2
+#define VBO_INSTANCE_MATRIX_INDEX 3 // A mat4 occupies four attribute locations, 3 up to and including 6
+#define VBO_INSTANCE_DATA_INDEX 3 // Generic per-instance attribute, for VBOs without instance matrices
 
 /**
  * Class representing a drawable object.
@@ -57,13 +59,17 @@ typedef struct {
     unsigned char renderMode;
 } matrix_stack_entry_t;
 
+/**
+ * The matrix state is kept per thread, so threads that prepare
+ * work for the render thread can use the Renderer without interfering with it.
+ */
 class Renderer
 {
     /** The model, view and projection matrices. */
-    static std::vector<matrix_stack_entry_t> matrixStack;
-    static matrix_stack_entry_t currentMatrix;
+    static thread_local std::vector<matrix_stack_entry_t> matrixStack;
+    static thread_local matrix_stack_entry_t currentMatrix;
 
-    static unsigned char renderMode;
+    static thread_local unsigned char renderMode;
 
 public:
 
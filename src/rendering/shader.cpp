@@ -4,9 +4,11 @@
 
 #include <fstream>
 #include "shader.h"
+#include "render_stats.h"
 #include "../io/Files.h"
 #include "glm/gtc/type_ptr.hpp"
 #include <iostream>
+#include <cstring>
 
 /*
  * Constructors
@@ -26,6 +28,38 @@ Shader::Shader()
     this->vertexSourcePath = nullptr;
 }
 
+/**
+ * Replaces the lines `#include "file"` of a shader source by the contents of the file,
+ * relative to the directory of the source. Included files may include other files.
+ * @return Whether all included files could be read
+ */
+static bool resolveIncludes(std::string &source, const std::string &directory, int depth = 0)
+{
+    if ( depth > SHADER_MAX_INCLUDE_DEPTH ) {
+        std::cerr << "Shader Error - Includes nested too deep in " << directory << std::endl;
+        return false;
+    }
+
+    size_t position = 0;
+    while (( position = source.find("#include \"", position)) != std::string::npos ) {
+        size_t nameStart = position + strlen("#include \"");
+        size_t nameEnd = source.find('"', nameStart);
+        size_t lineEnd = source.find('\n', position);
+        if ( nameEnd == std::string::npos || nameEnd > lineEnd ) {
+            std::cerr << "Shader Error - Malformed include in " << directory << std::endl;
+            return false;
+        }
+
+        std::string path = directory + source.substr(nameStart, nameEnd - nameStart);
+        std::string included = Files::read(path.c_str());
+        if ( included.empty() || !resolveIncludes(included, path.substr(0, path.find_last_of('/') + 1), depth + 1))
+            return false;
+        source.replace(position, lineEnd - position, included);
+        position += included.size();
+    }
+    return true;
+}
+
 void Shader::loadSource(GLuint shaderId, const char *sourcePath)
 {
     std::string source = Files::read(sourcePath);
@@ -36,6 +70,13 @@ void Shader::loadSource(GLuint shaderId, const char *sourcePath)
         return;
     }
 
+    std::string path = sourcePath;
+    if ( !resolveIncludes(source, path.substr(0, path.find_last_of('/') + 1)))
+    {
+        std::cerr << "Shader Error - Failed to resolve the includes of: " << sourcePath << std::endl;
+        return;
+    }
+
     const char *sourceChar = source.c_str();
     glShaderSource(shaderId, 1, &sourceChar, NULL);
     glCompileShader(shaderId);
@@ -97,6 +138,7 @@ void Shader::setSourcePath(char *sourcePath, ShaderType shaderType)
 void Shader::bind()
 {
     glUseProgram(this->programId);
+    RenderStats::add(RENDER_STAT_PROGRAM_BINDS);
 }
 
 void Shader::unbind()
@@ -108,13 +150,20 @@ GLuint Shader::getProgramId() const
 {
     return this->programId;
 }
+void Shader::uniformInt(const char *name, int value) const
+{
+    glUniform1i(glGetUniformLocation(this->programId, name), value);
+    RenderStats::add(RENDER_STAT_UNIFORM_UPLOADS);
+}
 void Shader::uniformFloat(const char *name, float value) const
 {
     glUniform1f(glGetUniformLocation(this->programId, name), value);
+    RenderStats::add(RENDER_STAT_UNIFORM_UPLOADS);
 }
 void Shader::uniformNFloat(const char *name, int count, float *value) const
 {
     glUniform1fv(glGetUniformLocation(this->programId, name), count, value);
+    RenderStats::add(RENDER_STAT_UNIFORM_UPLOADS);
 }
 void Shader::uniformVec2(const char *name, glm::vec2 vector) const
 {
@@ -123,6 +172,7 @@ void Shader::uniformVec2(const char *name, glm::vec2 vector) const
 void Shader::uniformVec2(const char *name, float x, float y) const
 {
     glUniform2f(glGetUniformLocation(this->programId, name), x, y);
+    RenderStats::add(RENDER_STAT_UNIFORM_UPLOADS);
 }
 void Shader::uniformVec3(const char *name, glm::vec3 vector) const
 {
@@ -131,6 +181,7 @@ void Shader::uniformVec3(const char *name, glm::vec3 vector) const
 void Shader::uniformVec3(const char *name, float x, float y, float z) const
 {
     glUniform3f(glGetUniformLocation(this->programId, name), x, y, z);
+    RenderStats::add(RENDER_STAT_UNIFORM_UPLOADS);
 }
 void Shader::uniformVec4(const char *name, glm::vec4 vector) const
 {
@@ -139,6 +190,7 @@ void Shader::uniformVec4(const char *name, glm::vec4 vector) const
 void Shader::uniformVec4(const char *name, float x, float y, float z, float w) const
 {
     glUniform4f(glGetUniformLocation(this->programId, name), x, y, z, w);
+    RenderStats::add(RENDER_STAT_UNIFORM_UPLOADS);
 }
 void Shader::uniformMat4(const char *name, glm::mat4 matrix) const
 {
@@ -147,6 +199,7 @@ void Shader::uniformMat4(const char *name, glm::mat4 matrix) const
 void Shader::uniformMat4(const char *name, float *value) const
 {
     glUniformMatrix4fv(glGetUniformLocation(this->programId, name), 1, GL_FALSE, value);
+    RenderStats::add(RENDER_STAT_UNIFORM_UPLOADS);
 }
 
 Shader::~Shader()
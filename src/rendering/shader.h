@@ -9,6 +9,9 @@
 #include <string>
 #include "glm/glm.hpp"
 
+// The depth up to which `#include "file"` lines in shader sources can be nested
+#define SHADER_MAX_INCLUDE_DEPTH (4)
+
 typedef enum
 {
     VERTEX = GL_VERTEX_SHADER,
@@ -64,6 +67,11 @@ public:
      */
     void unbind();
 
+    /**
+     * Sends an integer value to the shader, e.g. the texture unit of a sampler
+     */
+    void uniformInt(const char *name, int value) const;
+
     /**
      * Sends a floating point value to the shader
      */
@@ -0,0 +1,173 @@
+//
+// Created by Luca Warmenhoven on 17/10/2026.
+//
+
+#include "cascaded_shadow_map.h"
+#include "../world_renderer.h"
+
+CascadedShadowMap::CascadedShadowMap(Shader *depthShader)
+{
+    this->depthShader = depthShader;
+    this->framebuffer = new FrameBuffer();
+
+    for ( auto &cascade: this->cascades ) {
+        cascade.viewProjectionMatrix = glm::mat4(1.0f);
+        cascade.center = glm::vec3(0.0f);
+        cascade.radius = 0.0f;
+        cascade.splitDistance = 0.0f;
+        cascade.sunDirection = glm::vec3(0.0f);
+        cascade.chunkRevision = 0;
+        cascade.valid = false;
+    }
+
+    float borderColor[] = { 1.0f, 1.0f, 1.0f, 1.0f };
+
+    glGenTextures(1, &this->depthTextureArray);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, this->depthTextureArray);
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_DEPTH_COMPONENT24, SHADOW_MAP_RESOLUTION, SHADOW_MAP_RESOLUTION,
+                 SHADOW_CASCADE_COUNT, 0, GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+    glTexParameterfv(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_BORDER_COLOR, borderColor);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+}
+
+CascadedShadowMap::~CascadedShadowMap()
+{
+    glDeleteTextures(1, &this->depthTextureArray);
+    delete this->framebuffer;
+}
+
+void CascadedShadowMap::computeSliceBounds(glm::mat4 viewModelMatrix, float fov, float aspect,
+                                           float nearDistance, float farDistance,
+                                           glm::vec3 *center, float *radius)
+{
+    glm::mat4 inverseMatrix = glm::inverse(
+            glm::perspective(glm::radians(fov), aspect, nearDistance, farDistance) * viewModelMatrix);
+
+    glm::vec3 corners[8];
+    glm::vec3 sum = glm::vec3(0.0f);
+    int i = 0;
+
+    // Transform the corners of the slice from normalized device coordinates to world space
+    for ( int x = -1; x <= 1; x += 2 ) {
+        for ( int y = -1; y <= 1; y += 2 ) {
+            for ( int z = -1; z <= 1; z += 2 ) {
+                glm::vec4 corner = inverseMatrix * glm::vec4((float) x, (float) y, (float) z, 1.0f);
+                corners[ i ] = glm::vec3(corner) / corner.w;
+                sum += corners[ i++ ];
+            }
+        }
+    }
+
+    *center = sum / 8.0f;
+    *radius = 0.0f;
+    for ( glm::vec3 corner: corners )
+        *radius = std::max(*radius, glm::length(corner - *center));
+
+    // Round the radius up, so the size of the cascade doesn't change between frames.
+    *radius = std::ceil(*radius * 16.0f) / 16.0f;
+}
+
+glm::mat4 CascadedShadowMap::computeLightMatrix(glm::vec3 center, float radius, glm::vec3 sunDirection)
+{
+    glm::vec3 up = std::abs(sunDirection.y) > 0.99f ? glm::vec3(0, 0, 1) : glm::vec3(0, 1, 0);
+    glm::mat4 lightView = glm::lookAt(glm::vec3(0.0f), -sunDirection, up);
+
+    // Snap the center to whole texels in light space
+    glm::vec4 lightCenter = lightView * glm::vec4(center, 1.0f);
+    float texelSize = 2.0f * radius / SHADOW_MAP_RESOLUTION;
+    lightCenter.x = std::floor(lightCenter.x / texelSize) * texelSize;
+    lightCenter.y = std::floor(lightCenter.y / texelSize) * texelSize;
+
+    glm::mat4 lightProjection = glm::ortho(
+            lightCenter.x - radius, lightCenter.x + radius,
+            lightCenter.y - radius, lightCenter.y + radius,
+            -lightCenter.z - radius - SHADOW_CASTER_MARGIN, -lightCenter.z + radius
+    );
+    return lightProjection * lightView;
+}
+
+void CascadedShadowMap::renderCascade(WorldRenderer *renderer, int index)
+{
+    this->framebuffer->attachDepthTextureLayer(this->depthTextureArray, index);
+    this->framebuffer->bind(SHADOW_MAP_RESOLUTION, SHADOW_MAP_RESOLUTION);
+    glClear(GL_DEPTH_BUFFER_BIT);
+
+    // Depth clamping keeps casters in front of the near plane from being clipped
+    glEnable(GL_DEPTH_CLAMP);
+    glEnable(GL_POLYGON_OFFSET_FILL);
+    glPolygonOffset(2.0f, 4.0f);
+
+    this->depthShader->bind();
+    this->depthShader->uniformMat4("u_LightViewProjectionMatrix", this->cascades[ index ].viewProjectionMatrix);
+    renderer->renderShadowCasters(this->cascades[ index ].viewProjectionMatrix);
+
+    glDisable(GL_POLYGON_OFFSET_FILL);
+    glDisable(GL_DEPTH_CLAMP);
+    this->framebuffer->unbind();
+}
+
+void CascadedShadowMap::update(WorldRenderer *renderer, glm::mat4 viewMatrix, glm::mat4 modelMatrix,
+                               float fov, float aspect, glm::vec3 sunPosition)
+{
+    glm::vec3 sunDirection = glm::normalize(sunPosition);
+    glm::mat4 viewModelMatrix = viewMatrix * modelMatrix;
+    float previousSplit = SHADOW_NEAR_DISTANCE;
+
+    for ( int i = 0; i < SHADOW_CASCADE_COUNT; i++ ) {
+        shadow_cascade_t &cascade = this->cascades[ i ];
+
+        // Blend between logarithmic and linear split distances
+        float ratio = (float) ( i + 1 ) / SHADOW_CASCADE_COUNT;
+        float logarithmicSplit = SHADOW_NEAR_DISTANCE * std::pow(SHADOW_MAX_DISTANCE / SHADOW_NEAR_DISTANCE, ratio);
+        float linearSplit = SHADOW_NEAR_DISTANCE + ( SHADOW_MAX_DISTANCE - SHADOW_NEAR_DISTANCE ) * ratio;
+        float split = SHADOW_CASCADE_SPLIT_LAMBDA * logarithmicSplit +
+                      ( 1.0f - SHADOW_CASCADE_SPLIT_LAMBDA ) * linearSplit;
+
+        glm::vec3 center;
+        float radius;
+        computeSliceBounds(viewModelMatrix, fov, aspect, previousSplit, split, &center, &radius);
+        cascade.splitDistance = split;
+        previousSplit = split;
+
+        bool dynamic = i < SHADOW_DYNAMIC_CASCADES;
+        bool refresh = dynamic || !cascade.valid
+                       || glm::dot(sunDirection, cascade.sunDirection) < SHADOW_SUN_MOVEMENT_THRESHOLD
+                       || glm::length(center - cascade.center) + radius > cascade.radius
+                       || renderer->hasChunkChangesWithin(cascade.chunkRevision, cascade.viewProjectionMatrix);
+
+        if ( !refresh )
+            continue;
+
+        cascade.center = center;
+        cascade.radius = dynamic ? radius : radius * ( 1.0f + SHADOW_CACHED_CASCADE_PADDING );
+        cascade.sunDirection = sunDirection;
+        cascade.chunkRevision = renderer->world->chunkRevision;
+        cascade.viewProjectionMatrix = computeLightMatrix(cascade.center, cascade.radius, sunDirection);
+        cascade.valid = true;
+        this->renderCascade(renderer, i);
+    }
+}
+
+void CascadedShadowMap::bind(Shader *shader) const
+{
+    char uniformName[64];
+    float splitDistances[SHADOW_CASCADE_COUNT];
+
+    glActiveTexture(GL_TEXTURE0 + SHADOW_TEXTURE_UNIT);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, this->depthTextureArray);
+    glActiveTexture(GL_TEXTURE0);
+    shader->uniformInt("u_ShadowMap", SHADOW_TEXTURE_UNIT);
+
+    for ( int i = 0; i < SHADOW_CASCADE_COUNT; i++ ) {
+        snprintf(uniformName, sizeof(uniformName), "u_ShadowCascadeMatrices[%d]", i);
+        shader->uniformMat4(uniformName, this->cascades[ i ].viewProjectionMatrix);
+        splitDistances[ i ] = this->cascades[ i ].splitDistance;
+    }
+    shader->uniformNFloat("u_ShadowCascadeSplits", SHADOW_CASCADE_COUNT, splitDistances);
+}
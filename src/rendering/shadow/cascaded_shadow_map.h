@@ -0,0 +1,110 @@
+//
+// Created by Luca Warmenhoven on 17/10/2026.
+//
+
+#ifndef GRAPHICS_TEST_CASCADED_SHADOW_MAP_H
+#define GRAPHICS_TEST_CASCADED_SHADOW_MAP_H
+
+#include "../renderer.h"
+#include "../shader.h"
+#include "../framebuffer.h"
+
+class WorldRenderer;
+
+#define SHADOW_CASCADE_COUNT (4)
+#define SHADOW_MAP_RESOLUTION (2048)
+
+// The first N cascades are re-rendered every frame, the others are cached.
+#define SHADOW_DYNAMIC_CASCADES (1)
+
+#define SHADOW_NEAR_DISTANCE (10.0f)
+#define SHADOW_MAX_DISTANCE (8000.0f)
+#define SHADOW_CASCADE_SPLIT_LAMBDA (0.75f)
+
+// Distance behind the cascade at which casters are still included.
+#define SHADOW_CASTER_MARGIN (2000.0f)
+
+// The fraction by which cached cascades are enlarged, so the camera can move
+// around for a while before the cascade has to be re-rendered.
+#define SHADOW_CACHED_CASCADE_PADDING (0.25f)
+
+// Cosine of the angle the sun has to move before cached cascades are re-rendered.
+#define SHADOW_SUN_MOVEMENT_THRESHOLD (0.99999f)
+
+#define SHADOW_TEXTURE_UNIT (3)
+
+typedef struct {
+    glm::mat4 viewProjectionMatrix;
+
+    /** Bounding sphere of the area covered by this cascade */
+    glm::vec3 center;
+    float radius;
+
+    /** The view distance up to which this cascade is used */
+    float splitDistance;
+
+    /** The state this cascade was rendered with */
+    glm::vec3 sunDirection;
+    unsigned long chunkRevision;
+    bool valid;
+} shadow_cascade_t;
+
+/**
+ * Cascaded shadow maps for the sun.
+ *
+ * All cascades share a single depth texture array. The near cascades are
+ * re-rendered every frame. The far cascades cover a padded area and are only
+ * re-rendered when the sun moves, when the camera leaves the padded area, or
+ * when new chunks stream in within the cascade.
+ */
+class CascadedShadowMap
+{
+
+private:
+    Shader *depthShader;
+    FrameBuffer *framebuffer;
+    GLuint depthTextureArray;
+
+    shadow_cascade_t cascades[SHADOW_CASCADE_COUNT];
+
+    /**
+     * Computes the bounding sphere of the part of the view frustum that lies
+     * between the two provided distances.
+     */
+    static void computeSliceBounds(glm::mat4 viewModelMatrix, float fov, float aspect,
+                                   float nearDistance, float farDistance,
+                                   glm::vec3 *center, float *radius);
+
+    /**
+     * Computes the light view-projection matrix for a cascade, snapped to
+     * whole texels to prevent shimmering when the camera moves.
+     */
+    static glm::mat4 computeLightMatrix(glm::vec3 center, float radius, glm::vec3 sunDirection);
+
+    void renderCascade(WorldRenderer *renderer, int index);
+
+public:
+
+    explicit CascadedShadowMap(Shader *depthShader);
+
+    ~CascadedShadowMap();
+
+    /**
+     * Updates the cascades that need updating.
+     * @param renderer The renderer of the world to render the shadow casters of
+     * @param viewMatrix The view matrix of the camera
+     * @param modelMatrix The model matrix of the camera
+     * @param fov The field of view of the camera, in degrees
+     * @param aspect The aspect ratio of the camera
+     * @param sunPosition The position of the sun, this does not have to be normalized.
+     */
+    void update(WorldRenderer *renderer, glm::mat4 viewMatrix, glm::mat4 modelMatrix,
+                float fov, float aspect, glm::vec3 sunPosition);
+
+    /**
+     * Binds the shadow map and the cascade parameters to the provided (already bound) shader.
+     */
+    void bind(Shader *shader) const;
+};
+
+#endif //GRAPHICS_TEST_CASCADED_SHADOW_MAP_H
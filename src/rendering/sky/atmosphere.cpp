@@ -0,0 +1,145 @@
+//
+// Created by Luca Warmenhoven on 17/10/2026.
+//
+
+#include "atmosphere.h"
+
+Atmosphere::Atmosphere(Shader *transmittanceShader, Shader *skyViewShader)
+{
+    this->transmittanceShader = transmittanceShader;
+    this->skyViewShader = skyViewShader;
+    this->framebuffer = new FrameBuffer();
+    this->frontSkyViewLut = 0;
+    this->pendingSkyViewRow = -1;
+    this->skyViewSunDirection = glm::vec3(0.0f);
+    this->pendingSunDirection = glm::vec3(0.0f);
+    this->initialized = false;
+
+    this->transmittanceLut = createLut(ATMOSPHERE_TRANSMITTANCE_LUT_WIDTH, ATMOSPHERE_TRANSMITTANCE_LUT_HEIGHT);
+    this->skyViewLuts[ 0 ] = createLut(ATMOSPHERE_SKY_VIEW_LUT_WIDTH, ATMOSPHERE_SKY_VIEW_LUT_HEIGHT);
+    this->skyViewLuts[ 1 ] = createLut(ATMOSPHERE_SKY_VIEW_LUT_WIDTH, ATMOSPHERE_SKY_VIEW_LUT_HEIGHT);
+
+    this->screenQuad = new VBO();
+    this->screenQuad->withVertices((vertex_t[4]) {
+            { -1, -1, 0, 0, 0, 1, 0, 0 },
+            { 1,  -1, 0, 0, 0, 1, 1, 0 },
+            { 1,  1,  0, 0, 0, 1, 1, 1 },
+            { -1, 1,  0, 0, 0, 1, 0, 1 },
+    }, 4);
+    this->screenQuad->withIndices((unsigned int[6]) { 0, 1, 2, 2, 3, 0 }, 6);
+    this->screenQuad->build();
+}
+
+Atmosphere::~Atmosphere()
+{
+    glDeleteTextures(1, &this->transmittanceLut);
+    glDeleteTextures(2, this->skyViewLuts);
+    delete this->screenQuad;
+    delete this->framebuffer;
+}
+
+GLuint Atmosphere::createLut(int width, int height)
+{
+    GLuint textureId;
+    glGenTextures(1, &textureId);
+    glBindTexture(GL_TEXTURE_2D, textureId);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, width, height, 0, GL_RGBA, GL_FLOAT, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    return textureId;
+}
+
+void Atmosphere::renderTransmittanceLut()
+{
+    this->framebuffer->attachColorTexture(this->transmittanceLut);
+    this->framebuffer->bind(ATMOSPHERE_TRANSMITTANCE_LUT_WIDTH, ATMOSPHERE_TRANSMITTANCE_LUT_HEIGHT);
+    this->transmittanceShader->bind();
+    this->screenQuad->draw(0);
+    this->framebuffer->unbind();
+}
+
+/**
+ * Renders a horizontal band of the sky-view LUT.
+ * The scissor test restricts the full-screen quad to the requested rows,
+ * so the cost of a refresh can be spread over multiple frames.
+ */
+void Atmosphere::renderSkyViewRows(int lutIndex, glm::vec3 sunDirection, int firstRow, int rowCount)
+{
+    this->framebuffer->attachColorTexture(this->skyViewLuts[ lutIndex ]);
+    this->framebuffer->bind(ATMOSPHERE_SKY_VIEW_LUT_WIDTH, ATMOSPHERE_SKY_VIEW_LUT_HEIGHT);
+
+    glEnable(GL_SCISSOR_TEST);
+    glScissor(0, firstRow, ATMOSPHERE_SKY_VIEW_LUT_WIDTH, rowCount);
+
+    this->skyViewShader->bind();
+    this->skyViewShader->uniformVec3("u_SunDirection", sunDirection);
+    glActiveTexture(GL_TEXTURE0 + ATMOSPHERE_TRANSMITTANCE_TEXTURE_UNIT);
+    glBindTexture(GL_TEXTURE_2D, this->transmittanceLut);
+    this->skyViewShader->uniformInt("u_TransmittanceLut", ATMOSPHERE_TRANSMITTANCE_TEXTURE_UNIT);
+    glActiveTexture(GL_TEXTURE0);
+
+    this->screenQuad->draw(0);
+
+    glDisable(GL_SCISSOR_TEST);
+    this->framebuffer->unbind();
+}
+
+void Atmosphere::update(glm::vec3 sunPosition)
+{
+    glm::vec3 sunDirection = glm::normalize(sunPosition);
+
+    bool depthTestEnabled = glIsEnabled(GL_DEPTH_TEST);
+    bool blendEnabled = glIsEnabled(GL_BLEND);
+    glDisable(GL_DEPTH_TEST);
+    glDisable(GL_BLEND);
+
+    // The first time around everything has to be available at once.
+    if ( !this->initialized ) {
+        this->renderTransmittanceLut();
+        this->renderSkyViewRows(this->frontSkyViewLut, sunDirection, 0, ATMOSPHERE_SKY_VIEW_LUT_HEIGHT);
+        this->skyViewSunDirection = sunDirection;
+        this->initialized = true;
+    }
+    // Start refreshing the back LUT if the sun moved since the last refresh.
+    else if ( this->pendingSkyViewRow < 0 &&
+              glm::dot(sunDirection, this->skyViewSunDirection) < ATMOSPHERE_SUN_MOVEMENT_THRESHOLD ) {
+        this->pendingSunDirection = sunDirection;
+        this->pendingSkyViewRow = 0;
+    }
+
+    if ( this->pendingSkyViewRow >= 0 ) {
+        int rowCount = std::min(ATMOSPHERE_SKY_VIEW_ROWS_PER_FRAME,
+                                ATMOSPHERE_SKY_VIEW_LUT_HEIGHT - this->pendingSkyViewRow);
+        this->renderSkyViewRows(1 - this->frontSkyViewLut, this->pendingSunDirection,
+                                this->pendingSkyViewRow, rowCount);
+        this->pendingSkyViewRow += rowCount;
+
+        // All rows are up to date, swap the back and front LUT.
+        if ( this->pendingSkyViewRow >= ATMOSPHERE_SKY_VIEW_LUT_HEIGHT ) {
+            this->frontSkyViewLut = 1 - this->frontSkyViewLut;
+            this->skyViewSunDirection = this->pendingSunDirection;
+            this->pendingSkyViewRow = -1;
+        }
+    }
+
+    if ( depthTestEnabled )
+        glEnable(GL_DEPTH_TEST);
+    if ( blendEnabled )
+        glEnable(GL_BLEND);
+}
+
+void Atmosphere::bind(Shader *shader) const
+{
+    glActiveTexture(GL_TEXTURE0 + ATMOSPHERE_TRANSMITTANCE_TEXTURE_UNIT);
+    glBindTexture(GL_TEXTURE_2D, this->transmittanceLut);
+    glActiveTexture(GL_TEXTURE0 + ATMOSPHERE_SKY_VIEW_TEXTURE_UNIT);
+    glBindTexture(GL_TEXTURE_2D, this->skyViewLuts[ this->frontSkyViewLut ]);
+    glActiveTexture(GL_TEXTURE0);
+
+    shader->uniformInt("u_TransmittanceLut", ATMOSPHERE_TRANSMITTANCE_TEXTURE_UNIT);
+    shader->uniformInt("u_SkyViewLut", ATMOSPHERE_SKY_VIEW_TEXTURE_UNIT);
+    shader->uniformVec3("u_SkyViewSunDirection", this->skyViewSunDirection);
+}
@@ -0,0 +1,94 @@
+//
+// Created by Luca Warmenhoven on 17/10/2026.
+//
+
+#ifndef GRAPHICS_TEST_ATMOSPHERE_H
+#define GRAPHICS_TEST_ATMOSPHERE_H
+
+#include "../renderer.h"
+#include "../shader.h"
+#include "../vbo.h"
+#include "../framebuffer.h"
+
+#define ATMOSPHERE_TRANSMITTANCE_LUT_WIDTH (256)
+#define ATMOSPHERE_TRANSMITTANCE_LUT_HEIGHT (64)
+#define ATMOSPHERE_SKY_VIEW_LUT_WIDTH (192)
+#define ATMOSPHERE_SKY_VIEW_LUT_HEIGHT (108)
+
+// The amount of sky-view rows that are re-rendered per frame after the sun moved.
+#define ATMOSPHERE_SKY_VIEW_ROWS_PER_FRAME (27)
+
+// Cosine of the angle the sun has to move before the sky-view LUT is refreshed.
+#define ATMOSPHERE_SUN_MOVEMENT_THRESHOLD (0.99999f)
+
+#define ATMOSPHERE_TRANSMITTANCE_TEXTURE_UNIT (1)
+#define ATMOSPHERE_SKY_VIEW_TEXTURE_UNIT (2)
+
+/**
+ * Physically based sky, based on precomputed lookup tables.
+ *
+ * The transmittance LUT only depends on the atmosphere itself and is rendered once.
+ * The sky-view LUT depends on the sun direction, and is only re-rendered when
+ * the sun has moved. Re-rendering is spread over multiple frames into a back buffer,
+ * which is swapped with the displayed LUT once all rows are up to date.
+ */
+class Atmosphere
+{
+
+private:
+    Shader *transmittanceShader;
+    Shader *skyViewShader;
+
+    /** Full-screen quad used for rendering the LUTs */
+    VBO *screenQuad;
+    FrameBuffer *framebuffer;
+
+    GLuint transmittanceLut;
+    GLuint skyViewLuts[2];
+
+    /** Index of the sky-view LUT that is currently used for drawing the sky */
+    int frontSkyViewLut;
+
+    /** The next row of the back sky-view LUT to render, or -1 if it's up to date */
+    int pendingSkyViewRow;
+
+    /** The sun direction the front sky-view LUT was rendered with */
+    glm::vec3 skyViewSunDirection;
+
+    /** The sun direction the back sky-view LUT is being rendered with */
+    glm::vec3 pendingSunDirection;
+
+    bool initialized;
+
+    static GLuint createLut(int width, int height);
+
+    void renderTransmittanceLut();
+
+    void renderSkyViewRows(int lutIndex, glm::vec3 sunDirection, int firstRow, int rowCount);
+
+public:
+
+    /**
+     * Constructor for creating the atmosphere.
+     * @param transmittanceShader Shader that renders the transmittance LUT
+     * @param skyViewShader Shader that renders the sky-view LUT
+     */
+    Atmosphere(Shader *transmittanceShader, Shader *skyViewShader);
+
+    ~Atmosphere();
+
+    /**
+     * Updates the lookup tables if required.
+     * This must be called outside of any other frame buffer pass, preferably
+     * at the start of the frame.
+     * @param sunPosition The position of the sun, this does not have to be normalized.
+     */
+    void update(glm::vec3 sunPosition);
+
+    /**
+     * Binds the lookup tables to the provided (already bound) shader.
+     */
+    void bind(Shader *shader) const;
+};
+
+#endif //GRAPHICS_TEST_ATMOSPHERE_H
@@ -0,0 +1,331 @@
+//
+// Created by Luca Warmenhoven on 17/10/2026.
+//
+
+#include "clipmap.h"
+#include "../render_stats.h"
+
+/**
+ * Appends the indices of the cells of a level, skipping the cells that
+ * are covered by the finer level.
+ *
+ * @param holeX The first cell covered by the finer level along x, or -1 if there is no hole
+ * @param holeZ The first cell covered by the finer level along z
+ */
+static void addCells(std::vector<unsigned int> &indices, int holeX, int holeZ)
+{
+    const int gridSize = CLIPMAP_CELL_COUNT + 1;
+
+    for ( int i = 0; i < CLIPMAP_CELL_COUNT; i++ ) {
+        for ( int j = 0; j < CLIPMAP_CELL_COUNT; j++ ) {
+            if ( holeX >= 0 &&
+                 i >= holeX && i < holeX + CLIPMAP_HOLE_CELL_COUNT &&
+                 j >= holeZ && j < holeZ + CLIPMAP_HOLE_CELL_COUNT )
+                continue;
+
+            indices.push_back(i * gridSize + j);
+            indices.push_back(i * gridSize + j + 1);
+            indices.push_back(( i + 1 ) * gridSize + j);
+
+            indices.push_back(i * gridSize + j + 1);
+            indices.push_back(( i + 1 ) * gridSize + j + 1);
+            indices.push_back(( i + 1 ) * gridSize + j);
+        }
+    }
+}
+
+Clipmap::Clipmap(const clipmap_height_function_t &heightFunction, float cellSize, float gridOffset)
+{
+    this->heightFunction = heightFunction;
+    this->cellSize = cellSize;
+    this->gridOffset = gridOffset;
+
+    for ( auto &level: this->levels )
+        level = { 0, 0, false };
+    for ( clipmap_fill_t &fill: this->fills ) {
+        fill.pending = false;
+        fill.sampled = false;
+        fill.invalidated = false;
+    }
+    this->fillJobs = new JobSystem(CLIPMAP_FILL_WORKER_COUNT);
+
+    glGenTextures(1, &this->textureArrayId);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, this->textureArrayId);
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_R32F, CLIPMAP_TEXTURE_SIZE, CLIPMAP_TEXTURE_SIZE,
+                 CLIPMAP_LEVEL_COUNT, 0, GL_RED, GL_FLOAT, nullptr);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+    std::vector<vertex_t> vertices;
+    std::vector<unsigned int> indices;
+
+    for ( int i = 0; i <= CLIPMAP_CELL_COUNT; i++ )
+        for ( int j = 0; j <= CLIPMAP_CELL_COUNT; j++ )
+            vertices.push_back({ (float) i, 0, (float) j, 0, 1, 0, 0, 0 });
+
+    // The finer level is aligned to the cells of this level, and starts either
+    // at CLIPMAP_CELL_COUNT / 4 or one cell further along each axis.
+    for ( int variant = 0; variant < 5; variant++ ) {
+        this->indexOffsets[ variant ] = (GLsizei) indices.size();
+        if ( variant == 0 )
+            addCells(indices, -1, -1);
+        else
+            addCells(indices, CLIPMAP_CELL_COUNT / 4 + (( variant - 1 ) & 1 ),
+                     CLIPMAP_CELL_COUNT / 4 + (( variant - 1 ) >> 1 ));
+        this->indexCounts[ variant ] = (GLsizei) indices.size() - this->indexOffsets[ variant ];
+    }
+
+    this->grid = new VBO();
+    this->grid->withVertices(vertices);
+    this->grid->withIndices(indices);
+    this->grid->build();
+
+    glGenBuffers(1, &this->instanceBufferId);
+    this->grid->withInstanceAttribute(this->instanceBufferId, VBO_INSTANCE_DATA_INDEX, 3,
+                                      sizeof(clipmap_instance_t), offsetof(clipmap_instance_t, grid_x));
+}
+
+Clipmap::~Clipmap()
+{
+    // Wait for the fills that are being sampled, before their buffers are gone
+    delete this->fillJobs;
+    glDeleteTextures(1, &this->textureArrayId);
+    glDeleteBuffers(1, &this->instanceBufferId);
+    delete this->grid;
+}
+
+/**
+ * Samples a rectangle of grid coordinates of a level, row by row.
+ * Safe to call from any thread.
+ */
+void Clipmap::sampleRegion(int level, int32_t gridX, int32_t gridZ, int32_t width, int32_t depth,
+                           float *samples) const
+{
+    float levelCellSize = this->cellSize * (float) ( 1 << level );
+    for ( int32_t j = 0; j < depth; j++ ) {
+        for ( int32_t i = 0; i < width; i++ ) {
+            samples[ j * width + i ] = this->heightFunction((float) ( gridX + i ) * levelCellSize + this->gridOffset,
+                                                            (float) ( gridZ + j ) * levelCellSize + this->gridOffset);
+        }
+    }
+}
+
+/**
+ * Uploads a rectangle of samples of a level.
+ * The rectangle is split where it wraps around the edges of the texture.
+ */
+void Clipmap::uploadRegion(int level, int32_t gridX, int32_t gridZ, int32_t width, int32_t depth,
+                           const float *samples, int32_t rowLength)
+{
+    const int32_t mask = CLIPMAP_TEXTURE_SIZE - 1;
+
+    glBindTexture(GL_TEXTURE_2D_ARRAY, this->textureArrayId);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, rowLength);
+
+    for ( int32_t z = gridZ; z < gridZ + depth; ) {
+        int32_t textureZ = z & mask;
+        int32_t partDepth = std::min(gridZ + depth - z, CLIPMAP_TEXTURE_SIZE - textureZ);
+
+        for ( int32_t x = gridX; x < gridX + width; ) {
+            int32_t textureX = x & mask;
+            int32_t partWidth = std::min(gridX + width - x, CLIPMAP_TEXTURE_SIZE - textureX);
+
+            glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, textureX, textureZ, level, partWidth, partDepth, 1,
+                            GL_RED, GL_FLOAT, samples + ( z - gridZ ) * rowLength + ( x - gridX ));
+            RenderStats::add(RENDER_STAT_UPLOAD_BYTES, sizeof(float) * partWidth * partDepth);
+            x += partWidth;
+        }
+        z += partDepth;
+    }
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+}
+
+/**
+ * Samples and uploads a rectangle of grid coordinates of a level.
+ */
+void Clipmap::updateRegion(int level, int32_t gridX, int32_t gridZ, int32_t width, int32_t depth)
+{
+    this->uploadBuffer.resize(width * depth);
+    this->sampleRegion(level, gridX, gridZ, width, depth, this->uploadBuffer.data());
+    this->uploadRegion(level, gridX, gridZ, width, depth, this->uploadBuffer.data(), width);
+}
+
+void Clipmap::refreshRegion(int level, int32_t minX, int32_t minZ, int32_t maxX, int32_t maxZ)
+{
+    const clipmap_level_t &current = this->levels[ level ];
+    minX = std::max(minX, current.origin_x - 1);
+    minZ = std::max(minZ, current.origin_z - 1);
+    maxX = std::min(maxX, current.origin_x - 2 + CLIPMAP_LEVEL_SAMPLES);
+    maxZ = std::min(maxZ, current.origin_z - 2 + CLIPMAP_LEVEL_SAMPLES);
+    if ( minX <= maxX && minZ <= maxZ )
+        this->updateRegion(level, minX, minZ, maxX - minX + 1, maxZ - minZ + 1);
+}
+
+/**
+ * Moves a level to a new origin. Only the samples that weren't
+ * within the previous bounds of the level are calculated.
+ */
+void Clipmap::updateLevel(int level, int32_t originX, int32_t originZ)
+{
+    clipmap_level_t &current = this->levels[ level ];
+    clipmap_fill_t &fill = this->fills[ level ];
+
+    const int32_t size = CLIPMAP_LEVEL_SAMPLES;
+
+    // A finished fill replaces the level, after which it's moved the rest of the way like any other level
+    if ( fill.pending && fill.sampled ) {
+        this->uploadRegion(level, fill.origin_x - 1, fill.origin_z - 1, size, size, fill.samples.data(), size);
+        current.origin_x = fill.origin_x;
+        current.origin_z = fill.origin_z;
+        current.valid = true;
+        fill.pending = false;
+
+        // The fill might have sampled the terrain before it changed
+        if ( fill.invalidated ) {
+            fill.invalidated = false;
+            this->refreshRegion(level, fill.invalid_min_x, fill.invalid_min_z, fill.invalid_max_x,
+                                fill.invalid_max_z);
+        }
+    }
+
+    int32_t deltaX = originX - current.origin_x;
+    int32_t deltaZ = originZ - current.origin_z;
+
+    if ( current.valid && deltaX == 0 && deltaZ == 0 )
+        return;
+
+    if ( !current.valid || std::abs(deltaX) >= size || std::abs(deltaZ) >= size ) {
+        // Fill the level in the background, it isn't drawn until the fill has been uploaded.
+        // A new fill is only started once the previous one has been uploaded.
+        current.valid = false;
+        if ( fill.pending )
+            return;
+        fill.pending = true;
+        fill.sampled = false;
+        fill.origin_x = originX;
+        fill.origin_z = originZ;
+        fill.samples.resize(size * size);
+        this->fillJobs->submit([this, level, &fill] {
+            this->sampleRegion(level, fill.origin_x - 1, fill.origin_z - 1, CLIPMAP_LEVEL_SAMPLES,
+                               CLIPMAP_LEVEL_SAMPLES, fill.samples.data());
+            fill.sampled = true;
+        });
+        return;
+    }
+
+    // Columns that came into view, over the full new depth
+    if ( deltaX > 0 )
+        this->updateRegion(level, originX - 1 + size - deltaX, originZ - 1, deltaX, size);
+    else if ( deltaX < 0 )
+        this->updateRegion(level, originX - 1, originZ - 1, -deltaX, size);
+
+    // Rows that came into view, skipping the columns that were just updated
+    int32_t columnsX = deltaX > 0 ? originX - 1 : originX - 1 - deltaX;
+    int32_t columns = size - std::abs(deltaX);
+    if ( deltaZ > 0 )
+        this->updateRegion(level, columnsX, originZ - 1 + size - deltaZ, columns, deltaZ);
+    else if ( deltaZ < 0 )
+        this->updateRegion(level, columnsX, originZ - 1, columns, -deltaZ);
+
+    current.origin_x = originX;
+    current.origin_z = originZ;
+    current.valid = true;
+}
+
+void Clipmap::update(glm::vec3 cameraPosition)
+{
+    for ( int level = 0; level < CLIPMAP_LEVEL_COUNT; level++ ) {
+        float levelCellSize = this->cellSize * (float) ( 1 << level );
+
+        // Snap to two cells, so the origin of the finer level always lies on a cell of this level
+        int32_t originX = 2 * (int32_t) std::floor(( cameraPosition.x - this->gridOffset ) / ( 2 * levelCellSize ))
+                          - CLIPMAP_CELL_COUNT / 2;
+        int32_t originZ = 2 * (int32_t) std::floor(( cameraPosition.z - this->gridOffset ) / ( 2 * levelCellSize ))
+                          - CLIPMAP_CELL_COUNT / 2;
+        this->updateLevel(level, originX, originZ);
+    }
+}
+
+void Clipmap::invalidate(int32_t minX, int32_t minZ, int32_t maxX, int32_t maxZ)
+{
+    for ( int level = 0; level < CLIPMAP_LEVEL_COUNT; level++ ) {
+        // A level only samples every (1 << level)th grid coordinate of the finest level
+        int32_t levelMinX = -( -minX >> level );
+        int32_t levelMinZ = -( -minZ >> level );
+        int32_t levelMaxX = maxX >> level;
+        int32_t levelMaxZ = maxZ >> level;
+        if ( levelMinX > levelMaxX || levelMinZ > levelMaxZ )
+            continue;
+
+        clipmap_fill_t &fill = this->fills[ level ];
+        if ( fill.pending ) {
+            if ( fill.invalidated ) {
+                levelMinX = std::min(levelMinX, fill.invalid_min_x);
+                levelMinZ = std::min(levelMinZ, fill.invalid_min_z);
+                levelMaxX = std::max(levelMaxX, fill.invalid_max_x);
+                levelMaxZ = std::max(levelMaxZ, fill.invalid_max_z);
+            }
+            fill.invalidated = true;
+            fill.invalid_min_x = levelMinX;
+            fill.invalid_min_z = levelMinZ;
+            fill.invalid_max_x = levelMaxX;
+            fill.invalid_max_z = levelMaxZ;
+        }
+        if ( this->levels[ level ].valid )
+            this->refreshRegion(level, levelMinX, levelMinZ, levelMaxX, levelMaxZ);
+    }
+}
+
+void Clipmap::draw()
+{
+    std::vector<clipmap_instance_t> variantInstances[5];
+
+    for ( int level = 0; level < CLIPMAP_LEVEL_COUNT; level++ ) {
+        clipmap_level_t &current = this->levels[ level ];
+        if ( !current.valid )
+            break;
+
+        int variant = 0;
+        if ( level > 0 ) {
+            clipmap_level_t &finer = this->levels[ level - 1 ];
+            int holeX = finer.origin_x / 2 - current.origin_x - CLIPMAP_CELL_COUNT / 4;
+            int holeZ = finer.origin_z / 2 - current.origin_z - CLIPMAP_CELL_COUNT / 4;
+            variant = 1 + holeX + holeZ * 2;
+        }
+        variantInstances[ variant ].push_back({
+                (float) current.origin_x, (float) current.origin_z, (float) level
+        });
+    }
+
+    glActiveTexture(GL_TEXTURE0 + HEIGHTMAP_TERRAIN_TEXTURE_UNIT);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, this->textureArrayId);
+
+    for ( int variant = 0; variant < 5; variant++ ) {
+        std::vector<clipmap_instance_t> &instances = variantInstances[ variant ];
+        if ( instances.empty())
+            continue;
+
+        // Orphan the previous storage, the previous variant might still be reading from it.
+        glBindBuffer(GL_ARRAY_BUFFER, this->instanceBufferId);
+        glBufferData(GL_ARRAY_BUFFER, CLIPMAP_LEVEL_COUNT * sizeof(clipmap_instance_t), nullptr, GL_STREAM_DRAW);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, instances.size() * sizeof(clipmap_instance_t), instances.data());
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        RenderStats::add(RENDER_STAT_UPLOAD_BYTES, instances.size() * sizeof(clipmap_instance_t));
+
+        this->grid->drawInstanced((GLsizei) instances.size(), this->indexCounts[ variant ],
+                                  this->indexOffsets[ variant ]);
+    }
+
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+    glActiveTexture(GL_TEXTURE0);
+}
+
+float Clipmap::getViewDistance() const
+{
+    return (float) ( CLIPMAP_CELL_COUNT / 2 - 1 ) * this->cellSize * (float) ( 1 << ( CLIPMAP_LEVEL_COUNT - 1 ));
+}
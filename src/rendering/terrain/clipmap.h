@@ -0,0 +1,181 @@
+//
+// Created by Luca Warmenhoven on 17/10/2026.
+//
+
+#ifndef GRAPHICS_TEST_CLIPMAP_H
+#define GRAPHICS_TEST_CLIPMAP_H
+
+#include <atomic>
+#include <functional>
+#include <vector>
+#include "../renderer.h"
+#include "../../threading/job_system.h"
+#include "../vbo.h"
+#include "heightmap_terrain.h" // The clipmap is bound to the same texture unit as the height map terrain
+
+// The amount of nested levels, every level has twice the cell size of the previous one
+#define CLIPMAP_LEVEL_COUNT (8)
+
+// The amount of cells along each side of a level. Must be a multiple of 4,
+// so the finer level is always aligned to the cells of the coarser level.
+#define CLIPMAP_CELL_COUNT (252)
+
+// The size of the toroidal height texture of every level. Must be a power of two
+// that fits the vertices of a level plus a one sample wide apron for the normals.
+#define CLIPMAP_TEXTURE_SIZE (256)
+
+// The amount of cells of a level covered by the next finer level
+#define CLIPMAP_HOLE_CELL_COUNT (CLIPMAP_CELL_COUNT / 2)
+
+// The amount of samples along each side of a level, including the apron
+#define CLIPMAP_LEVEL_SAMPLES (CLIPMAP_CELL_COUNT + 3)
+
+// The workers that sample levels which have to be filled entirely
+#define CLIPMAP_FILL_WORKER_COUNT (2)
+
+/**
+ * Function that provides the terrain height at a world space coordinate.
+ * It's called from the fill workers as well, so it has to be safe to call from any thread.
+ */
+typedef std::function<float(float x, float z)> clipmap_height_function_t;
+
+typedef struct {
+    int32_t origin_x;   // Grid coordinates of vertex (0, 0), in cells of this level
+    int32_t origin_z;
+    bool valid;         // Whether the height texture holds the samples around the origin
+} clipmap_level_t;
+
+/**
+ * The samples of a level that is filled entirely, sampled by a fill worker.
+ */
+typedef struct {
+    std::vector<float> samples; // CLIPMAP_LEVEL_SAMPLES^2, starting one sample before the origin
+    int32_t origin_x;
+    int32_t origin_z;
+    bool pending;               // Whether a fill has been submitted and not uploaded yet
+    std::atomic<bool> sampled;
+    bool invalidated;           // Whether the terrain changed while the fill was pending
+    int32_t invalid_min_x;      // The grid coordinates of the changed rectangle, inclusive
+    int32_t invalid_min_z;
+    int32_t invalid_max_x;
+    int32_t invalid_max_z;
+} clipmap_fill_t;
+
+/**
+ * Per-instance data of a drawn level.
+ */
+typedef struct {
+    float grid_x, grid_z;   // The origin of the level, in cells of that level
+    float level;
+} clipmap_instance_t;
+
+/**
+ * Geometry clipmap terrain renderer.
+ *
+ * The terrain around the camera is drawn as a set of nested, camera-centred grids,
+ * where every level has twice the cell size of the previous one and leaves a hole
+ * for the finer level inside it. The heights of every level live in a layer of a
+ * texture array that is addressed toroidally, so when the camera moves only the rows
+ * and columns that come into view have to be sampled and uploaded.
+ * The cost per frame therefore doesn't depend on the view distance.
+ */
+class Clipmap
+{
+
+private:
+
+    clipmap_height_function_t heightFunction;
+
+    /** The cell size of the finest level */
+    float cellSize;
+
+    /** World space offset of grid coordinate 0 */
+    float gridOffset;
+
+    clipmap_level_t levels[CLIPMAP_LEVEL_COUNT];
+
+    GLuint textureArrayId;
+
+    /** Shared grid of (CLIPMAP_CELL_COUNT + 1)^2 vertices */
+    VBO *grid;
+
+    /**
+     * The index buffer contains the full grid, followed by four rings with the
+     * hole for the finer level at each of the possible offsets.
+     */
+    GLsizei indexOffsets[5];
+    GLsizei indexCounts[5];
+
+    GLuint instanceBufferId;
+
+    std::vector<float> uploadBuffer;
+
+    /**
+     * The levels that have to be filled entirely, when the camera first appears or jumps,
+     * are sampled by these workers, so the thread owning the context doesn't stall.
+     */
+    JobSystem *fillJobs;
+    clipmap_fill_t fills[CLIPMAP_LEVEL_COUNT];
+
+    void sampleRegion(int level, int32_t gridX, int32_t gridZ, int32_t width, int32_t depth, float *samples) const;
+
+    /**
+     * Uploads a rectangle of samples, which starts at `samples` in a buffer with rows of `rowLength` samples.
+     */
+    void uploadRegion(int level, int32_t gridX, int32_t gridZ, int32_t width, int32_t depth,
+                      const float *samples, int32_t rowLength);
+
+    void updateRegion(int level, int32_t gridX, int32_t gridZ, int32_t width, int32_t depth);
+
+    /**
+     * Samples the part of a rectangle of grid coordinates that lies within the level again, bounds inclusive.
+     */
+    void refreshRegion(int level, int32_t minX, int32_t minZ, int32_t maxX, int32_t maxZ);
+
+    void updateLevel(int level, int32_t originX, int32_t originZ);
+
+public:
+
+    /**
+     * @param heightFunction The function that provides the terrain heights.
+     * @param cellSize The cell size of the finest level.
+     * @param gridOffset The world space offset of grid coordinate 0,
+     *                   so the finest level can be aligned with other terrain grids.
+     */
+    Clipmap(const clipmap_height_function_t &heightFunction, float cellSize, float gridOffset);
+
+    ~Clipmap();
+
+    /**
+     * Moves the levels to the camera, sampling the heights that came into view.
+     * Levels that have to be filled entirely are sampled in the background, and
+     * appear in one of the following calls. Until then the previous samples stay in place.
+     * This must be called from the thread that owns the OpenGL context.
+     */
+    void update(glm::vec3 cameraPosition);
+
+    /**
+     * Samples the heights of a rectangle again, after the terrain within it changed.
+     * Levels that are being filled sample the rectangle again once their fill has been uploaded.
+     * This must be called from the thread that owns the OpenGL context.
+     *
+     * @param minX The first grid coordinate along x of the finest level
+     * @param minZ The first grid coordinate along z of the finest level
+     * @param maxX The last grid coordinate along x of the finest level, inclusive
+     * @param maxZ The last grid coordinate along z of the finest level, inclusive
+     */
+    void invalidate(int32_t minX, int32_t minZ, int32_t maxX, int32_t maxZ);
+
+    /**
+     * Draws all levels.
+     * The shader and its uniforms have to be set up by the caller.
+     */
+    void draw();
+
+    /**
+     * Get the distance from the camera to the nearest edge of the coarsest level.
+     */
+    float getViewDistance() const;
+};
+
+#endif //GRAPHICS_TEST_CLIPMAP_H
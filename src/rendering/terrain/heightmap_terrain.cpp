@@ -0,0 +1,149 @@
+//
+// Created by Luca Warmenhoven on 17/10/2026.
+//
+
+#include "heightmap_terrain.h"
+#include "../render_stats.h"
+
+HeightmapTerrain::HeightmapTerrain(int gridSize)
+{
+    this->gridSize = gridSize;
+    this->textureSize = gridSize + 2;
+    this->instanceBufferCapacity = 0;
+
+    // The grid only carries the coordinates of its vertices in grid cells,
+    // the heights and normals are calculated in the vertex shader.
+    std::vector<vertex_t> vertices;
+    std::vector<unsigned int> indices;
+    int i, j;
+
+    for ( i = 0; i < gridSize; i++ )
+        for ( j = 0; j < gridSize; j++ )
+            vertices.push_back({ (float) i, 0, (float) j, 0, 1, 0, 0, 0 });
+
+    for ( i = 0; i < gridSize - 1; i++ ) {
+        for ( j = 0; j < gridSize - 1; j++ ) {
+            indices.push_back(i * gridSize + j);
+            indices.push_back(i * gridSize + j + 1);
+            indices.push_back(( i + 1 ) * gridSize + j);
+
+            indices.push_back(i * gridSize + j + 1);
+            indices.push_back(( i + 1 ) * gridSize + j + 1);
+            indices.push_back(( i + 1 ) * gridSize + j);
+        }
+    }
+
+    this->grid = new VBO();
+    this->grid->withVertices(vertices);
+    this->grid->withIndices(indices);
+    this->grid->build();
+
+    glGenBuffers(1, &this->instanceBufferId);
+    this->grid->withInstanceAttribute(this->instanceBufferId, VBO_INSTANCE_DATA_INDEX, 3,
+                                      sizeof(heightmap_instance_t), offsetof(heightmap_instance_t, x));
+}
+
+HeightmapTerrain::~HeightmapTerrain()
+{
+    glDeleteTextures((GLsizei) this->pages.size(), this->pages.data());
+    glDeleteBuffers(1, &this->instanceBufferId);
+    delete this->grid;
+}
+
+int HeightmapTerrain::getTextureSize() const
+{
+    return this->textureSize;
+}
+
+void HeightmapTerrain::addPage()
+{
+    GLuint textureId;
+    int page = (int) this->pages.size();
+
+    glGenTextures(1, &textureId);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, textureId);
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_R32F, this->textureSize, this->textureSize,
+                 HEIGHTMAP_TERRAIN_LAYERS_PER_PAGE, 0, GL_RED, GL_FLOAT, nullptr);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+    this->pages.push_back(textureId);
+    this->pageInstances.emplace_back();
+
+    // Push the slots in reverse, so the lowest layers are handed out first
+    for ( int layer = HEIGHTMAP_TERRAIN_LAYERS_PER_PAGE - 1; layer >= 0; layer-- )
+        this->freeSlots.push_back(page * HEIGHTMAP_TERRAIN_LAYERS_PER_PAGE + layer);
+}
+
+int HeightmapTerrain::allocate(const float *heights)
+{
+    if ( this->freeSlots.empty())
+        this->addPage();
+
+    int slot = this->freeSlots.back();
+    this->freeSlots.pop_back();
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, this->pages[ slot / HEIGHTMAP_TERRAIN_LAYERS_PER_PAGE ]);
+    glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, slot % HEIGHTMAP_TERRAIN_LAYERS_PER_PAGE,
+                    this->textureSize, this->textureSize, 1, GL_RED, GL_FLOAT, heights);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+    RenderStats::add(RENDER_STAT_UPLOAD_BYTES, sizeof(float) * this->textureSize * this->textureSize);
+    return slot;
+}
+
+void HeightmapTerrain::update(int slot, const float *heights, int s, int t, int width, int depth)
+{
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, this->pages[ slot / HEIGHTMAP_TERRAIN_LAYERS_PER_PAGE ]);
+    glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, s, t, slot % HEIGHTMAP_TERRAIN_LAYERS_PER_PAGE,
+                    width, depth, 1, GL_RED, GL_FLOAT, heights);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+    RenderStats::add(RENDER_STAT_UPLOAD_BYTES, sizeof(float) * width * depth);
+}
+
+void HeightmapTerrain::release(int slot)
+{
+    if ( slot < 0 )
+        return;
+    this->freeSlots.push_back(slot);
+}
+
+void HeightmapTerrain::submit(int slot, float x, float z)
+{
+    this->pageInstances[ slot / HEIGHTMAP_TERRAIN_LAYERS_PER_PAGE ].push_back({
+            x, z, (float) ( slot % HEIGHTMAP_TERRAIN_LAYERS_PER_PAGE )
+    });
+}
+
+void HeightmapTerrain::flush()
+{
+    glActiveTexture(GL_TEXTURE0 + HEIGHTMAP_TERRAIN_TEXTURE_UNIT);
+
+    for ( size_t page = 0; page < this->pages.size(); page++ ) {
+        std::vector<heightmap_instance_t> &instances = this->pageInstances[ page ];
+        if ( instances.empty())
+            continue;
+
+        glBindBuffer(GL_ARRAY_BUFFER, this->instanceBufferId);
+
+        // Orphan the previous storage, the previous page might still be reading from it.
+        if ( instances.size() > this->instanceBufferCapacity )
+            this->instanceBufferCapacity = std::max(instances.size(), this->instanceBufferCapacity * 2);
+        glBufferData(GL_ARRAY_BUFFER, this->instanceBufferCapacity * sizeof(heightmap_instance_t), nullptr,
+                     GL_STREAM_DRAW);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, instances.size() * sizeof(heightmap_instance_t), instances.data());
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        RenderStats::add(RENDER_STAT_UPLOAD_BYTES, instances.size() * sizeof(heightmap_instance_t));
+
+        glBindTexture(GL_TEXTURE_2D_ARRAY, this->pages[ page ]);
+        this->grid->drawInstanced((GLsizei) instances.size());
+        instances.clear();
+    }
+
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+    glActiveTexture(GL_TEXTURE0);
+}
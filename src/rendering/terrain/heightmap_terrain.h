@@ -0,0 +1,120 @@
+//
+// Created by Luca Warmenhoven on 17/10/2026.
+//
+
+#ifndef GRAPHICS_TEST_HEIGHTMAP_TERRAIN_H
+#define GRAPHICS_TEST_HEIGHTMAP_TERRAIN_H
+
+#include <vector>
+#include "../renderer.h"
+#include "../vbo.h"
+
+// The amount of layers per texture array. OpenGL 3.3 guarantees at least 256.
+#define HEIGHTMAP_TERRAIN_LAYERS_PER_PAGE (256)
+
+#define HEIGHTMAP_TERRAIN_TEXTURE_UNIT (4)
+
+/**
+ * Per-instance data of a drawn chunk.
+ */
+typedef struct {
+    float x, z;     // World space position of the first vertex of the chunk
+    float layer;    // The layer of the chunk in the texture array of its page
+} heightmap_instance_t;
+
+/**
+ * Terrain renderer that only keeps the height grid of every chunk on the GPU.
+ *
+ * The height grids are stored as layers of R32F texture arrays ("pages").
+ * A single grid mesh is shared by all chunks and drawn instanced, once per page.
+ * The vertex shader fetches the height from the texture array and calculates
+ * the normal from the neighbouring samples.
+ */
+class HeightmapTerrain
+{
+
+private:
+
+    /** The amount of vertices along each side of the grid */
+    int gridSize;
+
+    /**
+     * The size of a texture layer. The grid is surrounded by a one sample wide apron,
+     * so the normals at the borders can be calculated without the neighbouring chunks.
+     */
+    int textureSize;
+
+    /** The texture arrays */
+    std::vector<GLuint> pages;
+
+    /** Unused slots, a slot being page * HEIGHTMAP_TERRAIN_LAYERS_PER_PAGE + layer */
+    std::vector<int> freeSlots;
+
+    /** The instances that have been submitted since the last flush, per page */
+    std::vector<std::vector<heightmap_instance_t>> pageInstances;
+
+    /** The shared grid mesh */
+    VBO *grid;
+
+    GLuint instanceBufferId;
+    size_t instanceBufferCapacity;
+
+    void addPage();
+
+public:
+
+    /**
+     * @param gridSize The amount of vertices along each side of a chunk.
+     */
+    explicit HeightmapTerrain(int gridSize);
+
+    ~HeightmapTerrain();
+
+    /**
+     * Get the size of the height grids that are passed to `allocate`,
+     * which is the grid size including the apron on both sides.
+     */
+    int getTextureSize() const;
+
+    /**
+     * Uploads a height grid into a free texture layer.
+     * This must be called from the thread that owns the OpenGL context.
+     *
+     * @param heights textureSize^2 samples, where the height of grid vertex (i, j)
+     *                is stored at [(j + 1) * textureSize + (i + 1)].
+     * @return The slot the heights were uploaded to.
+     */
+    int allocate(const float *heights);
+
+    /**
+     * Replaces a rectangle of the height grid in a slot.
+     * This must be called from the thread that owns the OpenGL context.
+     *
+     * @param heights width * depth samples, where the sample at texel (s, t) is stored at [t * width + s].
+     * @param s The first texel along the rows, which is grid vertex i + 1
+     * @param t The first row, which is grid vertex j + 1
+     */
+    void update(int slot, const float *heights, int s, int t, int width, int depth);
+
+    /**
+     * Releases a slot, so it can be reused by another chunk.
+     */
+    void release(int slot);
+
+    /**
+     * Submits a chunk for drawing during the next flush.
+     *
+     * @param slot The slot of the chunk
+     * @param x The world space x coordinate of the first vertex
+     * @param z The world space z coordinate of the first vertex
+     */
+    void submit(int slot, float x, float z);
+
+    /**
+     * Draws all submitted chunks with one instanced draw call per page.
+     * The shader and its uniforms have to be set up by the caller.
+     */
+    void flush();
+};
+
+#endif //GRAPHICS_TEST_HEIGHTMAP_TERRAIN_H
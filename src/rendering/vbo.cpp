@@ -3,6 +3,18 @@
 //
 
 #include "vbo.h"
+#include "render_stats.h"
+
+/*
+ * Counts a draw call and the triangles it submits, other primitives add no triangles.
+ */
+static void countDraw(unsigned int renderingMode, GLsizei indexCount, GLsizei instanceCount)
+{
+    RenderStats::add(RENDER_STAT_DRAW_CALLS);
+    RenderStats::add(RENDER_STAT_VAO_BINDS);
+    if ( renderingMode == GL_TRIANGLES )
+        RenderStats::add(RENDER_STAT_TRIANGLES, (uint64_t) ( indexCount / 3 ) * instanceCount);
+}
 
 VBO::VBO()
 {
@@ -31,6 +43,7 @@ void VBO::withVertices(vertex_t *vertices, unsigned long vertexCount)
     glBindBuffer(GL_ARRAY_BUFFER, this->vboBufferId);
     glBufferData(GL_ARRAY_BUFFER, vertexCount * sizeof(vertex_t), vertices, GL_STATIC_DRAW);
     glBindBuffer(GL_ARRAY_BUFFER, 0);
+    RenderStats::add(RENDER_STAT_UPLOAD_BYTES, vertexCount * sizeof(vertex_t));
 }
 
 /** Supply the VBO with vertices */
@@ -39,6 +52,15 @@ void VBO::withVertices(std::vector<vertex_t> vertices)
     this->withVertices(vertices.data(), vertices.size());
 }
 
+void VBO::updateVertices(vertex_t *vertices, unsigned long firstVertex, unsigned long vertexCount)
+{
+    glBindBuffer(GL_ARRAY_BUFFER, this->vboBufferId);
+    glBufferSubData(GL_ARRAY_BUFFER, (GLintptr) ( firstVertex * sizeof(vertex_t)),
+                    (GLsizeiptr) ( vertexCount * sizeof(vertex_t)), vertices);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    RenderStats::add(RENDER_STAT_UPLOAD_BYTES, vertexCount * sizeof(vertex_t));
+}
+
 void VBO::withIndices(unsigned int *indices, unsigned long indicesCount)
 {
     if ( indicesCount == 0 )
@@ -46,6 +68,7 @@ void VBO::withIndices(unsigned int *indices, unsigned long indicesCount)
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, this->eboBufferId);
     glBufferData(GL_ELEMENT_ARRAY_BUFFER, indicesCount * sizeof(int), indices, GL_STATIC_DRAW);
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    RenderStats::add(RENDER_STAT_UPLOAD_BYTES, indicesCount * sizeof(int));
     this->size = (GLsizei) indicesCount;
 }
 
@@ -55,6 +78,26 @@ void VBO::withIndices(std::vector<unsigned int> indices)
     this->withIndices(indices.data(), indices.size());
 }
 
+void VBO::reserve(unsigned long vertexCapacity, unsigned long indexCapacity)
+{
+    glBindBuffer(GL_ARRAY_BUFFER, this->vboBufferId);
+    glBufferData(GL_ARRAY_BUFFER, vertexCapacity * sizeof(vertex_t), nullptr, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, this->eboBufferId);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexCapacity * sizeof(int), nullptr, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    this->size = 0;
+}
+
+void VBO::updateIndices(unsigned int *indices, unsigned long indicesCount)
+{
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, this->eboBufferId);
+    glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, (GLsizeiptr) ( indicesCount * sizeof(int)), indices);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    RenderStats::add(RENDER_STAT_UPLOAD_BYTES, indicesCount * sizeof(int));
+    this->size = (GLsizei) indicesCount;
+}
+
 
 /**
  * Build the VBO using VAOs
@@ -82,10 +125,62 @@ void VBO::build()
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 }
 
+/**
+ * Attach the per-instance model matrices to the VAO.
+ * A mat4 attribute takes up four consecutive attribute locations, one per column.
+ */
+void VBO::withInstanceBuffer(GLuint instanceBufferId)
+{
+    glBindVertexArray(this->vaoId);
+    glBindBuffer(GL_ARRAY_BUFFER, instanceBufferId);
+
+    for ( int column = 0; column < 4; column++ ) {
+        glEnableVertexAttribArray(VBO_INSTANCE_MATRIX_INDEX + column);
+        glVertexAttribPointer(VBO_INSTANCE_MATRIX_INDEX + column, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4),
+                              (GLvoid *) ( sizeof(glm::vec4) * column ));
+        glVertexAttribDivisor(VBO_INSTANCE_MATRIX_INDEX + column, 1);
+    }
+
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void VBO::withInstanceAttribute(GLuint instanceBufferId, GLuint index, GLint components, GLsizei stride,
+                                size_t offset)
+{
+    glBindVertexArray(this->vaoId);
+    glBindBuffer(GL_ARRAY_BUFFER, instanceBufferId);
+
+    glEnableVertexAttribArray(index);
+    glVertexAttribPointer(index, components, GL_FLOAT, GL_FALSE, stride, (GLvoid *) offset);
+    glVertexAttribDivisor(index, 1);
+
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void VBO::drawInstanced(GLsizei instanceCount)
+{
+    glBindVertexArray(this->vaoId);
+    glDrawElementsInstanced(this->renderingMode, this->size, GL_UNSIGNED_INT, 0, instanceCount);
+    glBindVertexArray(0);
+    countDraw(this->renderingMode, this->size, instanceCount);
+}
+
+void VBO::drawInstanced(GLsizei instanceCount, GLsizei indexCount, GLsizei firstIndex)
+{
+    glBindVertexArray(this->vaoId);
+    glDrawElementsInstanced(this->renderingMode, indexCount, GL_UNSIGNED_INT,
+                            (GLvoid *) ( firstIndex * sizeof(unsigned int)), instanceCount);
+    glBindVertexArray(0);
+    countDraw(this->renderingMode, indexCount, instanceCount);
+}
+
 void VBO::draw(float deltaTime)
 {
     glBindVertexArray(this->vaoId);
     glDrawElements(this->renderingMode, this->size, GL_UNSIGNED_INT, 0);
     glBindVertexArray(0);
+    countDraw(this->renderingMode, this->size, 1);
 }
 
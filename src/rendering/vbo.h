@@ -114,15 +114,83 @@ public:
      */
     void withIndices(unsigned int *indices, unsigned long indicesCount);
 
+    /**
+     * Method for replacing a range of the vertices of the VBO, without reallocating its buffer.
+     * The range has to lie within the vertices supplied by `withVertices`.
+     *
+     * @param vertices The new vertices.
+     * @param firstVertex The index of the first vertex to replace.
+     * @param vertexCount The amount of vertices to replace.
+     */
+    void updateVertices(vertex_t *vertices, unsigned long firstVertex, unsigned long vertexCount);
+
+    /**
+     * Method for allocating the buffers of the VBO without supplying any mesh_data,
+     * for VBOs of which the mesh is written with `updateVertices` and `updateIndices`.
+     * Nothing is drawn until indices are supplied.
+     *
+     * @param vertexCapacity The amount of vertices the vertex buffer can hold.
+     * @param indexCapacity The amount of indices the element buffer can hold.
+     */
+    void reserve(unsigned long vertexCapacity, unsigned long indexCapacity);
+
+    /**
+     * Method for replacing the indices of the VBO, without reallocating its buffer.
+     * Only the supplied indices are drawn afterwards, so the mesh can shrink and grow
+     * within the capacity of the buffer.
+     *
+     * @param indices The new indices.
+     * @param indicesCount The amount of indices, at most the amount the buffer can hold.
+     */
+    void updateIndices(unsigned int *indices, unsigned long indicesCount);
+
     /**
      * Build the VBO.
      */
     void build();
 
+    /**
+     * Method for attaching a buffer with per-instance model matrices to the VBO.
+     * The VBO must have been built before calling this method.
+     * Only one instance buffer can be attached at a time.
+     *
+     * @param instanceBufferId The buffer containing a glm::mat4 per instance.
+     */
+    void withInstanceBuffer(GLuint instanceBufferId);
+
+    /**
+     * Method for attaching a single per-instance float attribute to the VBO.
+     * The VBO must have been built before calling this method.
+     *
+     * @param instanceBufferId The buffer containing the per-instance data.
+     * @param index The attribute location.
+     * @param components The amount of floats of the attribute.
+     * @param stride The size of the data of a single instance.
+     * @param offset The offset of the attribute within the data of an instance.
+     */
+    void withInstanceAttribute(GLuint instanceBufferId, GLuint index, GLint components, GLsizei stride, size_t offset);
+
     /**
      * Render the VBO onto the screen.
      */
     void draw(float deltaTime);
+
+    /**
+     * Render multiple instances of the VBO onto the screen in a single draw call.
+     * An instance buffer has to be attached using `withInstanceBuffer`.
+     *
+     * @param instanceCount The amount of instances to draw.
+     */
+    void drawInstanced(GLsizei instanceCount);
+
+    /**
+     * Render multiple instances of a range of the indices of the VBO.
+     *
+     * @param instanceCount The amount of instances to draw.
+     * @param indexCount The amount of indices to draw.
+     * @param firstIndex The index to start drawing from.
+     */
+    void drawInstanced(GLsizei instanceCount, GLsizei indexCount, GLsizei firstIndex);
 };
 
 #endif //GRAPHICS_TEST_VBO_H
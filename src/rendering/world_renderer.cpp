@@ -0,0 +1,574 @@
+//
+// Created by Luca Warmenhoven on 17/10/2026.
+//
+
+#include "world_renderer.h"
+#include "../world/terrain_generator.h"
+#include "render_stats.h"
+#include <cstring>
+#include <new>
+
+unsigned char WorldRenderer::terrainMeshingMode = TERRAIN_MESH_ADAPTIVE;
+unsigned char WorldRenderer::terrainRenderMode = TERRAIN_RENDER_MESH;
+bool WorldRenderer::pipelinedRendering = true;
+
+static_assert(sizeof(vbo_data_t) <= CHUNK_PAYLOAD_HEADER_SIZE, "The vbo_data_t doesn't fit in the payload header");
+
+WorldRenderer::WorldRenderer(World *world)
+{
+    this->world = world;
+
+    drawables = new std::vector<Drawable *>();
+    instancedRenderer = new InstancedRenderer();
+    createVegetationMeshes();
+    if ( terrainRenderMode == TERRAIN_RENDER_HEIGHTMAP )
+        heightmapTerrain = new HeightmapTerrain(CHUNK_SIZE + 1);
+    // The samples of the finest clipmap level lie on the height map cells. Those of the loaded chunks
+    // are read from the world, as they might have been edited, the terrain beyond them is generated.
+    if ( terrainRenderMode == TERRAIN_RENDER_CLIPMAP )
+        clipmap = new Clipmap([world](float x, float z) {
+            float height;
+            if ( world->getLoadedCellHeight((int32_t) std::lround(x / CHUNK_COORDINATE_SCALING_FACTOR + 0.5f),
+                                            (int32_t) std::lround(z / CHUNK_COORDINATE_SCALING_FACTOR + 0.5f),
+                                            height))
+                return height;
+            return TerrainGenerator::getHeight(x, z);
+        }, CHUNK_COORDINATE_SCALING_FACTOR, -0.5f * CHUNK_COORDINATE_SCALING_FACTOR);
+
+    size_t meshPayloadSize = CHUNK_PAYLOAD_HEADER_SIZE + sizeof(vertex_t) * CHUNK_MESH_MAX_VERTICES +
+                             sizeof(unsigned int) * CHUNK_MESH_MAX_INDICES;
+    renderDataPool = new SlabPool(sizeof(chunk_render_data_t), CHUNK_POOL_BLOCKS_PER_SLAB, World::hugePagePools);
+    payloadPool = new SlabPool(std::max(meshPayloadSize, sizeof(float) * CHUNK_HEIGHT_GRID_SAMPLES),
+                               CHUNK_POOL_BLOCKS_PER_SLAB, World::hugePagePools);
+    drawListJobs = new JobSystem(1);
+
+    world->setChunkListener(this);
+}
+
+inline bool shouldRenderChunk(chunk_t &chunk, Frustum *frustum)
+{
+    //return frustum->isWithin(vec3(chunk.x + offset, 0, chunk.z + offset), offset * 2);
+
+    return frustum->isWithin(vec3(chunk.x, 0, chunk.z),
+                             CHUNK_SIZE * CHUNK_COORDINATE_SCALING_FACTOR * 2);
+}
+
+/**
+ * Draws the mesh of a chunk, or submits it to the height map terrain renderer.
+ * The submitted chunks are drawn when the height map terrain renderer is flushed.
+ */
+void WorldRenderer::drawChunk(chunk_t *chunk)
+{
+    auto *render_data = (chunk_render_data_t *) chunk->listener_data;
+    if ( render_data->mesh )
+        render_data->mesh->draw(0);
+    else if ( render_data->heightmap_slot >= 0 )
+        heightmapTerrain->submit(render_data->heightmap_slot,
+                                 chunk->x - 0.5f * CHUNK_COORDINATE_SCALING_FACTOR,
+                                 chunk->z - 0.5f * CHUNK_COORDINATE_SCALING_FACTOR);
+}
+
+/**
+ * Whether the bounding box of a chunk intersects the volume of a light view-projection matrix.
+ * Chunks in front of the near plane are kept, as they can still cast shadows into the volume.
+ */
+static bool isChunkWithinLightVolume(chunk_t &chunk, glm::mat4 &lightViewProjectionMatrix)
+{
+    glm::vec3 minimum = glm::vec3(chunk.x - 0.5f * CHUNK_COORDINATE_SCALING_FACTOR, chunk.min_height,
+                                  chunk.z - 0.5f * CHUNK_COORDINATE_SCALING_FACTOR);
+    glm::vec3 maximum = minimum + glm::vec3(CHUNK_COORDINATE_SCALAR, chunk.max_height - chunk.min_height,
+                                            CHUNK_COORDINATE_SCALAR);
+    glm::vec3 clipMinimum = glm::vec3(INFINITY);
+    glm::vec3 clipMaximum = glm::vec3(-INFINITY);
+
+    for ( int i = 0; i < 8; i++ ) {
+        glm::vec4 corner = lightViewProjectionMatrix * glm::vec4(
+                i & 1 ? maximum.x : minimum.x,
+                i & 2 ? maximum.y : minimum.y,
+                i & 4 ? maximum.z : minimum.z, 1.0f);
+        clipMinimum = glm::min(clipMinimum, glm::vec3(corner));
+        clipMaximum = glm::max(clipMaximum, glm::vec3(corner));
+    }
+    return clipMaximum.x >= -1.0f && clipMinimum.x <= 1.0f &&
+           clipMaximum.y >= -1.0f && clipMinimum.y <= 1.0f &&
+           clipMinimum.z <= 1.0f;
+}
+
+void WorldRenderer::renderShadowCasters(glm::mat4 lightViewProjectionMatrix)
+{
+    for ( auto chunkPair: *world->chunkMap ) {
+        if ( isChunkWithinLightVolume(*chunkPair.second, lightViewProjectionMatrix))
+            drawChunk(chunkPair.second);
+    }
+    if ( heightmapTerrain )
+        heightmapTerrain->flush();
+    if ( clipmap )
+        clipmap->draw();
+}
+
+bool WorldRenderer::hasChunkChangesWithin(unsigned long sinceRevision, glm::mat4 lightViewProjectionMatrix)
+{
+    if ( sinceRevision == world->chunkRevision )
+        return false;
+
+    for ( auto chunkPair: *world->chunkMap ) {
+        if ( chunkPair.second->revision > sinceRevision &&
+             isChunkWithinLightVolume(*chunkPair.second, lightViewProjectionMatrix))
+            return true;
+    }
+    return false;
+}
+
+/**
+ * Render the world.
+ * With pipelined rendering the draw list submitted here was built during the previous frame,
+ * while the draw list for the next frame is built by the draw list worker in the meantime.
+ */
+void WorldRenderer::render(float deltaTime, Frustum *frustum)
+{
+    if ( !pipelinedRendering ) {
+        world->applyChanges();
+        buildDrawList(&drawLists[ 0 ], frustum);
+        submitDrawList(&drawLists[ 0 ]);
+        return;
+    }
+
+    // Wait for the list of this frame, after which the chunk map is no longer read by the worker.
+    drawListJobs->wait();
+    DrawList *drawList = &drawLists[ drawListIndex ];
+    drawListIndex = 1 - drawListIndex;
+
+    world->applyChanges();
+
+    // The worker gets its own copy of the frustum, as the camera keeps moving while it builds.
+    if ( !drawListFrustum )
+        drawListFrustum = new Frustum(*frustum);
+    else
+        *drawListFrustum = *frustum;
+    drawListFrustum->detachSource();
+
+    DrawList *nextDrawList = &drawLists[ drawListIndex ];
+    drawListJobs->submit([this, nextDrawList] {
+        buildDrawList(nextDrawList, drawListFrustum);
+    });
+
+    // The very first frame has nothing built yet
+    submitDrawList(drawList);
+}
+
+void WorldRenderer::buildDrawList(DrawList *drawList, Frustum *frustum)
+{
+    drawList->clear();
+    drawList->cameraPosition = frustum->source->position;
+
+    float vegetationDistance = VEGETATION_DRAW_DISTANCE * CHUNK_COORDINATE_SCALAR;
+    for ( auto chunkPair: *world->chunkMap ) {
+        chunk_t *chunk = chunkPair.second;
+        if ( !shouldRenderChunk(*chunk, frustum) ||
+             !world->isWithinDrawDistance((int32_t) ( chunk->x / CHUNK_COORDINATE_SCALING_FACTOR ),
+                                          (int32_t) ( chunk->z / CHUNK_COORDINATE_SCALING_FACTOR ),
+                                          drawList->cameraPosition)) {
+            drawList->chunksCulled++;
+            continue;
+        }
+        drawList->chunksDrawn++;
+
+        // The draw lists are built one at a time, so this is the only thread writing the timestamp
+        if ( chunk->timestamps.first_drawn == 0.0 && chunk->timestamps.uploaded > 0.0 ) {
+            chunk->timestamps.first_drawn = ChunkPipelineStats::now();
+            world->pipelineStats.recordDrawn(chunk->timestamps);
+        }
+
+        auto *render_data = (chunk_render_data_t *) chunk->listener_data;
+        if ( render_data->mesh )
+            drawList->meshes.push_back(render_data->mesh);
+        else if ( render_data->heightmap_slot >= 0 )
+            drawList->heightmapChunks.push_back({ render_data->heightmap_slot,
+                                                  chunk->x - 0.5f * CHUNK_COORDINATE_SCALING_FACTOR,
+                                                  chunk->z - 0.5f * CHUNK_COORDINATE_SCALING_FACTOR });
+
+        // Add the vegetation of nearby chunks
+        if ( std::abs(chunk->x - drawList->cameraPosition.x) > vegetationDistance ||
+             std::abs(chunk->z - drawList->cameraPosition.z) > vegetationDistance )
+            continue;
+        for ( uint32_t i = 0; i < chunk->vegetation_count; i++ ) {
+            drawList->instances.push_back({ vegetationMeshes[ chunk->vegetation[ i ].type ],
+                                            Vegetation::getTransform(chunk->vegetation[ i ]) });
+        }
+    }
+}
+
+void WorldRenderer::submitDrawList(DrawList *drawList)
+{
+    // The list may have been built on another thread, so the chunks are counted when it's submitted
+    RenderStats::add(RENDER_STAT_CHUNKS_DRAWN, drawList->chunksDrawn);
+    RenderStats::add(RENDER_STAT_CHUNKS_CULLED, drawList->chunksCulled);
+
+    for ( VBO *mesh: drawList->meshes )
+        mesh->draw(0);
+
+    if ( heightmapTerrain ) {
+        for ( draw_list_heightmap_t &entry: drawList->heightmapChunks )
+            heightmapTerrain->submit(entry.slot, entry.x, entry.z);
+        heightmapTerrain->flush();
+    }
+
+    // In clipmap mode the chunks only carry the vegetation, the terrain is drawn as a whole.
+    if ( clipmap ) {
+        clipmap->update(drawList->cameraPosition);
+        clipmap->draw();
+    }
+
+    for ( draw_list_instance_t &instance: drawList->instances )
+        instancedRenderer->submit(instance.mesh, instance.transform);
+
+    // InstancedDrawables only submit themselves here, they are drawn when the instanced renderer is flushed.
+    for ( Drawable *drawable: *drawables ) {
+        drawable->draw(0);
+    }
+}
+
+vertex_t WorldRenderer::getCellVertex(int32_t x, int32_t z, const float *heights)
+{
+    // The central difference over the neighbouring samples, the same scheme as the height map shaders
+    glm::vec3 normal = glm::normalize(glm::vec3(heights[ 1 ] - heights[ 2 ], 2.0f * CHUNK_COORDINATE_SCALING_FACTOR,
+                                                heights[ 3 ] - heights[ 4 ]));
+    return {
+            ((float) x - 0.5f ) * CHUNK_COORDINATE_SCALING_FACTOR, heights[ 0 ],
+            ((float) z - 0.5f ) * CHUNK_COORDINATE_SCALING_FACTOR,
+            normal.x, normal.y, normal.z,
+            0, 0
+    };
+}
+
+/**
+ * Appends a flat shaded triangle to the provided vertices and indices.
+ */
+static void addTriangle(std::vector<vertex_t> &vertices, std::vector<unsigned int> &indices,
+                        glm::vec3 a, glm::vec3 b, glm::vec3 c)
+{
+    glm::vec3 normal = glm::normalize(glm::cross(b - a, c - a));
+    for ( glm::vec3 point: { a, b, c } ) {
+        indices.push_back((unsigned int) vertices.size());
+        vertices.push_back({ point.x, point.y, point.z, normal.x, normal.y, normal.z, 0, 0 });
+    }
+}
+
+void WorldRenderer::createVegetationMeshes()
+{
+    const int sides = 8;
+
+    for ( int type = 0; type < VEGETATION_TYPE_COUNT; type++ ) {
+        std::vector<vertex_t> vertices;
+        std::vector<unsigned int> indices;
+
+        for ( int i = 0; i < sides; i++ ) {
+            float a0 = (float) i / sides * 2.0f * (float) M_PI;
+            float a1 = (float) ( i + 1 ) / sides * 2.0f * (float) M_PI;
+
+            if ( type == VEGETATION_TYPE_TREE ) {
+                // Cone shaped crown on a thin trunk
+                glm::vec3 crown0 = glm::vec3(std::cos(a0) * 15.0f, 15.0f, std::sin(a0) * 15.0f);
+                glm::vec3 crown1 = glm::vec3(std::cos(a1) * 15.0f, 15.0f, std::sin(a1) * 15.0f);
+                glm::vec3 trunk0 = glm::vec3(std::cos(a0) * 2.0f, 0.0f, std::sin(a0) * 2.0f);
+                glm::vec3 trunk1 = glm::vec3(std::cos(a1) * 2.0f, 0.0f, std::sin(a1) * 2.0f);
+                addTriangle(vertices, indices, crown1, crown0, glm::vec3(0.0f, 60.0f, 0.0f));
+                addTriangle(vertices, indices, crown0, crown1, glm::vec3(0.0f, 15.0f, 0.0f));
+                addTriangle(vertices, indices, trunk1, trunk0, trunk0 + glm::vec3(0.0f, 15.0f, 0.0f));
+                addTriangle(vertices, indices, trunk1, trunk0 + glm::vec3(0.0f, 15.0f, 0.0f),
+                            trunk1 + glm::vec3(0.0f, 15.0f, 0.0f));
+            } else {
+                // Flattened, slightly sunken double pyramid
+                glm::vec3 p0 = glm::vec3(std::cos(a0) * 8.0f, 0.0f, std::sin(a0) * 8.0f);
+                glm::vec3 p1 = glm::vec3(std::cos(a1) * 8.0f, 0.0f, std::sin(a1) * 8.0f);
+                addTriangle(vertices, indices, p1, p0, glm::vec3(0.0f, 6.0f, 0.0f));
+                addTriangle(vertices, indices, p0, p1, glm::vec3(0.0f, -4.0f, 0.0f));
+            }
+        }
+
+        VBO *buffer = new VBO();
+        buffer->withVertices(vertices);
+        buffer->withIndices(indices);
+        buffer->build();
+        vegetationMeshes[ type ] = new Mesh(buffer, glm::vec3(0.0f), glm::vec3(0.0f), glm::vec3(1.0f));
+    }
+}
+
+/*
+ * Build the mesh data or height grid of a generated chunk, on the generation worker.
+ * This Mesh mesh_data can then be fed into the GPU for rendering.
+ */
+void WorldRenderer::onChunkGenerated(chunk_t *chunk, const float *heights, bool loaded)
+{
+    auto x = (int32_t) ( chunk->x / CHUNK_COORDINATE_SCALING_FACTOR );
+    auto z = (int32_t) ( chunk->z / CHUNK_COORDINATE_SCALING_FACTOR );
+    int32_t i, j;
+    float cy;
+    int mesh_width = CHUNK_SIZE + 1;
+
+    auto *render_data = (chunk_render_data_t *) renderDataPool->allocate();
+    render_data->mesh = nullptr;
+    render_data->heightmap_slot = -1;
+    render_data->meshing_mode = TERRAIN_MESH_REGULAR;
+    render_data->loaded = loaded;
+    render_data->mesh_data = nullptr;
+    render_data->height_grid = nullptr;
+    chunk->listener_data = render_data;
+
+    // In height map mode only the heights are uploaded, including a one sample wide apron
+    // from which the vertex shader calculates the normals at the borders of the chunk.
+    if ( terrainRenderMode == TERRAIN_RENDER_HEIGHTMAP ) {
+        int grid_width = mesh_width + 2;
+        float *height_grid = (float *) payloadPool->allocate();
+        for ( i = -1; i <= mesh_width; i++ ) {
+            for ( j = -1; j <= mesh_width; j++ ) {
+                if ( i >= 0 && j >= 0 && i < mesh_width && j < mesh_width )
+                    cy = heights[ i * mesh_width + j ];
+                else
+                    cy = world->getCellHeight(x + i, z + j);
+                height_grid[ ( j + 1 ) * grid_width + ( i + 1 ) ] = cy;
+            }
+        }
+        render_data->height_grid = height_grid;
+    } else if ( terrainRenderMode == TERRAIN_RENDER_MESH ) {
+        // Triangulate the height grid. Both meshers only return which grid points are used,
+        // so the normals only have to be calculated for the vertices that end up in the Mesh.
+        // Reused between the chunks generated on this thread, so they don't allocate once they've grown
+        static thread_local std::vector<uint32_t> mesh_vertices;
+        static thread_local std::vector<unsigned int> mesh_indices;
+        mesh_vertices.clear();
+        mesh_indices.clear();
+
+        render_data->meshing_mode = terrainMeshingMode;
+        if ( render_data->meshing_mode == TERRAIN_MESH_ADAPTIVE )
+            TerrainMesher::meshAdaptive(heights, mesh_width, TERRAIN_MESH_MAX_ERROR * lodBias,
+                                        mesh_vertices, mesh_indices);
+        else
+            TerrainMesher::meshRegular(mesh_width, mesh_vertices, mesh_indices);
+
+        // The mesh data that will be passed to the main thread, in a single payload block.
+        auto *payload = (char *) payloadPool->allocate();
+        auto *vertices = (vertex_t *) ( payload + CHUNK_PAYLOAD_HEADER_SIZE );
+        auto *indices = (unsigned int *) ( vertices + CHUNK_MESH_MAX_VERTICES );
+        memcpy(indices, mesh_indices.data(), sizeof(unsigned int) * mesh_indices.size());
+
+        // The normals are central differences over the samples, like those of edited chunks in `onChunkChanged`,
+        // so an edit doesn't leave a seam against its unedited neighbours. Only the border samples are looked up.
+        for ( size_t vertex = 0; vertex < mesh_vertices.size(); vertex++ ) {
+            i = (int32_t) mesh_vertices[ vertex ] / mesh_width;
+            j = (int32_t) mesh_vertices[ vertex ] % mesh_width;
+            float neighbours[ 5 ] = {
+                    heights[ mesh_vertices[ vertex ]],
+                    i > 0 ? heights[ mesh_vertices[ vertex ] - mesh_width ] : world->getCellHeight(x + i - 1, z + j),
+                    i < CHUNK_SIZE ? heights[ mesh_vertices[ vertex ] + mesh_width ] : world->getCellHeight(x + i + 1, z + j),
+                    j > 0 ? heights[ mesh_vertices[ vertex ] - 1 ] : world->getCellHeight(x + i, z + j - 1),
+                    j < CHUNK_SIZE ? heights[ mesh_vertices[ vertex ] + 1 ] : world->getCellHeight(x + i, z + j + 1)
+            };
+            vertices[ vertex ] = getCellVertex(x + i, z + j, neighbours);
+        }
+
+        vbo_data_t *mesh_data = (vbo_data_t *) payload;
+        mesh_data->indices = indices;
+        mesh_data->vertices = vertices;
+        mesh_data->indices_count = (unsigned int) mesh_indices.size();
+        mesh_data->vertices_count = (unsigned int) mesh_vertices.size();
+        render_data->mesh_data = mesh_data;
+    }
+}
+
+/*
+ * Upload a generated chunk to the GPU, right before it's added to the world.
+ * This has to happen on the thread that owns the OpenGL context.
+ */
+void WorldRenderer::onChunkAdded(chunk_t *chunk)
+{
+    auto *render_data = (chunk_render_data_t *) chunk->listener_data;
+    vbo_data_t *vbo_data = render_data->mesh_data;
+
+    if ( vbo_data ) {
+        // The buffers can only be created on this thread, so the VBO is only constructed now
+        VBO *mesh = new ( render_data->mesh_storage ) VBO();
+        if ( render_data->meshing_mode == TERRAIN_MESH_ADAPTIVE ) {
+            // Edits change the triangulation of adaptive meshes, so their buffers are sized for the
+            // largest mesh of a chunk and every remesh in `onChunkChanged` is written into them.
+            mesh->reserve(CHUNK_MESH_MAX_VERTICES, CHUNK_MESH_MAX_INDICES);
+            mesh->updateVertices(vbo_data->vertices, 0, vbo_data->vertices_count);
+            mesh->updateIndices(vbo_data->indices, vbo_data->indices_count);
+        } else {
+            mesh->withVertices(vbo_data->vertices, vbo_data->vertices_count);
+            mesh->withIndices(vbo_data->indices, vbo_data->indices_count);
+        }
+        mesh->build();
+        render_data->mesh = mesh;
+        // Return the payload to the pool, it's been copied to video memory.
+        payloadPool->release(vbo_data);
+        render_data->mesh_data = nullptr;
+    } else if ( render_data->height_grid ) {
+        render_data->heightmap_slot = heightmapTerrain->allocate(render_data->height_grid);
+        payloadPool->release(render_data->height_grid);
+        render_data->height_grid = nullptr;
+    } else if ( clipmap && render_data->loaded ) {
+        // The clipmap sampled the generator here until now, while the saved heights might have been edited.
+        // Generated chunks match what was sampled, so they don't have to be sampled again.
+        auto x = (int32_t) ( chunk->x / CHUNK_COORDINATE_SCALING_FACTOR );
+        auto z = (int32_t) ( chunk->z / CHUNK_COORDINATE_SCALING_FACTOR );
+        clipmap->invalidate(x, z, x + CHUNK_SIZE - 1, z + CHUNK_SIZE - 1);
+    }
+}
+
+void WorldRenderer::onChunkDiscarded(chunk_t *chunk)
+{
+    freeRenderData(chunk);
+}
+
+void WorldRenderer::onChunkRemoved(chunk_t *chunk)
+{
+    freeRenderData(chunk);
+}
+
+void WorldRenderer::freeRenderData(chunk_t *chunk)
+{
+    auto *render_data = (chunk_render_data_t *) chunk->listener_data;
+    if ( !render_data )
+        return;
+    payloadPool->release(render_data->mesh_data);
+    payloadPool->release(render_data->height_grid);
+    if ( render_data->heightmap_slot >= 0 )
+        heightmapTerrain->release(render_data->heightmap_slot);
+    if ( render_data->mesh )
+        render_data->mesh->~VBO();
+    renderDataPool->release(render_data);
+    chunk->listener_data = nullptr;
+}
+
+/*
+ * Updates a rectangle of grid vertices of a chunk to the new heights handed over by the world.
+ */
+void WorldRenderer::onChunkChanged(chunk_t *chunk, int32_t minI, int32_t minJ, int32_t maxI, int32_t maxJ,
+                                   const float *heights)
+{
+    auto *render_data = (chunk_render_data_t *) chunk->listener_data;
+    auto x = (int32_t) ( chunk->x / CHUNK_COORDINATE_SCALING_FACTOR );
+    auto z = (int32_t) ( chunk->z / CHUNK_COORDINATE_SCALING_FACTOR );
+    int mesh_width = CHUNK_SIZE + 1;
+
+    // The clipmap reads the heights from the world itself, it only has to sample the rectangle again
+    if ( clipmap ) {
+        clipmap->invalidate(x + minI, z + minJ, x + maxI, z + maxJ);
+        return;
+    }
+
+    // The heights are laid out over the rectangle as it was passed, with a border of one sample
+    int32_t firstI = minI - 1;
+    int32_t firstJ = minJ - 1;
+    int32_t width = maxI - minI + 3;
+    int32_t depth = maxJ - minJ + 3;
+
+    // Height grids only store the heights, the normals are calculated by the vertex shader.
+    // They contain the samples beyond the grid, where their apron lies.
+    if ( render_data->heightmap_slot >= 0 ) {
+        static thread_local std::vector<float> texels;
+        texels.resize(( width - 2 ) * ( depth - 2 ));
+        for ( int32_t i = 1; i < width - 1; i++ )
+            for ( int32_t j = 1; j < depth - 1; j++ )
+                texels[ ( j - 1 ) * ( width - 2 ) + ( i - 1 ) ] = heights[ i * depth + j ];
+        heightmapTerrain->update(render_data->heightmap_slot, texels.data(), minI + 1, minJ + 1, width - 2,
+                                 depth - 2);
+        return;
+    }
+
+    minI = std::max(minI, 0);
+    minJ = std::max(minJ, 0);
+    maxI = std::min(maxI, CHUNK_SIZE);
+    maxJ = std::min(maxJ, CHUNK_SIZE);
+    if ( !render_data->mesh || minI > maxI || minJ > maxJ )
+        return;
+
+    // Adaptive meshes can change their triangulation, so they're rebuilt as a whole,
+    // into the buffers that were sized for the largest mesh in `onChunkAdded`.
+    // That takes the heights of the whole grid: the samples of the chunk itself are decoded at once,
+    // only those around it that lie outside of the rectangle are looked up one by one.
+    bool remesh = render_data->meshing_mode == TERRAIN_MESH_ADAPTIVE;
+    if ( remesh ) {
+        int grid_width = CHUNK_SIZE + 3;
+        static thread_local std::vector<float> grid_heights;
+        float chunk_heights[ CHUNK_SIZE * CHUNK_SIZE ];
+        grid_heights.resize(grid_width * grid_width);
+        world->getChunkHeights(x, z, chunk_heights);
+        for ( int32_t i = -1; i <= mesh_width; i++ ) {
+            for ( int32_t j = -1; j <= mesh_width; j++ ) {
+                float &height = grid_heights[ ( i + 1 ) * grid_width + j + 1 ];
+                if ( i >= firstI && i < firstI + width && j >= firstJ && j < firstJ + depth )
+                    height = heights[ ( i - firstI ) * depth + j - firstJ ];
+                else if ( i >= 0 && j >= 0 && i < CHUNK_SIZE && j < CHUNK_SIZE )
+                    height = chunk_heights[ i * CHUNK_SIZE + j ];
+                else
+                    height = world->getCellHeight(x + i, z + j);
+            }
+        }
+        heights = grid_heights.data();
+        firstI = firstJ = -1;
+        depth = grid_width;
+    }
+
+    static thread_local std::vector<vertex_t> vertices;
+    auto vertexAt = [&](int32_t i, int32_t j) {
+        int index = ( i - firstI ) * depth + ( j - firstJ );
+        float neighbours[ 5 ] = { heights[ index ], heights[ index - depth ], heights[ index + depth ],
+                                  heights[ index - 1 ], heights[ index + 1 ] };
+        return getCellVertex(x + i, z + j, neighbours);
+    };
+
+    if ( !remesh ) {
+        // The vertices of a regular mesh are the grid points in order, so every row of the rectangle
+        // is a contiguous range of the vertex buffer.
+        for ( int32_t i = minI; i <= maxI; i++ ) {
+            vertices.clear();
+            for ( int32_t j = minJ; j <= maxJ; j++ )
+                vertices.push_back(vertexAt(i, j));
+            render_data->mesh->updateVertices(vertices.data(), i * mesh_width + minJ, vertices.size());
+        }
+        return;
+    }
+
+    float grid[ ( CHUNK_SIZE + 1 ) * ( CHUNK_SIZE + 1 ) ];
+    for ( int32_t i = 0; i < mesh_width; i++ )
+        for ( int32_t j = 0; j < mesh_width; j++ )
+            grid[ i * mesh_width + j ] = heights[ ( i + 1 ) * depth + ( j + 1 ) ];
+
+    static thread_local std::vector<uint32_t> mesh_vertices;
+    static thread_local std::vector<unsigned int> mesh_indices;
+    mesh_vertices.clear();
+    mesh_indices.clear();
+    TerrainMesher::meshAdaptive(grid, mesh_width, TERRAIN_MESH_MAX_ERROR * lodBias, mesh_vertices, mesh_indices);
+
+    vertices.clear();
+    for ( uint32_t vertex: mesh_vertices )
+        vertices.push_back(vertexAt((int32_t) vertex / mesh_width, (int32_t) vertex % mesh_width));
+    render_data->mesh->updateVertices(vertices.data(), 0, vertices.size());
+    render_data->mesh->updateIndices(mesh_indices.data(), mesh_indices.size());
+}
+
+WorldRenderer::~WorldRenderer()
+{
+    // No chunks are generated or added anymore after this, the world can still be saved.
+    // The payloads of the chunks that were generated but not added go with the payload pool.
+    world->stopWorldGeneration();
+    drawListJobs->wait();
+    delete drawListJobs;
+    delete drawListFrustum;
+
+    for ( auto entry: *world->chunkMap )
+        freeRenderData(entry.second);
+    world->setChunkListener(nullptr);
+
+    drawables->clear();
+    delete drawables;
+    delete instancedRenderer;
+    delete heightmapTerrain;
+    delete clipmap;
+    for ( Mesh *mesh: vegetationMeshes )
+        delete mesh;
+    delete renderDataPool;
+    delete payloadPool;
+}
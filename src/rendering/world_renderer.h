@@ -0,0 +1,204 @@
+//
+// Created by Luca Warmenhoven on 17/10/2026.
+//
+
+#ifndef GRAPHICS_TEST_WORLD_RENDERER_H
+#define GRAPHICS_TEST_WORLD_RENDERER_H
+
+#include <atomic>
+#include "renderer.h"
+#include "culling/frustum.h"
+#include "vbo.h"
+#include "instanced_renderer.h"
+#include "draw_list.h"
+#include "terrain/heightmap_terrain.h"
+#include "terrain/clipmap.h"
+#include "../world/world.h"
+#include "../world/terrain_mesher.h"
+
+// The upper bounds of a chunk mesh, reached by the regular mesher
+#define CHUNK_MESH_MAX_VERTICES (( CHUNK_SIZE + 1 ) * ( CHUNK_SIZE + 1 ))
+#define CHUNK_MESH_MAX_INDICES (CHUNK_SIZE * CHUNK_SIZE * 6)
+// The height grid of a chunk in TERRAIN_RENDER_HEIGHTMAP mode, including the apron
+#define CHUNK_HEIGHT_GRID_SAMPLES (( CHUNK_SIZE + 3 ) * ( CHUNK_SIZE + 3 ))
+// Space reserved for the vbo_data_t at the start of a mesh payload
+#define CHUNK_PAYLOAD_HEADER_SIZE (64)
+
+// Chunks are uploaded as a triangle mesh
+#define TERRAIN_RENDER_MESH (0)
+// Chunks only upload their height grid, which is displaced on the GPU
+#define TERRAIN_RENDER_HEIGHTMAP (1)
+// The terrain is drawn by a geometry clipmap, chunks only carry their height map and vegetation
+#define TERRAIN_RENDER_CLIPMAP (2)
+
+/**
+ * The GPU side of a chunk, kept in chunk_t::listener_data.
+ * The mesh data or height grid is a single block from the payload pool of the renderer,
+ * with the vertices and indices following the vbo_data_t in the same block.
+ * It's only kept until the chunk has been uploaded.
+ * The VBO of the mesh lives in the render data itself, so it comes from the same pool.
+ */
+typedef struct {
+    VBO *mesh;                  // nullptr when the chunk is rendered from a height map texture or the clipmap
+    alignas(VBO) unsigned char mesh_storage[sizeof(VBO)]; // `mesh` is constructed in here when the chunk is uploaded
+    int heightmap_slot;         // The slot in WorldRenderer::heightmapTerrain, or -1 when it isn't used
+    unsigned char meshing_mode; // The TerrainMesher mode the mesh was triangulated with
+    bool loaded;                // Whether the heights were loaded rather than generated, see ChunkListener
+    vbo_data_t *mesh_data;      // Only used in TERRAIN_RENDER_MESH mode, until uploaded
+    float *height_grid;         // Only used in TERRAIN_RENDER_HEIGHTMAP mode including the apron, until uploaded
+} chunk_render_data_t;
+
+/**
+ * Renders the chunks and vegetation of a World.
+ * Follows the chunks of the world as its chunk listener: generated chunks are meshed
+ * on the generation workers, and uploaded when they're added to the world.
+ * Everything except `onChunkGenerated` has to be called on the thread that owns the OpenGL context.
+ */
+class WorldRenderer : public ChunkListener
+{
+
+private:
+    /**
+     * Double buffered draw lists. While the list of the current frame is submitted,
+     * the list of the next frame is built by the draw list worker.
+     */
+    DrawList drawLists[2];
+    int drawListIndex = 0;
+    JobSystem *drawListJobs = nullptr;
+
+    /** Copy of the frustum the draw list in flight is built with */
+    Frustum *drawListFrustum = nullptr;
+
+    /**
+     * Pools for the render data of the chunks, and the payloads waiting to be uploaded.
+     */
+    SlabPool *renderDataPool = nullptr;
+    SlabPool *payloadPool = nullptr;
+
+    void drawChunk(chunk_t *chunk);
+
+    /**
+     * Fills a draw list with the visible chunks and vegetation.
+     * Only reads the chunk map and doesn't use OpenGL, so it's safe to call from a worker.
+     */
+    void buildDrawList(DrawList *drawList, Frustum *frustum);
+
+    /**
+     * Issues the draw calls of a draw list, on the thread that owns the OpenGL context.
+     */
+    void submitDrawList(DrawList *drawList);
+
+    /**
+     * Frees the render data of a chunk, including the GPU resources.
+     */
+    void freeRenderData(chunk_t *chunk);
+
+    /**
+     * Get the vertex of the terrain mesh at a height map sample, with its normal calculated
+     * from the surrounding samples.
+     * @param heights The heights of the sample and its four neighbours: -x, +x, -z, +z
+     */
+    static vertex_t getCellVertex(int32_t x, int32_t z, const float *heights);
+
+    /**
+     * Creates the meshes for all vegetation types.
+     */
+    void createVegetationMeshes();
+
+public:
+
+    /**
+     * How the height grid of new chunks is triangulated.
+     * Either TERRAIN_MESH_REGULAR or TERRAIN_MESH_ADAPTIVE.
+     */
+    static unsigned char terrainMeshingMode;
+
+    /**
+     * How chunks are uploaded to and rendered by the GPU.
+     * Either TERRAIN_RENDER_MESH, TERRAIN_RENDER_HEIGHTMAP or TERRAIN_RENDER_CLIPMAP.
+     * This has to be set before the renderer is created.
+     */
+    static unsigned char terrainRenderMode;
+
+    /**
+     * Whether the draw list of the next frame is built on a worker while the current one is submitted.
+     * This means the visibility of chunks lags one frame behind the camera.
+     */
+    static bool pipelinedRendering;
+
+    World *world;
+
+    std::vector<Drawable *> *drawables;
+
+    /**
+     * Renderer that InstancedDrawables in the world submit themselves to.
+     * The submitted instances are drawn when the renderer is flushed.
+     */
+    InstancedRenderer *instancedRenderer;
+
+    /**
+     * The meshes of all vegetation types, indexed by type.
+     */
+    Mesh *vegetationMeshes[VEGETATION_TYPE_COUNT];
+
+    /**
+     * Renderer for the chunks in TERRAIN_RENDER_HEIGHTMAP mode, nullptr otherwise.
+     */
+    HeightmapTerrain *heightmapTerrain = nullptr;
+
+    /**
+     * Renderer for the terrain in TERRAIN_RENDER_CLIPMAP mode, nullptr otherwise.
+     */
+    Clipmap *clipmap = nullptr;
+
+    /**
+     * Multiplier for the maximum error of the adaptive mesher. Higher values
+     * produce coarser meshes. Only applies to chunks generated after changing it.
+     */
+    std::atomic<float> lodBias = 1.0f;
+
+    /**
+     * Creates the renderer and registers it as the chunk listener of the world.
+     * This has to happen before the world generation is started.
+     */
+    explicit WorldRenderer(World *world);
+
+    /**
+     * Stops the world generation, and frees the GPU resources of the chunks.
+     * The world itself is left intact, so it can still be saved.
+     */
+    ~WorldRenderer() override;
+
+    /**
+     * Adds the generated chunks to the world and renders it.
+     * With pipelined rendering the chunk map is only changed after the draw list worker
+     * finished reading it, so the world must not be changed elsewhere while rendering.
+     */
+    void render(float deltaTime, Frustum *frustum);
+
+    /**
+     * Draws the meshes of all chunks that can cast a shadow into the volume
+     * of the provided light view-projection matrix.
+     * The shader and its uniforms have to be set up by the caller.
+     */
+    void renderShadowCasters(glm::mat4 lightViewProjectionMatrix);
+
+    /**
+     * Whether any chunks were added within the volume of the provided
+     * light view-projection matrix since the provided chunk revision.
+     */
+    bool hasChunkChangesWithin(unsigned long sinceRevision, glm::mat4 lightViewProjectionMatrix);
+
+    void onChunkGenerated(chunk_t *chunk, const float *heights, bool loaded) override;
+
+    void onChunkAdded(chunk_t *chunk) override;
+
+    void onChunkDiscarded(chunk_t *chunk) override;
+
+    void onChunkRemoved(chunk_t *chunk) override;
+
+    void onChunkChanged(chunk_t *chunk, int32_t minI, int32_t minJ, int32_t maxI, int32_t maxJ,
+                        const float *heights) override;
+};
+
+#endif //GRAPHICS_TEST_WORLD_RENDERER_H
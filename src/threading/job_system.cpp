@@ -0,0 +1,94 @@
+//
+// Created by Luca Warmenhoven on 17/10/2026.
+//
+
+#include "job_system.h"
+
+JobSystem::JobSystem(int workerCount)
+{
+    this->activeWorkerCount = 0;
+    this->runningJobCount = 0;
+    this->stopping = false;
+    this->setWorkerCount(workerCount);
+}
+
+JobSystem::~JobSystem()
+{
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->stopping = true;
+        this->jobs.clear();
+    }
+    this->condition.notify_all();
+    for ( std::thread &worker: this->workers )
+        worker.join();
+}
+
+void JobSystem::workerFn(int index)
+{
+    std::unique_lock<std::mutex> lock(this->mutex);
+
+    while ( true ) {
+        this->condition.wait(lock, [this, index] {
+            return this->stopping || ( index < this->activeWorkerCount && !this->jobs.empty());
+        });
+        if ( this->stopping )
+            return;
+
+        std::function<void()> job = std::move(this->jobs.front());
+        this->jobs.pop_front();
+        this->runningJobCount++;
+
+        lock.unlock();
+        job();
+        lock.lock();
+
+        if ( --this->runningJobCount == 0 && this->jobs.empty())
+            this->idleCondition.notify_all();
+    }
+}
+
+void JobSystem::submit(std::function<void()> job)
+{
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->jobs.push_back(std::move(job));
+    }
+    // Parked workers share the condition, so notify all of them to make sure an active one wakes up.
+    this->condition.notify_all();
+}
+
+void JobSystem::setWorkerCount(int workerCount)
+{
+    workerCount = std::max(workerCount, 1);
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->activeWorkerCount = workerCount;
+    }
+
+    // Workers are only ever added, the surplus is parked by the wait condition.
+    while ((int) this->workers.size() < workerCount )
+        this->workers.emplace_back(&JobSystem::workerFn, this, (int) this->workers.size());
+
+    this->condition.notify_all();
+}
+
+int JobSystem::getWorkerCount()
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+    return this->activeWorkerCount;
+}
+
+void JobSystem::wait()
+{
+    std::unique_lock<std::mutex> lock(this->mutex);
+    this->idleCondition.wait(lock, [this] {
+        return this->stopping || ( this->runningJobCount == 0 && this->jobs.empty());
+    });
+}
+
+size_t JobSystem::getPendingJobCount()
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+    return this->jobs.size();
+}
@@ -0,0 +1,75 @@
+//
+// Created by Luca Warmenhoven on 17/10/2026.
+//
+
+#ifndef GRAPHICS_TEST_JOB_SYSTEM_H
+#define GRAPHICS_TEST_JOB_SYSTEM_H
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <vector>
+#include <deque>
+
+/**
+ * Pool of worker threads executing submitted jobs in submission order.
+ *
+ * The amount of active workers can be changed at runtime. Workers that are no
+ * longer needed finish their current job and are parked until they're needed
+ * again, so shrinking the pool never blocks the calling thread.
+ */
+class JobSystem
+{
+
+private:
+
+    std::vector<std::thread> workers;
+    std::deque<std::function<void()>> jobs;
+
+    std::mutex mutex;
+    std::condition_variable condition;
+    std::condition_variable idleCondition;
+
+    /** The amount of jobs that are currently being executed */
+    int runningJobCount;
+
+    /** Workers with an index at or above this count are parked */
+    int activeWorkerCount;
+    bool stopping;
+
+    void workerFn(int index);
+
+public:
+
+    explicit JobSystem(int workerCount);
+
+    /**
+     * Waits for the running jobs to finish, jobs that haven't been started are discarded.
+     */
+    ~JobSystem();
+
+    /**
+     * Submits a job, to be executed by one of the workers.
+     */
+    void submit(std::function<void()> job);
+
+    /**
+     * Changes the amount of workers executing jobs.
+     */
+    void setWorkerCount(int workerCount);
+
+    int getWorkerCount();
+
+    /**
+     * Blocks until all submitted jobs have finished.
+     */
+    void wait();
+
+    /**
+     * Get the amount of jobs that haven't been started yet.
+     */
+    size_t getPendingJobCount();
+};
+
+#endif //GRAPHICS_TEST_JOB_SYSTEM_H
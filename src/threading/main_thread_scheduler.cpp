@@ -0,0 +1,41 @@
+//
+// Created by Luca Warmenhoven on 17/10/2026.
+//
+
+#include "main_thread_scheduler.h"
+
+void MainThreadScheduler::NextFrameAwaiter::await_suspend(std::coroutine_handle<> handle)
+{
+    std::lock_guard<std::mutex> lock(scheduler->mutex);
+    scheduler->waiting.push_back(handle);
+}
+
+MainThreadScheduler::NextFrameAwaiter MainThreadScheduler::nextFrame()
+{
+    return NextFrameAwaiter { this };
+}
+
+int MainThreadScheduler::resume(int budget)
+{
+    int resumed = 0;
+    while ( budget < 0 || resumed < budget ) {
+        std::coroutine_handle<> handle;
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            if ( this->waiting.empty())
+                break;
+            handle = this->waiting.front();
+            this->waiting.pop_front();
+        }
+        // Resumed without holding the lock, the coroutine might wait for the next frame again
+        handle.resume();
+        resumed++;
+    }
+    return resumed;
+}
+
+size_t MainThreadScheduler::getWaitingCount()
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+    return this->waiting.size();
+}
@@ -0,0 +1,53 @@
+//
+// Created by Luca Warmenhoven on 17/10/2026.
+//
+
+#ifndef GRAPHICS_TEST_MAIN_THREAD_SCHEDULER_H
+#define GRAPHICS_TEST_MAIN_THREAD_SCHEDULER_H
+
+#include <coroutine>
+#include <deque>
+#include <mutex>
+
+/**
+ * Queue of coroutines waiting to continue on the main thread, for example to use OpenGL.
+ * Coroutines await `nextFrame()` from any thread, and are resumed in order when
+ * the main thread calls `resume` during a frame.
+ */
+class MainThreadScheduler
+{
+
+private:
+
+    std::deque<std::coroutine_handle<>> waiting;
+    std::mutex mutex;
+
+public:
+
+    struct NextFrameAwaiter
+    {
+        MainThreadScheduler *scheduler;
+
+        bool await_ready() noexcept { return false; }
+
+        void await_suspend(std::coroutine_handle<> handle);
+
+        void await_resume() noexcept {}
+    };
+
+    /**
+     * Awaitable that continues the awaiting coroutine on the main thread, during one of the next frames.
+     */
+    NextFrameAwaiter nextFrame();
+
+    /**
+     * Resumes waiting coroutines on the calling thread, in the order in which they started waiting.
+     * @param budget The maximum amount of coroutines to resume, or -1 to resume all of them
+     * @return The amount of coroutines that were resumed
+     */
+    int resume(int budget);
+
+    size_t getWaitingCount();
+};
+
+#endif //GRAPHICS_TEST_MAIN_THREAD_SCHEDULER_H
@@ -0,0 +1,203 @@
+//
+// Created by Luca Warmenhoven on 17/10/2026.
+//
+
+#ifndef GRAPHICS_TEST_TASK_H
+#define GRAPHICS_TEST_TASK_H
+
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <utility>
+#include "job_system.h"
+#include "../memory/size_class_allocator.h"
+
+template<typename T>
+class Task;
+
+/**
+ * The part of the promise of a Task that doesn't depend on the result type.
+ * When the coroutine finishes, the coroutine awaiting it is resumed on the same thread.
+ */
+class TaskPromiseBase
+{
+public:
+    std::coroutine_handle<> continuation;
+    std::exception_ptr exception;
+
+    // Coroutine frames are allocated from the size class pools, as tasks are started at a high rate
+    static void *operator new(size_t size) { return SizeClassAllocator::allocate(size); }
+
+    static void operator delete(void *memory, size_t size) { SizeClassAllocator::release(memory, size); }
+
+    struct FinalAwaiter
+    {
+        bool await_ready() noexcept { return false; }
+
+        template<typename Promise>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept
+        {
+            std::coroutine_handle<> continuation = handle.promise().continuation;
+            return continuation ? continuation : std::noop_coroutine();
+        }
+
+        void await_resume() noexcept {}
+    };
+
+    // Tasks are lazy, they only start running when they're awaited
+    std::suspend_always initial_suspend() noexcept { return {}; }
+
+    FinalAwaiter final_suspend() noexcept { return {}; }
+
+    void unhandled_exception() { exception = std::current_exception(); }
+};
+
+template<typename T>
+class TaskPromise : public TaskPromiseBase
+{
+public:
+    std::optional<T> value;
+
+    Task<T> get_return_object();
+
+    void return_value(T result) { value = std::move(result); }
+
+    T result()
+    {
+        if ( exception )
+            std::rethrow_exception(exception);
+        return std::move(*value);
+    }
+};
+
+template<>
+class TaskPromise<void> : public TaskPromiseBase
+{
+public:
+    Task<void> get_return_object();
+
+    void return_void() {}
+
+    void result()
+    {
+        if ( exception )
+            std::rethrow_exception(exception);
+    }
+};
+
+/**
+ * A coroutine producing a value of type T.
+ *
+ * The coroutine starts when the task is awaited, and resumes the awaiting coroutine when it finishes,
+ * on whichever thread it finished on. Tasks that nobody awaits can be started with `spawn`.
+ */
+template<typename T>
+class Task
+{
+public:
+    using promise_type = TaskPromise<T>;
+
+private:
+    std::coroutine_handle<promise_type> handle;
+
+public:
+    explicit Task(std::coroutine_handle<promise_type> handle) : handle(handle) {}
+
+    Task(Task &&other) noexcept : handle(std::exchange(other.handle, nullptr)) {}
+
+    Task(const Task &) = delete;
+
+    Task &operator=(const Task &) = delete;
+
+    ~Task()
+    {
+        if ( handle )
+            handle.destroy();
+    }
+
+    auto operator co_await() noexcept
+    {
+        struct Awaiter
+        {
+            std::coroutine_handle<promise_type> handle;
+
+            bool await_ready() noexcept { return !handle || handle.done(); }
+
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept
+            {
+                handle.promise().continuation = awaiting;
+                return handle;
+            }
+
+            T await_resume() { return handle.promise().result(); }
+        };
+        return Awaiter { handle };
+    }
+};
+
+template<typename T>
+Task<T> TaskPromise<T>::get_return_object()
+{
+    return Task<T>(std::coroutine_handle<TaskPromise<T>>::from_promise(*this));
+}
+
+inline Task<void> TaskPromise<void>::get_return_object()
+{
+    return Task<void>(std::coroutine_handle<TaskPromise<void>>::from_promise(*this));
+}
+
+/**
+ * Coroutine that starts right away and frees itself when it finishes.
+ */
+struct DetachedTask
+{
+    struct promise_type
+    {
+        static void *operator new(size_t size) { return SizeClassAllocator::allocate(size); }
+
+        static void operator delete(void *memory, size_t size) { SizeClassAllocator::release(memory, size); }
+
+        DetachedTask get_return_object() { return {}; }
+
+        std::suspend_never initial_suspend() noexcept { return {}; }
+
+        std::suspend_never final_suspend() noexcept { return {}; }
+
+        void return_void() {}
+
+        void unhandled_exception() { std::terminate(); }
+    };
+};
+
+/**
+ * Starts a task without awaiting it.
+ * The task runs on the calling thread until it first suspends.
+ */
+inline DetachedTask spawn(Task<void> task)
+{
+    co_await task;
+}
+
+/**
+ * Awaitable that continues the awaiting coroutine on one of the workers of a job system.
+ */
+struct ResumeOnAwaiter
+{
+    JobSystem *jobs;
+
+    bool await_ready() noexcept { return false; }
+
+    void await_suspend(std::coroutine_handle<> handle)
+    {
+        jobs->submit([handle] { handle.resume(); });
+    }
+
+    void await_resume() noexcept {}
+};
+
+inline ResumeOnAwaiter resumeOn(JobSystem *jobs)
+{
+    return ResumeOnAwaiter { jobs };
+}
+
+#endif //GRAPHICS_TEST_TASK_H
@@ -0,0 +1,255 @@
+//
+// Created by Luca Warmenhoven on 17/10/2026.
+//
+
+#include "task_graph.h"
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <unordered_map>
+
+TaskGraph::TaskGraph()
+{
+    this->compiled = false;
+    this->completedCount = 0;
+    this->jobs = nullptr;
+}
+
+int TaskGraph::addResource(const char *name)
+{
+    this->resources.emplace_back(name);
+    return (int) this->resources.size() - 1;
+}
+
+int TaskGraph::addTask(const char *name, std::function<void()> function, unsigned char affinity)
+{
+    task_graph_task_t task = {};
+    task.name = name;
+    task.function = std::move(function);
+    task.affinity = affinity;
+    this->tasks.push_back(std::move(task));
+    this->compiled = false;
+    return (int) this->tasks.size() - 1;
+}
+
+void TaskGraph::reads(int task, int resource)
+{
+    this->tasks[ task ].reads.push_back(resource);
+    this->compiled = false;
+}
+
+void TaskGraph::writes(int task, int resource)
+{
+    this->tasks[ task ].writes.push_back(resource);
+    this->compiled = false;
+}
+
+void TaskGraph::dependsOn(int task, int dependency)
+{
+    this->tasks[ task ].dependencies.push_back(dependency);
+    this->compiled = false;
+}
+
+bool TaskGraph::compile()
+{
+    int taskCount = (int) this->tasks.size();
+    std::vector<std::vector<int>> edges(taskCount);
+
+    for ( int i = 0; i < taskCount; i++ ) {
+        for ( int dependency: this->tasks[ i ].dependencies )
+            edges[ i ].push_back(dependency);
+    }
+
+    // Derive the order of the tasks sharing a resource from the order in which they were added
+    for ( int resource = 0; resource < (int) this->resources.size(); resource++ ) {
+        int lastWriter = -1;
+        std::vector<int> readersSinceWrite;
+
+        for ( int i = 0; i < taskCount; i++ ) {
+            task_graph_task_t &task = this->tasks[ i ];
+            bool writes = std::find(task.writes.begin(), task.writes.end(), resource) != task.writes.end();
+            bool reads = std::find(task.reads.begin(), task.reads.end(), resource) != task.reads.end();
+
+            if ( writes ) {
+                if ( lastWriter >= 0 )
+                    edges[ i ].push_back(lastWriter);
+                for ( int reader: readersSinceWrite )
+                    edges[ i ].push_back(reader);
+                readersSinceWrite.clear();
+                lastWriter = i;
+            } else if ( reads ) {
+                if ( lastWriter >= 0 )
+                    edges[ i ].push_back(lastWriter);
+                readersSinceWrite.push_back(i);
+            }
+        }
+    }
+
+    for ( int i = 0; i < taskCount; i++ ) {
+        std::vector<int> &dependencies = edges[ i ];
+        std::sort(dependencies.begin(), dependencies.end());
+        dependencies.erase(std::unique(dependencies.begin(), dependencies.end()), dependencies.end());
+        this->tasks[ i ].dependents.clear();
+    }
+    for ( int i = 0; i < taskCount; i++ ) {
+        for ( int dependency: edges[ i ] )
+            this->tasks[ dependency ].dependents.push_back(i);
+    }
+
+    // Check for cycles by repeatedly removing the tasks without remaining dependencies
+    std::vector<int> remaining(taskCount);
+    std::vector<int> ready;
+    for ( int i = 0; i < taskCount; i++ ) {
+        remaining[ i ] = (int) edges[ i ].size();
+        if ( remaining[ i ] == 0 )
+            ready.push_back(i);
+    }
+    int visited = 0;
+    while ( !ready.empty()) {
+        int task = ready.back();
+        ready.pop_back();
+        visited++;
+        for ( int dependent: this->tasks[ task ].dependents ) {
+            if ( --remaining[ dependent ] == 0 )
+                ready.push_back(dependent);
+        }
+    }
+    if ( visited != taskCount ) {
+        std::cerr << "Task graph contains a cycle, it can't be executed." << std::endl;
+        return false;
+    }
+
+    for ( int i = 0; i < taskCount; i++ )
+        this->tasks[ i ].dependencies = edges[ i ];
+    this->compiled = true;
+    return true;
+}
+
+void TaskGraph::schedule(int task)
+{
+    if ( this->tasks[ task ].affinity == TASK_GRAPH_MAIN_THREAD ) {
+        this->mainThreadQueue.push_back(task);
+        this->condition.notify_all();
+    } else {
+        this->jobs->submit([this, task] { run(task); });
+    }
+}
+
+void TaskGraph::run(int task)
+{
+    task_graph_task_t &entry = this->tasks[ task ];
+    entry.thread = std::this_thread::get_id();
+    entry.start = std::chrono::duration<double>(std::chrono::steady_clock::now() - this->executionStart).count();
+    entry.function();
+    entry.end = std::chrono::duration<double>(std::chrono::steady_clock::now() - this->executionStart).count();
+
+    std::lock_guard<std::mutex> lock(this->mutex);
+    for ( int dependent: entry.dependents ) {
+        if ( --this->tasks[ dependent ].remaining_dependencies == 0 )
+            schedule(dependent);
+    }
+    this->completedCount++;
+    this->condition.notify_all();
+}
+
+void TaskGraph::execute(JobSystem *jobSystem)
+{
+    if ( !this->compiled && !this->compile())
+        return;
+
+    std::unique_lock<std::mutex> lock(this->mutex);
+    this->jobs = jobSystem;
+    this->mainThread = std::this_thread::get_id();
+    this->executionStart = std::chrono::steady_clock::now();
+    this->completedCount = 0;
+
+    for ( task_graph_task_t &task: this->tasks )
+        task.remaining_dependencies = (int) task.dependencies.size();
+    for ( int i = 0; i < (int) this->tasks.size(); i++ ) {
+        if ( this->tasks[ i ].remaining_dependencies == 0 )
+            schedule(i);
+    }
+
+    // Execute the main thread tasks as they become ready, until all tasks have finished
+    while ( true ) {
+        this->condition.wait(lock, [this] {
+            return !this->mainThreadQueue.empty() || this->completedCount == this->tasks.size();
+        });
+        if ( this->mainThreadQueue.empty())
+            break;
+
+        int task = this->mainThreadQueue.front();
+        this->mainThreadQueue.pop_front();
+        lock.unlock();
+        run(task);
+        lock.lock();
+    }
+}
+
+std::vector<int> TaskGraph::getCriticalPath()
+{
+    std::vector<int> path;
+    if ( this->tasks.empty())
+        return path;
+
+    // Walk back from the task that finished last, through the dependencies that finished last
+    int task = 0;
+    for ( int i = 1; i < (int) this->tasks.size(); i++ ) {
+        if ( this->tasks[ i ].end > this->tasks[ task ].end )
+            task = i;
+    }
+    while ( task >= 0 ) {
+        path.push_back(task);
+        int latest = -1;
+        for ( int dependency: this->tasks[ task ].dependencies ) {
+            if ( latest < 0 || this->tasks[ dependency ].end > this->tasks[ latest ].end )
+                latest = dependency;
+        }
+        task = latest;
+    }
+    std::reverse(path.begin(), path.end());
+    return path;
+}
+
+const char *TaskGraph::getTaskName(int task)
+{
+    return this->tasks[ task ].name.c_str();
+}
+
+double TaskGraph::getTaskDuration(int task)
+{
+    return this->tasks[ task ].end - this->tasks[ task ].start;
+}
+
+bool TaskGraph::exportTrace(const char *path)
+{
+    std::ofstream file(path);
+    if ( !file.is_open()) {
+        std::cerr << "Failed to open " << path << " for writing the task graph trace." << std::endl;
+        return false;
+    }
+
+    std::vector<int> criticalPath = this->getCriticalPath();
+
+    // The main thread is always shown as the first thread
+    std::unordered_map<std::thread::id, int> threadIndices;
+    threadIndices[ this->mainThread ] = 0;
+
+    file << "{\"traceEvents\":[";
+    for ( int i = 0; i < (int) this->tasks.size(); i++ ) {
+        task_graph_task_t &task = this->tasks[ i ];
+        auto thread = threadIndices.find(task.thread);
+        if ( thread == threadIndices.end())
+            thread = threadIndices.insert({ task.thread, (int) threadIndices.size() }).first;
+        bool critical = std::find(criticalPath.begin(), criticalPath.end(), i) != criticalPath.end();
+
+        file << ( i > 0 ? "," : "" )
+             << "{\"name\":\"" << task.name << "\",\"ph\":\"X\",\"pid\":0"
+             << ",\"tid\":" << thread->second
+             << ",\"ts\":" << task.start * 1000000.0
+             << ",\"dur\":" << ( task.end - task.start ) * 1000000.0
+             << ",\"args\":{\"critical_path\":" << ( critical ? "true" : "false" ) << "}}";
+    }
+    file << "],\"displayTimeUnit\":\"ms\"}" << std::endl;
+    return true;
+}
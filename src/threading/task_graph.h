@@ -0,0 +1,132 @@
+//
+// Created by Luca Warmenhoven on 17/10/2026.
+//
+
+#ifndef GRAPHICS_TEST_TASK_GRAPH_H
+#define GRAPHICS_TEST_TASK_GRAPH_H
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include "job_system.h"
+
+// Tasks that can be executed by any of the workers of the job system
+#define TASK_GRAPH_ANY_THREAD (0)
+// Tasks that have to be executed on the thread calling `execute`, for example because they use OpenGL
+#define TASK_GRAPH_MAIN_THREAD (1)
+
+typedef struct {
+    std::string name;
+    std::function<void()> function;
+    unsigned char affinity;
+
+    std::vector<int> reads;        // The resources the task reads from
+    std::vector<int> writes;       // The resources the task writes to
+    std::vector<int> dependencies; // Explicit and resource derived, filled in by `compile`
+    std::vector<int> dependents;
+
+    // The state of the last execution
+    int remaining_dependencies;
+    std::thread::id thread;
+    double start; // In seconds since the start of the execution
+    double end;
+} task_graph_task_t;
+
+/**
+ * Graph of tasks that are executed once per frame.
+ *
+ * The order between tasks is derived from the resources they declare to read or write,
+ * in the order in which the tasks were added: a task that writes a resource runs after
+ * all earlier tasks using that resource, and a task that reads it runs after the
+ * earlier writer. Additional ordering can be declared with `dependsOn`.
+ * Tasks without a path between them run concurrently on the job system.
+ */
+class TaskGraph
+{
+
+private:
+
+    std::vector<task_graph_task_t> tasks;
+    std::vector<std::string> resources;
+    bool compiled;
+
+    std::mutex mutex;
+    std::condition_variable condition;
+    std::deque<int> mainThreadQueue;
+    size_t completedCount;
+
+    JobSystem *jobs;
+    std::thread::id mainThread;
+    std::chrono::steady_clock::time_point executionStart;
+
+    /** Hands a task of which all dependencies have finished to the thread it has to run on */
+    void schedule(int task);
+
+    void run(int task);
+
+public:
+
+    TaskGraph();
+
+    /**
+     * Declares a resource that tasks can read from or write to.
+     * @return The identifier of the resource
+     */
+    int addResource(const char *name);
+
+    /**
+     * Adds a task to the graph.
+     * @param affinity TASK_GRAPH_ANY_THREAD or TASK_GRAPH_MAIN_THREAD
+     * @return The identifier of the task
+     */
+    int addTask(const char *name, std::function<void()> function, unsigned char affinity);
+
+    void reads(int task, int resource);
+
+    void writes(int task, int resource);
+
+    /**
+     * Makes sure a task only starts after another task has finished.
+     */
+    void dependsOn(int task, int dependency);
+
+    /**
+     * Derives the dependencies between the tasks.
+     * Called by `execute` when the graph changed, but can be called up front to validate it.
+     * @return Whether the graph is free of cycles
+     */
+    bool compile();
+
+    /**
+     * Executes all tasks once, and returns after they have finished.
+     * The calling thread executes the TASK_GRAPH_MAIN_THREAD tasks, the other tasks are submitted to the job system.
+     */
+    void execute(JobSystem *jobSystem);
+
+    /**
+     * The chain of tasks that determined the duration of the last execution, in execution order.
+     * Every task in it is the dependency that finished last before the next task could start.
+     */
+    std::vector<int> getCriticalPath();
+
+    const char *getTaskName(int task);
+
+    /**
+     * Get the duration of a task during the last execution, in seconds.
+     */
+    double getTaskDuration(int task);
+
+    /**
+     * Writes the timings of the last execution to a file in the Chrome trace event format,
+     * which can be opened in chrome://tracing or Perfetto. Tasks on the critical path are marked.
+     * @return Whether the file could be written
+     */
+    bool exportTrace(const char *path);
+};
+
+#endif //GRAPHICS_TEST_TASK_GRAPH_H
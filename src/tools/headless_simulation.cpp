@@ -0,0 +1,112 @@
+//
+// Created by Luca Warmenhoven on 17/10/2026.
+//
+
+#include <iostream>
+#include <cstring>
+#include <thread>
+#include "../world/world.h"
+#include "../world/entity/player.h"
+
+using namespace std::chrono;
+
+#define HEADLESS_TICK_COUNT (3600)
+#define HEADLESS_DELTA_TIME (1.0f / 60.0f)
+// Without a GPU adding a chunk is cheap, so more of them are added per tick
+#define HEADLESS_UPLOAD_BUDGET (16)
+// The amount of ticks between two status lines
+#define HEADLESS_REPORT_INTERVAL (600)
+
+/*
+ * Runs the world simulation without a window or OpenGL context.
+ * The player walks forward at a fixed time step, while the chunks around it
+ * are generated, loaded and saved like they would be in the game.
+ *
+ * Usage: world_headless [--ticks N] [--tick-rate R] [--save directory] [--connect socket] [--pipeline-stats S]
+ *                       [--warm-start 0|1]
+ * A tick rate of 0, the default, runs the ticks as fast as possible.
+ * With --warm-start 1 the chunks around the player are generated on all cores before the first tick.
+ * With --pipeline-stats the chunk pipeline stats are logged every S seconds, and after the last tick.
+ */
+int main(int argc, char **argv)
+{
+    int tickCount = HEADLESS_TICK_COUNT;
+    int tickRate = 0;
+    const char *saveDirectory = nullptr;
+    const char *chunkServerPath = nullptr;
+    bool warmStart = false;
+    for ( int i = 1; i + 1 < argc; i += 2 ) {
+        if ( strcmp(argv[ i ], "--ticks") == 0 )
+            tickCount = atoi(argv[ i + 1 ]);
+        else if ( strcmp(argv[ i ], "--tick-rate") == 0 )
+            tickRate = atoi(argv[ i + 1 ]);
+        else if ( strcmp(argv[ i ], "--save") == 0 )
+            saveDirectory = argv[ i + 1 ];
+        else if ( strcmp(argv[ i ], "--connect") == 0 )
+            chunkServerPath = argv[ i + 1 ];
+        else if ( strcmp(argv[ i ], "--pipeline-stats") == 0 )
+            World::pipelineStatsInterval = std::max(1, atoi(argv[ i + 1 ]));
+        else if ( strcmp(argv[ i ], "--warm-start") == 0 )
+            warmStart = atoi(argv[ i + 1 ]) != 0;
+        else {
+            std::cerr << "Unknown option " << argv[ i ] << std::endl;
+            return 1;
+        }
+    }
+
+    Player player = Player();
+    player.frictionConstant = 10.0f;
+    player.position = glm::vec3(10, 10, 10);
+
+    auto *world = new World();
+    world->uploadBudget = HEADLESS_UPLOAD_BUDGET;
+    if ( saveDirectory )
+        world->openStorage(saveDirectory);
+    if ( chunkServerPath )
+        world->connectChunkServer(chunkServerPath);
+    world->loadEntities({ &player });
+    if ( warmStart ) {
+        double warmStartBegin = ChunkPipelineStats::now();
+        world->warmStart(&player);
+        std::cout << "warm start: " << world->chunkMap->size() << " chunks in "
+                  << ChunkPipelineStats::now() - warmStartBegin << "s" << std::endl;
+    }
+    world->startWorldGeneration(&player);
+    world->worldObjects->push_back(&player);
+
+    duration start = steady_clock::now().time_since_epoch();
+    duration tickInterval = tickRate > 0 ? duration_cast<steady_clock::duration>(seconds(1)) / tickRate
+                                         : steady_clock::duration::zero();
+    duration nextTick = start;
+
+    for ( int tick = 1; tick <= tickCount; tick++ ) {
+        // Walk forward, keeping to the ground
+        player.applyInput(glm::vec3(1, 0, 0), HEADLESS_DELTA_TIME);
+        world->update(HEADLESS_DELTA_TIME);
+        player.position.y = std::max(player.position.y, world->getHeightAt(player.position.x, player.position.z));
+        world->applyChanges();
+
+        if ( tick % HEADLESS_REPORT_INTERVAL == 0 || tick == tickCount ) {
+            std::cout << "tick " << tick << ": " << world->chunkMap->size() << " chunks, player at ("
+                      << player.position.x << ", " << player.position.y << ", " << player.position.z << ")"
+                      << std::endl;
+        }
+
+        if ( tickRate > 0 ) {
+            nextTick += tickInterval;
+            std::this_thread::sleep_for(nextTick - steady_clock::now().time_since_epoch());
+        }
+    }
+
+    double elapsed = (double) duration_cast<microseconds>(steady_clock::now().time_since_epoch() - start).count() /
+                     1000000.0;
+    std::cout << tickCount << " ticks in " << elapsed << "s, " << tickCount / elapsed << " ticks per second"
+              << std::endl;
+
+    world->stopWorldGeneration();
+    if ( World::pipelineStatsInterval > 0 )
+        world->pipelineStats.log(std::cout);
+    world->save();
+    delete world;
+    return 0;
+}
@@ -0,0 +1,246 @@
+//
+// Created by Luca Warmenhoven on 17/10/2026.
+//
+
+#include <iostream>
+#include <cstring>
+#include <csignal>
+#include <atomic>
+#include <thread>
+#include <cmath>
+#include "../world/world.h"
+#include "../world/terrain_generator.h"
+#include "../world/height_map_codec.h"
+
+using namespace std::chrono;
+
+#define PREBAKE_SAVE_DIRECTORY "save"
+// The interval between two progress lines, in seconds
+#define PREBAKE_REPORT_INTERVAL (1)
+// The amount of chunks between two flushes of the region files
+#define PREBAKE_FLUSH_INTERVAL (4096)
+
+static std::atomic<bool> interrupted = false;
+
+static void onInterrupt(int)
+{
+    interrupted = true;
+}
+
+/**
+ * Generates the area in chunks of `size` by `size` samples, without storing them.
+ * @return The amount of seconds it took
+ */
+static double generateArea(const int32_t *area, int size, JobSystem &jobs, size_t &chunkCount)
+{
+    int32_t x0 = area[ 0 ] * CHUNK_SIZE, z0 = area[ 1 ] * CHUNK_SIZE;
+    int32_t x1 = area[ 2 ] * CHUNK_SIZE, z1 = area[ 3 ] * CHUNK_SIZE;
+    chunkCount = 0;
+
+    duration start = steady_clock::now().time_since_epoch();
+    for ( int32_t x = x0; x < x1; x += size ) {
+        for ( int32_t z = z0; z < z1; z += size ) {
+            jobs.submit([size, x, z] {
+                if ( interrupted )
+                    return;
+                std::vector<float> heights((size_t) size * size);
+                TerrainGenerator::getChunkHeights(size, x, z, heights.data());
+            });
+            chunkCount++;
+        }
+    }
+    jobs.wait();
+    return (double) duration_cast<microseconds>(steady_clock::now().time_since_epoch() - start).count() / 1000000.0;
+}
+
+static void reportThroughput(const char *label, int size, size_t chunkCount, double elapsed)
+{
+    std::cout << label << " " << size << ": " << chunkCount << " chunks in " << elapsed << "s, "
+              << (double) chunkCount / elapsed << " chunks per second, "
+              << (double) chunkCount * size * size / elapsed / 1000000.0 << " million samples per second"
+              << std::endl;
+}
+
+/**
+ * Generates the area with every chunk size ChunkGenerator is instantiated for, without storing
+ * the chunks, and reports the throughput of each. The area is the same amount of height map
+ * cells for every size, so the sizes can be compared by their samples per second.
+ * The area is then generated once more with the biomes evaluated through their noise graphs
+ * instead of their specializations, which are compared by their output as well.
+ */
+static void benchmark(const int32_t *area, int threadCount)
+{
+    JobSystem jobs(threadCount);
+    size_t chunkCount;
+    for ( int size: CHUNK_GENERATOR_SIZES ) {
+        double elapsed = generateArea(area, size, jobs, chunkCount);
+        if ( interrupted )
+            return;
+        reportThroughput("Chunk size", size, chunkCount, elapsed);
+    }
+
+    TerrainGenerator::setBiomeSpecialization(false);
+    double elapsed = generateArea(area, CHUNK_SIZE, jobs, chunkCount);
+    float graphHeights[ CHUNK_SIZE * CHUNK_SIZE ], heights[ CHUNK_SIZE * CHUNK_SIZE ];
+    TerrainGenerator::getChunkHeights(area[ 0 ] * CHUNK_SIZE, area[ 1 ] * CHUNK_SIZE, graphHeights);
+    TerrainGenerator::setBiomeSpecialization(true);
+    if ( interrupted )
+        return;
+    reportThroughput("Noise graphs, chunk size", CHUNK_SIZE, chunkCount, elapsed);
+
+    TerrainGenerator::getChunkHeights(area[ 0 ] * CHUNK_SIZE, area[ 1 ] * CHUNK_SIZE, heights);
+    float difference = 0.0f;
+    for ( int i = 0; i < CHUNK_SIZE * CHUNK_SIZE; i++ )
+        difference = std::max(difference, std::abs(graphHeights[ i ] - heights[ i ]));
+    std::cout << "Largest height difference between the noise graphs and their specializations: " << difference
+              << std::endl;
+}
+
+/*
+ * Generates the chunks of a rectangular area ahead of time, and stores them in a save
+ * the game loads them from instead of generating them.
+ *
+ * The chunks are generated by a worker per core, in the order of their region files.
+ * Chunks that are already stored are skipped, so an interrupted bake continues where it stopped.
+ * Interrupting with ctrl-c finishes the chunks in progress before exiting.
+ *
+ * Usage: world_prebake --area x0 z0 x1 z1 [--seed seed] [--save directory] [--threads count] [--benchmark]
+ * The area contains the chunks from (x0, z0) up to, but not including, (x1, z1), in chunks.
+ * With --benchmark the area is generated at every instantiated chunk size instead, without storing it,
+ * and with the biomes evaluated through their noise graphs.
+ */
+int main(int argc, char **argv)
+{
+    int32_t area[ 4 ] = { 0, 0, 0, 0 };
+    bool hasArea = false, hasSeed = false, benchmarkSizes = false;
+    uint32_t seed = 0;
+    const char *saveDirectory = PREBAKE_SAVE_DIRECTORY;
+    int threadCount = std::max(1, (int) std::thread::hardware_concurrency());
+
+    for ( int i = 1; i < argc; i++ ) {
+        if ( strcmp(argv[ i ], "--area") == 0 && i + 4 < argc ) {
+            for ( int32_t &coordinate: area )
+                coordinate = atoi(argv[ ++i ]);
+            hasArea = true;
+        } else if ( strcmp(argv[ i ], "--seed") == 0 && i + 1 < argc ) {
+            seed = (uint32_t) strtoul(argv[ ++i ], nullptr, 10);
+            hasSeed = true;
+        } else if ( strcmp(argv[ i ], "--save") == 0 && i + 1 < argc ) {
+            saveDirectory = argv[ ++i ];
+        } else if ( strcmp(argv[ i ], "--threads") == 0 && i + 1 < argc ) {
+            threadCount = std::max(1, atoi(argv[ ++i ]));
+        } else if ( strcmp(argv[ i ], "--benchmark") == 0 ) {
+            benchmarkSizes = true;
+        } else {
+            std::cerr << "Unknown option " << argv[ i ] << std::endl;
+            return 1;
+        }
+    }
+    if ( !hasArea || area[ 2 ] <= area[ 0 ] || area[ 3 ] <= area[ 1 ] ) {
+        std::cerr << "Usage: world_prebake --area x0 z0 x1 z1 [--seed seed] [--save directory] [--threads count]"
+                     " [--benchmark]" << std::endl;
+        return 1;
+    }
+
+    if ( benchmarkSizes ) {
+        TerrainGenerator::setSeed(seed);
+        signal(SIGINT, onInterrupt);
+        benchmark(area, threadCount);
+        return interrupted ? 1 : 0;
+    }
+
+    WorldStorage storage(saveDirectory, CHUNK_SIZE);
+    uint32_t storedSeed;
+    if ( storage.readSeed(storedSeed)) {
+        if ( hasSeed && storedSeed != seed ) {
+            std::cerr << "The save was generated with seed " << storedSeed << ", not " << seed << "." << std::endl;
+            return 1;
+        }
+        seed = storedSeed;
+    } else if ( !storage.writeSeed(seed)) {
+        return 1;
+    }
+    TerrainGenerator::setSeed(seed);
+
+    // Chunks are visited region by region, so the workers write to few region files at a time
+    std::vector<glm::ivec2> chunks;
+    auto regionOf = [](int32_t chunk) {
+        return (int32_t) std::floor((float) chunk / WORLD_STORAGE_REGION_SIZE);
+    };
+    for ( int32_t regionX = regionOf(area[ 0 ]); regionX <= regionOf(area[ 2 ] - 1); regionX++ )
+        for ( int32_t regionZ = regionOf(area[ 1 ]); regionZ <= regionOf(area[ 3 ] - 1); regionZ++ )
+            for ( int32_t i = 0; i < WORLD_STORAGE_REGION_SIZE; i++ )
+                for ( int32_t j = 0; j < WORLD_STORAGE_REGION_SIZE; j++ ) {
+                    int32_t x = regionX * WORLD_STORAGE_REGION_SIZE + i;
+                    int32_t z = regionZ * WORLD_STORAGE_REGION_SIZE + j;
+                    if ( x >= area[ 0 ] && x < area[ 2 ] && z >= area[ 1 ] && z < area[ 3 ] )
+                        chunks.emplace_back(x, z);
+                }
+
+    std::cout << "Baking " << chunks.size() << " chunks with seed " << seed << " on " << threadCount
+              << " threads into " << saveDirectory << std::endl;
+    signal(SIGINT, onInterrupt);
+
+    std::atomic<size_t> generated = 0, skipped = 0, failed = 0;
+    JobSystem jobs(threadCount);
+    for ( glm::ivec2 chunk: chunks ) {
+        jobs.submit([&storage, &generated, &skipped, &failed, chunk] {
+            if ( interrupted )
+                return;
+
+            int32_t x = chunk.x * CHUNK_SIZE;
+            int32_t z = chunk.y * CHUNK_SIZE;
+            if ( storage.hasChunk(x, z)) {
+                skipped++;
+                return;
+            }
+
+            float heights[ CHUNK_SIZE * CHUNK_SIZE ];
+            uint16_t quantized[ CHUNK_SIZE * CHUNK_SIZE ];
+            float minimum, scale;
+            TerrainGenerator::getChunkHeights(x, z, heights);
+            HeightMapCodec::quantize(heights, CHUNK_SIZE * CHUNK_SIZE, quantized, minimum, scale);
+            if ( !storage.writeChunk(x, z, quantized, minimum, scale)) {
+                failed++;
+                return;
+            }
+            if ( ++generated % PREBAKE_FLUSH_INTERVAL == 0 )
+                storage.flush();
+        });
+    }
+
+    duration start = steady_clock::now().time_since_epoch();
+    auto elapsedSince = [](steady_clock::duration since) {
+        return (double) duration_cast<microseconds>(steady_clock::now().time_since_epoch() - since).count() /
+               1000000.0;
+    };
+    duration lastReport = start;
+    size_t lastGenerated = 0;
+    while ( jobs.getPendingJobCount() > 0 && !interrupted ) {
+        std::this_thread::sleep_for(milliseconds(50));
+        double sinceReport = elapsedSince(lastReport);
+        if ( sinceReport < PREBAKE_REPORT_INTERVAL )
+            continue;
+
+        size_t done = generated + skipped + failed;
+        std::cout << done << "/" << chunks.size() << " chunks, "
+                  << (double) ( generated - lastGenerated ) / sinceReport << " chunks per second" << std::endl;
+        lastReport = steady_clock::now().time_since_epoch();
+        lastGenerated = generated;
+    }
+    jobs.wait();
+    storage.flush();
+
+    double elapsed = elapsedSince(start);
+    std::cout << "Generated " << generated << " chunks in " << elapsed << "s, " << (double) generated / elapsed
+              << " chunks per second, " << skipped << " were already stored";
+    if ( failed > 0 )
+        std::cout << ", " << failed << " failed to write";
+    std::cout << "." << std::endl;
+
+    if ( interrupted ) {
+        std::cout << "Interrupted, run the same command again to continue." << std::endl;
+        return 1;
+    }
+    return failed > 0 ? 1 : 0;
+}
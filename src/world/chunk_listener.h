@@ -0,0 +1,62 @@
+//
+// Created by Luca Warmenhoven on 17/10/2026.
+//
+
+#ifndef GRAPHICS_TEST_CHUNK_LISTENER_H
+#define GRAPHICS_TEST_CHUNK_LISTENER_H
+
+#include <cstdint>
+
+struct chunk_t;
+
+/**
+ * Receives the changes to the chunks of a World, for example to keep a GPU copy of them.
+ * The world itself doesn't depend on a listener, so it can run without any.
+ * See World::setChunkListener.
+ */
+class ChunkListener
+{
+public:
+
+    virtual ~ChunkListener() = default;
+
+    /**
+     * Called on a generation worker right after a chunk has been generated, before it's added to the world.
+     * Work that doesn't need the thread owning the OpenGL context, like meshing, belongs here.
+     *
+     * @param heights The (CHUNK_SIZE + 1)^2 heights of the grid vertices of the chunk, where the last row
+     *                and column are the first samples of the neighbouring chunks. Vertex (i, j) is at [i * (CHUNK_SIZE + 1) + j].
+     * @param loaded Whether the heights were loaded from the save or the chunk server, rather than generated.
+     */
+    virtual void onChunkGenerated(chunk_t *chunk, const float *heights, bool loaded) = 0;
+
+    /**
+     * Called when a generated chunk is added to the world, on the thread calling World::applyChanges.
+     */
+    virtual void onChunkAdded(chunk_t *chunk) = 0;
+
+    /**
+     * Called instead of `onChunkAdded` when the world stops before a generated chunk was added.
+     */
+    virtual void onChunkDiscarded(chunk_t *chunk) = 0;
+
+    /**
+     * Called when a chunk that moved out of the draw distance has been removed from the world,
+     * on the thread calling World::applyChanges, one call after the chunk was removed from the chunk map.
+     * The chunk is freed afterwards.
+     */
+    virtual void onChunkRemoved(chunk_t *chunk) = 0;
+
+    /**
+     * Called when the heights of a rectangle of grid vertices of a loaded chunk changed,
+     * on the thread calling World::applyChanges. The rectangle extends one vertex
+     * beyond the grid on every side, and includes the vertices of which the normal changed.
+     *
+     * @param heights The new heights of the rectangle, with a border of one sample on every side.
+     *                Vertex (i, j) is at [(i - minI + 1) * (maxJ - minJ + 3) + (j - minJ + 1)].
+     */
+    virtual void onChunkChanged(chunk_t *chunk, int32_t minI, int32_t minJ, int32_t maxI, int32_t maxJ,
+                                const float *heights) = 0;
+};
+
+#endif //GRAPHICS_TEST_CHUNK_LISTENER_H
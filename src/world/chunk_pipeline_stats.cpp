@@ -0,0 +1,120 @@
+//
+// Created by Luca Warmenhoven on 17/10/2026.
+//
+
+#include "chunk_pipeline_stats.h"
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+
+using namespace std::chrono;
+
+static const char *STAGE_NAMES[CHUNK_STAGE_COUNT] = {
+        "scan", "queued", "generation", "upload wait", "upload", "draw wait", "total"
+};
+
+ChunkPipelineStats::ChunkPipelineStats()
+{
+    this->reset();
+}
+
+double ChunkPipelineStats::now()
+{
+    static const steady_clock::time_point start = steady_clock::now();
+    return (double) duration_cast<microseconds>(steady_clock::now() - start).count() / 1000000.0;
+}
+
+const char *ChunkPipelineStats::getStageName(int stage)
+{
+    return STAGE_NAMES[ stage ];
+}
+
+void ChunkPipelineStats::record(int stage, double seconds)
+{
+    auto microseconds = (uint64_t) ( seconds > 0.0 ? seconds * 1000000.0 : 0.0 );
+    int bucket = microseconds == 0 ? 0 : 64 - __builtin_clzll(microseconds);
+    bucket = bucket < CHUNK_STATS_BUCKET_COUNT ? bucket : CHUNK_STATS_BUCKET_COUNT - 1;
+
+    this->buckets[ stage ][ bucket ]++;
+    this->counts[ stage ]++;
+    this->totalMicroseconds[ stage ] += microseconds;
+    uint64_t maximum = this->maximumMicroseconds[ stage ];
+    while ( microseconds > maximum && !this->maximumMicroseconds[ stage ].compare_exchange_weak(maximum, microseconds));
+}
+
+void ChunkPipelineStats::recordUploaded(const chunk_timestamps_t &timestamps)
+{
+    this->record(CHUNK_STAGE_QUEUED, timestamps.generation_started - timestamps.requested);
+    this->record(CHUNK_STAGE_GENERATION, timestamps.generated - timestamps.generation_started);
+    this->record(CHUNK_STAGE_UPLOAD_WAIT, timestamps.upload_started - timestamps.generated);
+    this->record(CHUNK_STAGE_UPLOAD, timestamps.uploaded - timestamps.upload_started);
+}
+
+void ChunkPipelineStats::recordDrawn(const chunk_timestamps_t &timestamps)
+{
+    this->record(CHUNK_STAGE_DRAW_WAIT, timestamps.first_drawn - timestamps.uploaded);
+    this->record(CHUNK_STAGE_TOTAL, timestamps.first_drawn - timestamps.requested);
+}
+
+uint64_t ChunkPipelineStats::getCount(int stage) const
+{
+    return this->counts[ stage ];
+}
+
+double ChunkPipelineStats::getMean(int stage) const
+{
+    uint64_t count = this->counts[ stage ];
+    return count == 0 ? 0.0 : (double) this->totalMicroseconds[ stage ] / (double) count / 1000000.0;
+}
+
+double ChunkPipelineStats::getMaximum(int stage) const
+{
+    return (double) this->maximumMicroseconds[ stage ] / 1000000.0;
+}
+
+double ChunkPipelineStats::getPercentile(int stage, double fraction) const
+{
+    uint64_t count = this->counts[ stage ];
+    if ( count == 0 )
+        return 0.0;
+
+    auto target = (uint64_t) ( fraction * (double) count );
+    uint64_t seen = 0;
+    for ( int bucket = 0; bucket < CHUNK_STATS_BUCKET_COUNT; bucket++ ) {
+        seen += this->buckets[ stage ][ bucket ];
+        if ( seen > target )
+            return std::min((double) ( 1ULL << bucket ) / 1000000.0, this->getMaximum(stage));
+    }
+    return this->getMaximum(stage);
+}
+
+void ChunkPipelineStats::reset()
+{
+    for ( int stage = 0; stage < CHUNK_STAGE_COUNT; stage++ ) {
+        for ( std::atomic<uint64_t> &bucket: this->buckets[ stage ] )
+            bucket = 0;
+        this->counts[ stage ] = 0;
+        this->totalMicroseconds[ stage ] = 0;
+        this->maximumMicroseconds[ stage ] = 0;
+    }
+}
+
+void ChunkPipelineStats::log(std::ostream &out) const
+{
+    std::ios_base::fmtflags flags = out.flags();
+    std::streamsize precision = out.precision();
+
+    out << "Chunk pipeline, in ms (count, mean, p50, p90, p99, max):" << std::endl;
+    out << std::fixed << std::setprecision(2);
+    for ( int stage = 0; stage < CHUNK_STAGE_COUNT; stage++ ) {
+        out << "  " << std::left << std::setw(12) << getStageName(stage) << std::right
+            << std::setw(8) << this->getCount(stage)
+            << std::setw(10) << this->getMean(stage) * 1000.0
+            << std::setw(10) << this->getPercentile(stage, 0.5) * 1000.0
+            << std::setw(10) << this->getPercentile(stage, 0.9) * 1000.0
+            << std::setw(10) << this->getPercentile(stage, 0.99) * 1000.0
+            << std::setw(10) << this->getMaximum(stage) * 1000.0 << std::endl;
+    }
+    out.flags(flags);
+    out.precision(precision);
+}
@@ -0,0 +1,102 @@
+//
+// Created by Luca Warmenhoven on 17/10/2026.
+//
+
+#ifndef GRAPHICS_TEST_CHUNK_PIPELINE_STATS_H
+#define GRAPHICS_TEST_CHUNK_PIPELINE_STATS_H
+
+#include <atomic>
+#include <cstdint>
+#include <ostream>
+
+// The stages of the chunk pipeline, each measured between two of the timestamps of a chunk
+#define CHUNK_STAGE_SCAN (0)        // One scan of the chunks around the observation point, including the requests
+#define CHUNK_STAGE_QUEUED (1)      // From requested until a generation worker picked the chunk up
+#define CHUNK_STAGE_GENERATION (2)  // From generation started until generated
+#define CHUNK_STAGE_UPLOAD_WAIT (3) // From generated until the upload budget let the chunk through
+#define CHUNK_STAGE_UPLOAD (4)      // From upload started until uploaded, the chunk listener adding it
+#define CHUNK_STAGE_DRAW_WAIT (5)   // From uploaded until the chunk was first drawn
+#define CHUNK_STAGE_TOTAL (6)       // From requested until the chunk was first drawn
+#define CHUNK_STAGE_COUNT (7)
+
+// Bucket 0 holds durations below a microsecond, bucket b durations from 2^(b - 1) up to 2^b microseconds
+#define CHUNK_STATS_BUCKET_COUNT (32)
+
+/**
+ * The moments a chunk passed through the pipeline, in seconds on the ChunkPipelineStats clock.
+ * Moments the chunk hasn't reached yet are 0.
+ */
+typedef struct {
+    double requested;
+    double generation_started;
+    double generated;
+    double upload_started;
+    double uploaded;
+    double first_drawn;
+} chunk_timestamps_t;
+
+/**
+ * Histograms of the time chunks spend in every stage of the pipeline from being requested
+ * to being drawn, to find where terrain that appears late loses its time.
+ * The histograms have logarithmic buckets, so percentiles are accurate to a factor of two.
+ * All methods are safe to call from any thread.
+ */
+class ChunkPipelineStats
+{
+
+private:
+    std::atomic<uint64_t> buckets[CHUNK_STAGE_COUNT][CHUNK_STATS_BUCKET_COUNT];
+    std::atomic<uint64_t> counts[CHUNK_STAGE_COUNT];
+    std::atomic<uint64_t> totalMicroseconds[CHUNK_STAGE_COUNT];
+    std::atomic<uint64_t> maximumMicroseconds[CHUNK_STAGE_COUNT];
+
+public:
+
+    ChunkPipelineStats();
+
+    /**
+     * The current time on the clock of the timestamps, in seconds.
+     */
+    static double now();
+
+    static const char *getStageName(int stage);
+
+    /**
+     * Adds a duration to the histogram of a stage.
+     */
+    void record(int stage, double seconds);
+
+    /**
+     * Records the stages up to the upload of a chunk that was just added to the world.
+     */
+    void recordUploaded(const chunk_timestamps_t &timestamps);
+
+    /**
+     * Records the stages after the upload of a chunk that was just drawn for the first time.
+     */
+    void recordDrawn(const chunk_timestamps_t &timestamps);
+
+    uint64_t getCount(int stage) const;
+
+    /**
+     * Get the mean duration of a stage, in seconds.
+     */
+    double getMean(int stage) const;
+
+    double getMaximum(int stage) const;
+
+    /**
+     * Get the duration below which `fraction` of the durations of a stage lie, in seconds.
+     * This is the upper bound of the bucket the percentile falls in.
+     */
+    double getPercentile(int stage, double fraction) const;
+
+    void reset();
+
+    /**
+     * Writes a line per stage with its count, mean, 50th, 90th and 99th percentile and maximum.
+     */
+    void log(std::ostream &out) const;
+};
+
+#endif //GRAPHICS_TEST_CHUNK_PIPELINE_STATS_H
@@ -6,7 +6,7 @@
 #define GRAPHICS_TEST_ENTITY_H
 
 #include <glm/glm.hpp>
-#include "../../rendering/renderer.h"
+#include "../../math/transformation.h"
 
 class Entity : public Transformation
 {
@@ -9,17 +9,10 @@
 void Player::update(float deltaTime)
 {
     Entity::update(deltaTime);
-    this->handleInput(glfwGetCurrentContext(), deltaTime);
 }
 
-void Player::handleInput(GLFWwindow *window, float deltaTime)
+void Player::applyInput(glm::vec3 direction, float deltaTime)
 {
-    auto direction = glm::vec3(
-            ( glfwGetKey(window, GLFW_KEY_W) - glfwGetKey(window, GLFW_KEY_S)),
-            ( glfwGetKey(window, GLFW_KEY_SPACE) - glfwGetKey(window, GLFW_KEY_LEFT_SHIFT)),
-            ( glfwGetKey(window, GLFW_KEY_D) - glfwGetKey(window, GLFW_KEY_A))
-    );
-
     // Get the angle at which to move to
     float angle = -this->yaw - 90.f +
                   ( direction.z != 0 ? ( direction.x != 0 ? direction.z * 45.f : 0 ) : direction.z * 90.f );
@@ -6,7 +6,6 @@
 #define GRAPHICS_TEST_PLAYER_H
 
 #include "entity.h"
-#include <GLFW/glfw3.h>
 #include <glm/glm.hpp>
 
 
@@ -22,6 +21,11 @@ public:
     Player() : Entity()
     {}
 
+    /**
+     * Updates the position of the player.
+     * The input isn't handled here, as the window only allows querying it on the main thread,
+     * while the update can run on any thread. Call `applyInput` on the main thread before updating.
+     */
     void update(float deltaTime);
 
     const float movementSpeedForce = 10000.0f;
@@ -42,9 +46,11 @@ public:
      * This will update the acceleration, velocity and position
      * accordingly.
      *
+     * @param direction The pressed movement keys, each axis in [-1, 1]:
+     *                  x forwards, y upwards and z to the right, relative to where the player looks
      * @param deltaTime
      */
-    void handleInput(GLFWwindow *window, float deltaTime);
+    void applyInput(glm::vec3 direction, float deltaTime);
 };
 
 #endif //GRAPHICS_TEST_PLAYER_H
@@ -0,0 +1,242 @@
+//
+// Created by Luca Warmenhoven on 17/10/2026.
+//
+
+#include "height_map_codec.h"
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+void HeightMapCodec::quantize(const float *heights, size_t count, uint16_t *quantized, float &minimum, float &scale)
+{
+    float maximum = -INFINITY;
+    minimum = INFINITY;
+    for ( size_t i = 0; i < count; i++ ) {
+        minimum = std::min(minimum, heights[ i ]);
+        maximum = std::max(maximum, heights[ i ]);
+    }
+
+    // A flat height map is stored with a scale of 0, all samples are 0 then
+    scale = ( maximum - minimum ) / 65535.0f;
+    float inverseScale = scale > 0.0f ? 1.0f / scale : 0.0f;
+    for ( size_t i = 0; i < count; i++ )
+        quantized[ i ] = (uint16_t) std::min(65535.0f, std::round(( heights[ i ] - minimum ) * inverseScale));
+}
+
+void HeightMapCodec::dequantize(const uint16_t *quantized, size_t count, float minimum, float scale, float *heights)
+{
+    size_t i = 0;
+
+#if defined(__SSE2__)
+    __m128 minimumVector = _mm_set1_ps(minimum);
+    __m128 scaleVector = _mm_set1_ps(scale);
+    __m128i zero = _mm_setzero_si128();
+    for ( ; i + 8 <= count; i += 8 ) {
+        __m128i samples = _mm_loadu_si128((const __m128i *) ( quantized + i ));
+        __m128 low = _mm_cvtepi32_ps(_mm_unpacklo_epi16(samples, zero));
+        __m128 high = _mm_cvtepi32_ps(_mm_unpackhi_epi16(samples, zero));
+        _mm_storeu_ps(heights + i, _mm_add_ps(minimumVector, _mm_mul_ps(low, scaleVector)));
+        _mm_storeu_ps(heights + i + 4, _mm_add_ps(minimumVector, _mm_mul_ps(high, scaleVector)));
+    }
+#elif defined(__ARM_NEON)
+    float32x4_t minimumVector = vdupq_n_f32(minimum);
+    for ( ; i + 8 <= count; i += 8 ) {
+        uint16x8_t samples = vld1q_u16(quantized + i);
+        float32x4_t low = vcvtq_f32_u32(vmovl_u16(vget_low_u16(samples)));
+        float32x4_t high = vcvtq_f32_u32(vmovl_u16(vget_high_u16(samples)));
+        vst1q_f32(heights + i, vmlaq_n_f32(minimumVector, low, scale));
+        vst1q_f32(heights + i + 4, vmlaq_n_f32(minimumVector, high, scale));
+    }
+#endif
+
+    for ( ; i < count; i++ )
+        heights[ i ] = dequantize(quantized[ i ], minimum, scale);
+}
+
+/**
+ * Writes bits most significant bit first.
+ */
+typedef struct {
+    std::vector<uint8_t> *bytes;
+    uint64_t buffer;
+    int count;
+} bit_writer_t;
+
+static void writeBits(bit_writer_t &writer, uint32_t value, int bits)
+{
+    writer.buffer = ( writer.buffer << bits ) | value;
+    writer.count += bits;
+    while ( writer.count >= 8 ) {
+        writer.count -= 8;
+        writer.bytes->push_back((uint8_t) ( writer.buffer >> writer.count ));
+    }
+}
+
+static void flushBits(bit_writer_t &writer)
+{
+    if ( writer.count > 0 )
+        writer.bytes->push_back((uint8_t) ( writer.buffer << ( 8 - writer.count )));
+    writer.count = 0;
+}
+
+typedef struct {
+    const uint8_t *bytes;
+    size_t size;
+    size_t position; // The next byte to move into the buffer, might lie past the end
+    uint64_t buffer; // The next bits, aligned to the most significant bit
+    int count;
+} bit_reader_t;
+
+/**
+ * Fills the buffer up to at least 57 bits, with zeros once the bytes run out.
+ */
+static inline void refill(bit_reader_t &reader)
+{
+    while ( reader.count <= 56 ) {
+        uint64_t byte = reader.position < reader.size ? reader.bytes[ reader.position ] : 0;
+        reader.buffer |= byte << ( 56 - reader.count );
+        reader.position++;
+        reader.count += 8;
+    }
+}
+
+/**
+ * Whether more bits were consumed than there are bytes.
+ */
+static inline bool overran(const bit_reader_t &reader)
+{
+    return reader.position * 8 - reader.count > reader.size * 8;
+}
+
+static inline uint32_t readBits(bit_reader_t &reader, int bits)
+{
+    refill(reader);
+    auto value = (uint32_t) ( reader.buffer >> ( 64 - bits ));
+    reader.buffer <<= bits;
+    reader.count -= bits;
+    return value;
+}
+
+/**
+ * Counts and consumes the ones before the next zero, up to HEIGHT_MAP_RICE_ESCAPE.
+ */
+static inline int readUnary(bit_reader_t &reader)
+{
+    refill(reader);
+    int ones = ~reader.buffer == 0 ? 64 : __builtin_clzll(~reader.buffer);
+    if ( ones >= HEIGHT_MAP_RICE_ESCAPE ) {
+        reader.buffer <<= HEIGHT_MAP_RICE_ESCAPE;
+        reader.count -= HEIGHT_MAP_RICE_ESCAPE;
+        return HEIGHT_MAP_RICE_ESCAPE;
+    }
+    reader.buffer <<= ones + 1;
+    reader.count -= ones + 1;
+    return ones;
+}
+
+static inline uint32_t zigzag(int32_t value)
+{
+    return ((uint32_t) value << 1 ) ^ (uint32_t) ( value >> 31 );
+}
+
+static inline int32_t unzigzag(uint32_t value)
+{
+    return (int32_t) ( value >> 1 ) ^ -(int32_t) ( value & 1 );
+}
+
+/**
+ * Predicts a sample from its already coded neighbours, assuming the surface is locally planar.
+ * The first row and column only have one neighbour to predict from.
+ */
+static inline int32_t predict(const uint16_t *quantized, size_t row, size_t i, size_t rowLength)
+{
+    if ( row == 0 )
+        return i > 0 ? quantized[ i - 1 ] : 0;
+    if ( i == 0 )
+        return quantized[ row - rowLength ];
+    int32_t prediction = (int32_t) quantized[ row + i - 1 ] + quantized[ row - rowLength + i ] -
+                         quantized[ row - rowLength + i - 1 ];
+    return std::clamp(prediction, 0, 65535);
+}
+
+void HeightMapCodec::encode(const uint16_t *quantized, size_t count, size_t rowLength, std::vector<uint8_t> &encoded)
+{
+    encoded.clear();
+    bit_writer_t writer = { &encoded, 0, 0 };
+    static thread_local std::vector<uint32_t> residuals;
+    residuals.resize(rowLength);
+
+    for ( size_t row = 0; row < count; row += rowLength ) {
+        uint32_t sum = 0;
+        for ( size_t i = 0; i < rowLength; i++ ) {
+            residuals[ i ] = zigzag((int32_t) quantized[ row + i ] - predict(quantized, row, i, rowLength));
+            sum += residuals[ i ];
+        }
+
+        // Pick the Rice parameter with the smallest output for this row
+        int parameter = 0;
+        uint64_t smallest = UINT64_MAX;
+        for ( int k = 0; k <= HEIGHT_MAP_RICE_RAW_BITS - 1; k++ ) {
+            uint64_t size = 0;
+            for ( size_t i = 0; i < rowLength; i++ ) {
+                uint32_t quotient = residuals[ i ] >> k;
+                size += quotient >= HEIGHT_MAP_RICE_ESCAPE ? HEIGHT_MAP_RICE_ESCAPE + HEIGHT_MAP_RICE_RAW_BITS
+                                                           : quotient + 1 + k;
+            }
+            if ( size < smallest ) {
+                smallest = size;
+                parameter = k;
+            }
+            // Larger parameters only add bits once all quotients are 0
+            if (( sum >> k ) == 0 )
+                break;
+        }
+
+        writeBits(writer, parameter, HEIGHT_MAP_RICE_PARAMETER_BITS);
+        for ( size_t i = 0; i < rowLength; i++ ) {
+            uint32_t quotient = residuals[ i ] >> parameter;
+            if ( quotient >= HEIGHT_MAP_RICE_ESCAPE ) {
+                writeBits(writer, UINT32_MAX, HEIGHT_MAP_RICE_ESCAPE);
+                writeBits(writer, residuals[ i ], HEIGHT_MAP_RICE_RAW_BITS);
+                continue;
+            }
+            // The quotient in unary, ones terminated by a zero
+            writeBits(writer, (( 1u << quotient ) - 1 ) << 1, (int) quotient + 1);
+            if ( parameter > 0 )
+                writeBits(writer, residuals[ i ] & (( 1u << parameter ) - 1 ), parameter);
+        }
+    }
+    flushBits(writer);
+}
+
+bool HeightMapCodec::decode(const uint8_t *encoded, size_t encodedSize, size_t count, size_t rowLength,
+                            uint16_t *quantized)
+{
+    bit_reader_t reader = { encoded, encodedSize, 0, 0, 0 };
+
+    for ( size_t row = 0; row < count; row += rowLength ) {
+        int parameter = (int) readBits(reader, HEIGHT_MAP_RICE_PARAMETER_BITS);
+        if ( parameter >= HEIGHT_MAP_RICE_RAW_BITS )
+            return false;
+
+        for ( size_t i = 0; i < rowLength; i++ ) {
+            int quotient = readUnary(reader);
+            uint32_t residual;
+            if ( quotient == HEIGHT_MAP_RICE_ESCAPE )
+                residual = readBits(reader, HEIGHT_MAP_RICE_RAW_BITS);
+            else
+                residual = ((uint32_t) quotient << parameter ) | ( parameter > 0 ? readBits(reader, parameter) : 0 );
+
+            quantized[ row + i ] = (uint16_t) ( predict(quantized, row, i, rowLength) + unzigzag(residual));
+        }
+        // Past the end only zeros are read, which still decode, so the row is checked afterwards
+        if ( overran(reader))
+            return false;
+    }
+    return true;
+}
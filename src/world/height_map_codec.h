@@ -0,0 +1,69 @@
+//
+// Created by Luca Warmenhoven on 17/10/2026.
+//
+
+#ifndef GRAPHICS_TEST_HEIGHT_MAP_CODEC_H
+#define GRAPHICS_TEST_HEIGHT_MAP_CODEC_H
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+// The Rice parameter of a row is stored in this many bits
+#define HEIGHT_MAP_RICE_PARAMETER_BITS (5)
+// Residuals with a quotient of this size or larger are stored as raw values after the unary escape
+#define HEIGHT_MAP_RICE_ESCAPE (32)
+#define HEIGHT_MAP_RICE_RAW_BITS (17)
+
+/**
+ * Compression of height maps in two tiers.
+ *
+ * Resident height maps are quantized to 16 bits between their minimum and maximum height,
+ * which keeps random access cheap. Cold height maps additionally store the residual of every
+ * sample against a planar prediction from its left, upper and upper left neighbours, zigzag and
+ * Rice coded, with a Rice parameter per row. The prediction uses the previous row, so rows can't
+ * be decoded on their own. The cold tier is lossless with respect to the quantized samples.
+ *
+ * All methods are safe to call from any thread.
+ */
+class HeightMapCodec
+{
+public:
+
+    /**
+     * Quantizes heights to 16 bits.
+     * @param heights The heights to quantize
+     * @param count The amount of heights
+     * @param quantized The destination of the quantized heights
+     * @param minimum Set to the height that maps to 0
+     * @param scale Set to the height difference between two successive quantized values
+     */
+    static void quantize(const float *heights, size_t count, uint16_t *quantized, float &minimum, float &scale);
+
+    /**
+     * Converts quantized heights back to heights, using SSE2 or NEON when available.
+     */
+    static void dequantize(const uint16_t *quantized, size_t count, float minimum, float scale, float *heights);
+
+    static inline float dequantize(uint16_t quantized, float minimum, float scale)
+    {
+        return minimum + (float) quantized * scale;
+    }
+
+    /**
+     * Predicts and Rice codes quantized heights, row by row.
+     * @param rowLength The amount of samples in a row, count has to be a multiple of it
+     * @param encoded The vector the encoded bytes are written to, it's cleared first
+     */
+    static void encode(const uint16_t *quantized, size_t count, size_t rowLength, std::vector<uint8_t> &encoded);
+
+    /**
+     * Decodes the output of `encode` back into the quantized heights.
+     * @param encodedSize The amount of encoded bytes, nothing past them is read
+     * @return Whether the encoded bytes held all samples, false when they're truncated or corrupt
+     */
+    static bool decode(const uint8_t *encoded, size_t encodedSize, size_t count, size_t rowLength,
+                       uint16_t *quantized);
+};
+
+#endif //GRAPHICS_TEST_HEIGHT_MAP_CODEC_H
@@ -0,0 +1,454 @@
+//
+// Created by Luca Warmenhoven on 17/10/2026.
+//
+
+#include "noise_graph.h"
+#include "noise.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+// Instructions that don't correspond to a node type
+#define NOISE_OP_FILL (NOISE_NODE_CONSTANT)
+// Simplex noise added to the value of another register, fused from an addition
+#define NOISE_OP_SIMPLEX_ACCUMULATE (16)
+
+// The first two registers are the coordinates of the evaluated points
+#define NOISE_REGISTER_X (0)
+#define NOISE_REGISTER_Z (1)
+
+NoiseGraph::NoiseGraph()
+{
+    this->addNode(NOISE_NODE_X, -1, -1, -1, 0, 0, 0);
+    this->addNode(NOISE_NODE_Z, -1, -1, -1, 0, 0, 0);
+}
+
+int NoiseGraph::addNode(unsigned char type, int a, int b, int c, float p0, float p1, float p2)
+{
+    noise_node_t node = { type, { a, b, c }, { p0, p1, p2 }, -1 };
+    this->nodes.push_back(node);
+    this->compiled = false;
+    return (int) this->nodes.size() - 1;
+}
+
+bool NoiseGraph::isNode(int node) const
+{
+    return node >= 0 && node < (int) this->nodes.size();
+}
+
+int NoiseGraph::getX() const
+{
+    return 0;
+}
+
+int NoiseGraph::getZ() const
+{
+    return 1;
+}
+
+int NoiseGraph::constant(float value)
+{
+    return this->addNode(NOISE_NODE_CONSTANT, -1, -1, -1, value, 0, 0);
+}
+
+int NoiseGraph::simplex(float frequency, float amplitude, int x, int z)
+{
+    return this->addNode(NOISE_NODE_SIMPLEX, x < 0 ? this->getX() : x, z < 0 ? this->getZ() : z, -1,
+                         frequency, amplitude, 0);
+}
+
+int NoiseGraph::fbm(int octaves, float frequency, float amplitude, float lacunarity, float persistence, int x, int z)
+{
+    int sum = this->simplex(frequency, amplitude, x, z);
+    for ( int octave = 1; octave < octaves; octave++ ) {
+        frequency *= lacunarity;
+        amplitude *= persistence;
+        sum = this->add(sum, this->simplex(frequency, amplitude, x, z));
+    }
+    return sum;
+}
+
+int NoiseGraph::domainWarp(int coordinate, int offset, float strength)
+{
+    return this->add(coordinate, this->scaleBias(offset, strength, 0));
+}
+
+int NoiseGraph::add(int a, int b)
+{
+    return this->addNode(NOISE_NODE_ADD, a, b, -1, 0, 0, 0);
+}
+
+int NoiseGraph::multiply(int a, int b)
+{
+    return this->addNode(NOISE_NODE_MULTIPLY, a, b, -1, 0, 0, 0);
+}
+
+int NoiseGraph::scaleBias(int a, float scale, float bias)
+{
+    return this->addNode(NOISE_NODE_SCALE_BIAS, a, -1, -1, scale, bias, 0);
+}
+
+int NoiseGraph::blend(int a, int b, int t)
+{
+    return this->addNode(NOISE_NODE_BLEND, a, b, t, 0, 0, 0);
+}
+
+int NoiseGraph::curve(int a, const std::vector<glm::vec2> &points)
+{
+    this->curves.push_back(points);
+    int node = this->addNode(NOISE_NODE_CURVE, a, -1, -1, 0, 0, 0);
+    this->nodes[ node ].curve = (int) this->curves.size() - 1;
+    return node;
+}
+
+int NoiseGraph::clamp(int a, float minimum, float maximum)
+{
+    return this->addNode(NOISE_NODE_CLAMP, a, -1, -1, minimum, maximum, 0);
+}
+
+void NoiseGraph::setOutput(int node)
+{
+    this->output = node;
+    this->compiled = false;
+}
+
+/**
+ * The amount of inputs a node of the type takes, they're the first of its inputs.
+ */
+static int getInputCount(unsigned char type)
+{
+    switch ( type ) {
+        case NOISE_NODE_SIMPLEX:
+        case NOISE_NODE_ADD:
+        case NOISE_NODE_MULTIPLY:
+            return 2;
+        case NOISE_NODE_SCALE_BIAS:
+        case NOISE_NODE_CURVE:
+        case NOISE_NODE_CLAMP:
+            return 1;
+        case NOISE_NODE_BLEND:
+            return 3;
+        default:
+            return 0;
+    }
+}
+
+/**
+ * Maps a value through a piecewise linear curve.
+ */
+static inline float evaluateCurve(const std::vector<glm::vec2> &points, float value)
+{
+    if ( value <= points.front().x )
+        return points.front().y;
+    for ( size_t i = 1; i < points.size(); i++ ) {
+        if ( value < points[ i ].x ) {
+            float t = ( value - points[ i - 1 ].x ) / ( points[ i ].x - points[ i - 1 ].x );
+            return points[ i - 1 ].y + ( points[ i ].y - points[ i - 1 ].y ) * t;
+        }
+    }
+    return points.back().y;
+}
+
+bool NoiseGraph::compile()
+{
+    this->compiled = false;
+    this->instructions.clear();
+    if ( !this->isNode(this->output)) {
+        std::cerr << "Noise graph has no output." << std::endl;
+        return false;
+    }
+
+    int nodeCount = (int) this->nodes.size();
+    for ( int i = 0; i < nodeCount; i++ ) {
+        const noise_node_t &node = this->nodes[ i ];
+        int inputCount = getInputCount(node.type);
+        for ( int k = 0; k < 3; k++ ) {
+            // Nodes can only take earlier nodes as input, which also rules out cycles.
+            // The inputs a node doesn't use are -1.
+            int input = node.inputs[ k ];
+            if ( k < inputCount ? input < 0 || input >= i : input != -1 ) {
+                std::cerr << "Noise graph node " << i << " has an invalid input " << input << "." << std::endl;
+                return false;
+            }
+        }
+        if ( node.type == NOISE_NODE_CURVE && this->curves[ node.curve ].empty()) {
+            std::cerr << "Noise graph curve " << i << " has no control points." << std::endl;
+            return false;
+        }
+    }
+
+    // Fold constants and chains of scaling into single nodes. Nodes are only
+    // rewritten to reference earlier nodes, the nodes they no longer use are dropped below.
+    std::vector<noise_node_t> folded = this->nodes;
+    auto isConstant = [&folded](int node) {
+        return node >= 0 && folded[ node ].type == NOISE_NODE_CONSTANT;
+    };
+    for ( int i = 0; i < nodeCount; i++ ) {
+        noise_node_t &node = folded[ i ];
+        int a = node.inputs[ 0 ], b = node.inputs[ 1 ], c = node.inputs[ 2 ];
+
+        switch ( node.type ) {
+            case NOISE_NODE_ADD:
+            case NOISE_NODE_MULTIPLY: {
+                bool add = node.type == NOISE_NODE_ADD;
+                if ( isConstant(a) && isConstant(b)) {
+                    float value = add ? folded[ a ].params[ 0 ] + folded[ b ].params[ 0 ]
+                                      : folded[ a ].params[ 0 ] * folded[ b ].params[ 0 ];
+                    node = { NOISE_NODE_CONSTANT, { -1, -1, -1 }, { value, 0, 0 }, -1 };
+                } else if ( isConstant(a) || isConstant(b)) {
+                    float value = folded[ isConstant(a) ? a : b ].params[ 0 ];
+                    int other = isConstant(a) ? b : a;
+                    node = { NOISE_NODE_SCALE_BIAS, { other, -1, -1 },
+                             { add ? 1.0f : value, add ? value : 0.0f, 0 }, -1 };
+                }
+                break;
+            }
+            case NOISE_NODE_BLEND:
+                if ( isConstant(c)) {
+                    float t = std::clamp(folded[ c ].params[ 0 ], 0.0f, 1.0f);
+                    if ( t == 0.0f || t == 1.0f )
+                        node = { NOISE_NODE_SCALE_BIAS, { t == 0.0f ? a : b, -1, -1 }, { 1, 0, 0 }, -1 };
+                }
+                break;
+            case NOISE_NODE_CURVE:
+                if ( isConstant(a))
+                    node = { NOISE_NODE_CONSTANT, { -1, -1, -1 },
+                             { evaluateCurve(this->curves[ node.curve ], folded[ a ].params[ 0 ]), 0, 0 }, -1 };
+                break;
+            case NOISE_NODE_CLAMP:
+                if ( isConstant(a))
+                    node = { NOISE_NODE_CONSTANT, { -1, -1, -1 },
+                             { std::clamp(folded[ a ].params[ 0 ], node.params[ 0 ], node.params[ 1 ]), 0, 0 }, -1 };
+                break;
+        }
+
+        // Folding can produce a scale and bias, which in turn can merge with its input
+        if ( node.type == NOISE_NODE_SCALE_BIAS ) {
+            const noise_node_t &input = folded[ node.inputs[ 0 ]];
+            if ( input.type == NOISE_NODE_CONSTANT )
+                node = { NOISE_NODE_CONSTANT, { -1, -1, -1 },
+                         { input.params[ 0 ] * node.params[ 0 ] + node.params[ 1 ], 0, 0 }, -1 };
+            else if ( input.type == NOISE_NODE_SCALE_BIAS )
+                node = { NOISE_NODE_SCALE_BIAS, { input.inputs[ 0 ], -1, -1 },
+                         { input.params[ 0 ] * node.params[ 0 ], input.params[ 1 ] * node.params[ 0 ] +
+                                                                 node.params[ 1 ], 0 }, -1 };
+        }
+    }
+
+    // Only the nodes leading to the output are evaluated
+    std::vector<bool> live(nodeCount, false);
+    auto markLive = [this, &folded, &live]() {
+        std::fill(live.begin(), live.end(), false);
+        live[ this->output ] = true;
+        for ( int i = this->output; i >= 0; i-- ) {
+            if ( !live[ i ] )
+                continue;
+            for ( int input: folded[ i ].inputs )
+                if ( input >= 0 )
+                    live[ input ] = true;
+        }
+    };
+
+    // Fuse scaling and additions into the noise sources they follow, when nothing else uses the source.
+    // A fused source keeps the value it's added to in its third input. Nodes that folding left
+    // without a use don't count, a chain of scaling folds into its last node.
+    markLive();
+    std::vector<int> uses(nodeCount, 0);
+    for ( int i = 0; i < nodeCount; i++ )
+        if ( live[ i ] )
+            for ( int input: folded[ i ].inputs )
+                if ( input >= 0 )
+                    uses[ input ]++;
+    auto isFusable = [&folded, &uses](int node) {
+        return node >= 0 && folded[ node ].type == NOISE_NODE_SIMPLEX && folded[ node ].inputs[ 2 ] < 0 &&
+               uses[ node ] == 1;
+    };
+    for ( int i = 0; i < nodeCount; i++ ) {
+        noise_node_t &node = folded[ i ];
+        int a = node.inputs[ 0 ], b = node.inputs[ 1 ];
+        int sourceNode = -1, accumulated = -1;
+        if ( !live[ i ] )
+            continue;
+
+        if ( node.type == NOISE_NODE_SCALE_BIAS && isFusable(a))
+            sourceNode = a;
+        else if ( node.type == NOISE_NODE_ADD && a != b && isFusable(b)) {
+            sourceNode = b;
+            accumulated = a;
+        } else if ( node.type == NOISE_NODE_ADD && a != b && isFusable(a)) {
+            sourceNode = a;
+            accumulated = b;
+        }
+        if ( sourceNode < 0 )
+            continue;
+
+        noise_node_t source = folded[ sourceNode ];
+        if ( node.type == NOISE_NODE_SCALE_BIAS ) {
+            source.params[ 1 ] *= node.params[ 0 ];
+            source.params[ 2 ] = source.params[ 2 ] * node.params[ 0 ] + node.params[ 1 ];
+        }
+        source.inputs[ 2 ] = accumulated;
+        uses[ sourceNode ]--;
+        uses[ source.inputs[ 0 ]]++;
+        uses[ source.inputs[ 1 ]]++;
+        node = source;
+    }
+
+    // Fusing leaves the fused sources without a use
+    markLive();
+
+    // The instruction after which the value of a node is no longer needed
+    std::vector<int> lastUse(nodeCount, -1);
+    for ( int i = 0; i < nodeCount; i++ ) {
+        if ( !live[ i ] )
+            continue;
+        for ( int input: folded[ i ].inputs )
+            if ( input >= 0 )
+                lastUse[ input ] = i;
+    }
+    lastUse[ this->output ] = nodeCount;
+
+    // Assign registers, reusing the registers of values that are no longer needed.
+    // An instruction can write to the register of its own input, every point is read before it's written.
+    std::vector<int> registers(nodeCount, -1);
+    std::vector<int> freeRegisters;
+    registers[ this->getX() ] = NOISE_REGISTER_X;
+    registers[ this->getZ() ] = NOISE_REGISTER_Z;
+    this->registerCount = 2;
+
+    for ( int i = 2; i < nodeCount; i++ ) {
+        const noise_node_t &node = folded[ i ];
+        if ( !live[ i ] )
+            continue;
+
+        for ( int k = 0; k < 3; k++ ) {
+            int input = node.inputs[ k ];
+            bool duplicate = ( k > 0 && node.inputs[ 0 ] == input ) || ( k > 1 && node.inputs[ 1 ] == input );
+            if ( input > this->getZ() && lastUse[ input ] == i && !duplicate )
+                freeRegisters.push_back(registers[ input ]);
+        }
+        if ( freeRegisters.empty())
+            registers[ i ] = this->registerCount++;
+        else {
+            registers[ i ] = freeRegisters.back();
+            freeRegisters.pop_back();
+        }
+
+        noise_instruction_t instruction = { node.type, registers[ i ], { -1, -1, -1 },
+                                            { node.params[ 0 ], node.params[ 1 ], node.params[ 2 ] }, node.curve };
+        for ( int k = 0; k < 3; k++ )
+            instruction.sources[ k ] = node.inputs[ k ] >= 0 ? registers[ node.inputs[ k ]] : -1;
+        if ( node.type == NOISE_NODE_SIMPLEX && node.inputs[ 2 ] >= 0 )
+            instruction.op = NOISE_OP_SIMPLEX_ACCUMULATE;
+        this->instructions.push_back(instruction);
+    }
+
+    this->outputRegister = registers[ this->output ];
+    this->compiled = true;
+    return true;
+}
+
+void NoiseGraph::evaluateTile(const float *x, const float *z, float *out, size_t count, float *registers) const
+{
+    auto resolve = [x, z, registers](int index) {
+        if ( index == NOISE_REGISTER_X )
+            return const_cast<float *>(x);
+        if ( index == NOISE_REGISTER_Z )
+            return const_cast<float *>(z);
+        return registers + ( index - 2 ) * NOISE_GRAPH_TILE_SIZE;
+    };
+
+    for ( const noise_instruction_t &instruction: this->instructions ) {
+        float *target = resolve(instruction.target);
+        const float *a = instruction.sources[ 0 ] >= 0 ? resolve(instruction.sources[ 0 ]) : nullptr;
+        const float *b = instruction.sources[ 1 ] >= 0 ? resolve(instruction.sources[ 1 ]) : nullptr;
+        const float *c = instruction.sources[ 2 ] >= 0 ? resolve(instruction.sources[ 2 ]) : nullptr;
+        const float p0 = instruction.params[ 0 ], p1 = instruction.params[ 1 ], p2 = instruction.params[ 2 ];
+
+        switch ( instruction.op ) {
+            case NOISE_OP_FILL:
+                for ( size_t i = 0; i < count; i++ )
+                    target[ i ] = p0;
+                break;
+            case NOISE_NODE_SIMPLEX:
+                for ( size_t i = 0; i < count; i++ )
+                    target[ i ] = SimplexNoise::noise(a[ i ] * p0, b[ i ] * p0) * p1 + p2;
+                break;
+            case NOISE_OP_SIMPLEX_ACCUMULATE:
+                for ( size_t i = 0; i < count; i++ )
+                    target[ i ] = c[ i ] + ( SimplexNoise::noise(a[ i ] * p0, b[ i ] * p0) * p1 + p2 );
+                break;
+            case NOISE_NODE_ADD:
+                for ( size_t i = 0; i < count; i++ )
+                    target[ i ] = a[ i ] + b[ i ];
+                break;
+            case NOISE_NODE_MULTIPLY:
+                for ( size_t i = 0; i < count; i++ )
+                    target[ i ] = a[ i ] * b[ i ];
+                break;
+            case NOISE_NODE_SCALE_BIAS:
+                for ( size_t i = 0; i < count; i++ )
+                    target[ i ] = a[ i ] * p0 + p1;
+                break;
+            case NOISE_NODE_BLEND:
+                for ( size_t i = 0; i < count; i++ ) {
+                    float t = std::clamp(c[ i ], 0.0f, 1.0f);
+                    target[ i ] = a[ i ] + ( b[ i ] - a[ i ] ) * t;
+                }
+                break;
+            case NOISE_NODE_CURVE: {
+                const std::vector<glm::vec2> &points = this->curves[ instruction.curve ];
+                for ( size_t i = 0; i < count; i++ )
+                    target[ i ] = evaluateCurve(points, a[ i ]);
+                break;
+            }
+            case NOISE_NODE_CLAMP:
+                for ( size_t i = 0; i < count; i++ )
+                    target[ i ] = std::clamp(a[ i ], p0, p1);
+                break;
+        }
+    }
+
+    memcpy(out, resolve(this->outputRegister), count * sizeof(float));
+}
+
+void NoiseGraph::evaluate(const float *x, const float *z, float *out, size_t count) const
+{
+    if ( !this->compiled ) {
+        std::fill(out, out + count, 0.0f);
+        return;
+    }
+
+    static thread_local std::vector<float> registers;
+    registers.resize((size_t) std::max(this->registerCount - 2, 0) * NOISE_GRAPH_TILE_SIZE);
+    for ( size_t offset = 0; offset < count; offset += NOISE_GRAPH_TILE_SIZE ) {
+        size_t tileSize = std::min(count - offset, (size_t) NOISE_GRAPH_TILE_SIZE);
+        this->evaluateTile(x + offset, z + offset, out + offset, tileSize, registers.data());
+    }
+}
+
+float NoiseGraph::evaluate(float x, float z) const
+{
+    float out;
+    this->evaluate(&x, &z, &out, 1);
+    return out;
+}
+
+bool NoiseGraph::operator==(const NoiseGraph &other) const
+{
+    if ( this->output != other.output || this->nodes.size() != other.nodes.size() || this->curves != other.curves )
+        return false;
+    for ( size_t i = 0; i < this->nodes.size(); i++ ) {
+        const noise_node_t &node = this->nodes[ i ], &otherNode = other.nodes[ i ];
+        if ( node.type != otherNode.type || node.curve != otherNode.curve ||
+             memcmp(node.inputs, otherNode.inputs, sizeof(node.inputs)) != 0 ||
+             memcmp(node.params, otherNode.params, sizeof(node.params)) != 0 )
+            return false;
+    }
+    return true;
+}
+
+size_t NoiseGraph::getInstructionCount() const
+{
+    return this->instructions.size();
+}
@@ -0,0 +1,164 @@
+//
+// Created by Luca Warmenhoven on 17/10/2026.
+//
+
+#ifndef GRAPHICS_TEST_NOISE_GRAPH_H
+#define GRAPHICS_TEST_NOISE_GRAPH_H
+
+#include <cstddef>
+#include <vector>
+#include <glm/glm.hpp>
+
+// The amount of points every instruction of a compiled graph processes at once
+#define NOISE_GRAPH_TILE_SIZE (64)
+
+#define NOISE_NODE_X (0)
+#define NOISE_NODE_Z (1)
+#define NOISE_NODE_CONSTANT (2)
+#define NOISE_NODE_SIMPLEX (3)
+#define NOISE_NODE_ADD (4)
+#define NOISE_NODE_MULTIPLY (5)
+#define NOISE_NODE_SCALE_BIAS (6)
+#define NOISE_NODE_BLEND (7)
+#define NOISE_NODE_CURVE (8)
+#define NOISE_NODE_CLAMP (9)
+
+typedef struct {
+    unsigned char type;
+    int inputs[3];    // Indices of earlier nodes, -1 when unused
+    float params[3];  // SIMPLEX: frequency, amplitude, bias. SCALE_BIAS: scale, bias. CLAMP: minimum, maximum
+    int curve;        // CURVE: index into the curves of the graph
+} noise_node_t;
+
+/**
+ * One step of a compiled graph, applied to a whole tile of points.
+ * Registers are tiles of NOISE_GRAPH_TILE_SIZE values.
+ */
+typedef struct {
+    unsigned char op;
+    int target;
+    int sources[3];
+    float params[3];
+    int curve;
+} noise_instruction_t;
+
+/**
+ * A terrain function composed of noise nodes.
+ *
+ * The graph is built by adding nodes, each of which returns its identifier that later
+ * nodes take as input. The sampled coordinates are the nodes `getX()` and `getZ()`,
+ * so sources can be sampled at transformed (for example warped) coordinates.
+ *
+ * Before it's evaluated, the graph is compiled into a flat list of instructions:
+ * unused nodes are dropped, constant subgraphs are folded, and scale/bias, accumulation
+ * and multiplication by constants are fused into the noise sources they follow.
+ * Evaluation then runs every instruction over a tile of points at a time, so the
+ * dispatch happens once per tile, and the arithmetic loops can be vectorized.
+ *
+ * Building and compiling a graph isn't thread safe, evaluating a compiled graph is.
+ */
+class NoiseGraph
+{
+
+private:
+
+    std::vector<noise_node_t> nodes;
+    std::vector<std::vector<glm::vec2>> curves;
+    int output = -1;
+
+    std::vector<noise_instruction_t> instructions;
+    int registerCount = 0;
+    int outputRegister = -1;
+    bool compiled = false;
+
+    int addNode(unsigned char type, int a, int b, int c, float p0, float p1, float p2);
+
+    bool isNode(int node) const;
+
+    void evaluateTile(const float *x, const float *z, float *out, size_t count, float *registers) const;
+
+public:
+
+    NoiseGraph();
+
+    int getX() const;
+
+    int getZ() const;
+
+    int constant(float value);
+
+    /**
+     * Simplex noise, `noise(x * frequency, z * frequency) * amplitude`.
+     * @param x The node to take the x coordinate from, `getX()` when -1
+     * @param z The node to take the z coordinate from, `getZ()` when -1
+     */
+    int simplex(float frequency, float amplitude = 1.0f, int x = -1, int z = -1);
+
+    /**
+     * Fractal Brownian motion, the sum of `octaves` simplex noises, every octave with `lacunarity`
+     * times the frequency and `persistence` times the amplitude of the previous one.
+     */
+    int fbm(int octaves, float frequency, float amplitude, float lacunarity = 2.0f, float persistence = 0.5f,
+            int x = -1, int z = -1);
+
+    /**
+     * Moves a coordinate by `offset * strength`.
+     * Pass the warped coordinates to a source to distort its features.
+     */
+    int domainWarp(int coordinate, int offset, float strength);
+
+    int add(int a, int b);
+
+    int multiply(int a, int b);
+
+    /**
+     * `a * scale + bias`
+     */
+    int scaleBias(int a, float scale, float bias);
+
+    /**
+     * Linearly blends from `a` to `b` with `t`, clamped between 0 and 1.
+     */
+    int blend(int a, int b, int t);
+
+    /**
+     * Maps the value of `a` through a piecewise linear curve.
+     * Values outside the control points take the value of the nearest end.
+     * @param points The control points as (input, output), at least one, sorted by input
+     */
+    int curve(int a, const std::vector<glm::vec2> &points);
+
+    int clamp(int a, float minimum, float maximum);
+
+    /**
+     * Sets the node the graph outputs, this invalidates the compiled graph.
+     */
+    void setOutput(int node);
+
+    /**
+     * Compiles the nodes leading to the output into instructions.
+     * Has to be called after changing the graph, before it's evaluated.
+     * @return Whether the graph is valid
+     */
+    bool compile();
+
+    /**
+     * Evaluates the graph at `count` points, a tile at a time.
+     * An uncompiled graph evaluates to 0 everywhere.
+     */
+    void evaluate(const float *x, const float *z, float *out, size_t count) const;
+
+    float evaluate(float x, float z) const;
+
+    /**
+     * The amount of instructions of the compiled graph.
+     */
+    size_t getInstructionCount() const;
+
+    /**
+     * Whether both graphs have the same nodes and output, so they describe the same function.
+     */
+    bool operator==(const NoiseGraph &other) const;
+};
+
+#endif //GRAPHICS_TEST_NOISE_GRAPH_H
@@ -0,0 +1,373 @@
+//
+// Created by Luca Warmenhoven on 17/10/2026.
+//
+
+#include "terrain_generator.h"
+#include "world.h"
+#include "noise.h"
+#include "noise_graph.h"
+#include <array>
+#include <iostream>
+#include <utility>
+#include <vector>
+
+static uint32_t terrainSeed = 0;
+
+// Where the seed moves the sampled area of the noise to, in the units of the noise coordinates
+static glm::vec2 seedOffset = glm::vec2(0.0f);
+
+void TerrainGenerator::setSeed(uint32_t seed)
+{
+    terrainSeed = seed;
+    if ( seed == 0 ) {
+        seedOffset = glm::vec2(0.0f);
+        return;
+    }
+
+    // Hashed (SplitMix64) so neighbouring seeds end up far apart. The offsets are kept
+    // within TERRAIN_SEED_MAX_OFFSET, beyond which the noise loses float precision.
+    uint64_t hash = (uint64_t) seed + 0x9E3779B97F4A7C15ULL;
+    hash = ( hash ^ ( hash >> 30 )) * 0xBF58476D1CE4E5B9ULL;
+    hash = ( hash ^ ( hash >> 27 )) * 0x94D049BB133111EBULL;
+    hash ^= hash >> 31;
+    seedOffset = glm::vec2((float) ( hash & 0xFFFF ), (float) (( hash >> 16 ) & 0xFFFF )) / 65535.0f *
+                 TERRAIN_SEED_MAX_OFFSET;
+}
+
+uint32_t TerrainGenerator::getSeed()
+{
+    return terrainSeed;
+}
+
+/**
+ * The biome noise and the weight of every biome at a corner of a biome cell.
+ * The weights add up to 1.
+ */
+typedef struct {
+    float noise;
+    float weights[CHUNK_BIOME_COUNT];
+} biome_sample_t;
+
+/**
+ * The last biome cell sampled by `getHeight` on this thread.
+ */
+typedef struct {
+    bool valid;
+    int32_t x, z;
+    uint32_t seed;
+    biome_sample_t corners[4]; // (x, z), (x + 1, z), (x, z + 1), (x + 1, z + 1)
+} biome_cell_t;
+
+static thread_local biome_cell_t biomeCell = {};
+
+/**
+ * Get the biome noise height for a specific coordinate, in noise coordinates.
+ * This is used to select the biome, and to scale its height.
+ */
+static float getBiomeNoise(float x, float z)
+{
+    return ( SimplexNoise::noise((float) x / 100.0f, (float) z / 100.0f) + 1 ) / 2;
+}
+
+/**
+ * Calculates the biome weights at the corner of a biome cell.
+ * Every biome covers an equal part of the biome noise range, and near the
+ * boundary between two biomes the weight moves from one to the other.
+ */
+static biome_sample_t getBiomeCorner(int32_t cellX, int32_t cellZ)
+{
+    biome_sample_t sample;
+    sample.noise = getBiomeNoise((float) cellX * TERRAIN_BIOME_CELL_SIZE / 10.0f + seedOffset.x,
+                                 (float) cellZ * TERRAIN_BIOME_CELL_SIZE / 10.0f + seedOffset.y);
+    float position = glm::clamp(sample.noise, 0.0f, 1.0f) * CHUNK_BIOME_COUNT;
+    float halfWidth = TERRAIN_BIOME_BLEND_WIDTH / 2.0f;
+
+    for ( int biome = 0; biome < CHUNK_BIOME_COUNT; biome++ ) {
+        // The part of the transition into this biome and into the next one that has been crossed
+        float entered = biome == 0 ? 1.0f : glm::smoothstep(biome - halfWidth, biome + halfWidth, position);
+        float left = biome == CHUNK_BIOME_COUNT - 1 ? 0.0f
+                                                    : glm::smoothstep(biome + 1 - halfWidth, biome + 1 + halfWidth,
+                                                                      position);
+        sample.weights[ biome ] = entered - left;
+    }
+    return sample;
+}
+
+/**
+ * Bilinearly interpolates the four corners of a biome cell.
+ * @param corners The corners (x, z), (x + 1, z), (x, z + 1), (x + 1, z + 1)
+ * @param tx The position within the cell along the x-axis, between 0 and 1
+ * @param tz The position within the cell along the z-axis, between 0 and 1
+ */
+static biome_sample_t interpolateBiomes(const biome_sample_t *const corners[4], float tx, float tz)
+{
+    float factors[4] = {( 1 - tx ) * ( 1 - tz ), tx * ( 1 - tz ), ( 1 - tx ) * tz, tx * tz };
+    biome_sample_t sample = { 0.0f, { 0.0f }};
+    for ( int corner = 0; corner < 4; corner++ ) {
+        sample.noise += corners[ corner ]->noise * factors[ corner ];
+        for ( int biome = 0; biome < CHUNK_BIOME_COUNT; biome++ )
+            sample.weights[ biome ] += corners[ corner ]->weights[ biome ] * factors[ corner ];
+    }
+    return sample;
+}
+
+NoiseGraph TerrainGenerator::getDefaultBiomeGraph(int biome)
+{
+    const terrain_biome_t &parameters = BIOMES[ biome ];
+    NoiseGraph graph;
+    int height = graph.simplex(1.0f / parameters.octaves[ 0 ][ 0 ], parameters.octaves[ 0 ][ 1 ]);
+    for ( int octave = 1; octave < parameters.octave_count; octave++ )
+        height = graph.add(height, graph.simplex(1.0f / parameters.octaves[ octave ][ 0 ],
+                                                 parameters.octaves[ octave ][ 1 ]));
+    graph.setOutput(graph.scaleBias(height, parameters.height_scale, 0.0f));
+    return graph;
+}
+
+/**
+ * The compiled terrain functions of the biomes, built from TerrainGenerator::BIOMES until they're replaced.
+ */
+static NoiseGraph *getBiomeGraphs()
+{
+    static NoiseGraph graphs[CHUNK_BIOME_COUNT];
+    static bool built = [] {
+        for ( int biome = 0; biome < CHUNK_BIOME_COUNT; biome++ ) {
+            graphs[ biome ] = TerrainGenerator::getDefaultBiomeGraph(biome);
+            graphs[ biome ].compile();
+        }
+        return true;
+    }();
+    (void) built;
+    return graphs;
+}
+
+// Whether the graph of a biome differs from its default one, which `getBiomeHeights` below evaluates
+// with unrolled octaves
+static bool hasCustomGraph[CHUNK_BIOME_COUNT] = { false };
+static bool biomeSpecialization = true;
+
+bool TerrainGenerator::setBiomeGraph(int biome, const NoiseGraph &graph)
+{
+    if ( biome < 0 || biome >= CHUNK_BIOME_COUNT ) {
+        std::cerr << "There's no biome " << biome << " to set the terrain function of." << std::endl;
+        return false;
+    }
+    NoiseGraph compiled = graph;
+    if ( !compiled.compile())
+        return false;
+    getBiomeGraphs()[ biome ] = compiled;
+    hasCustomGraph[ biome ] = !( graph == getDefaultBiomeGraph(biome));
+    return true;
+}
+
+void TerrainGenerator::setBiomeSpecialization(bool enabled)
+{
+    biomeSpecialization = enabled;
+}
+
+/**
+ * The default terrain function of a biome, the specialization of its default graph
+ * with the octaves of its entry in TerrainGenerator::BIOMES unrolled at compile time.
+ */
+template<int Biome, int... Octaves>
+static void getBiomeHeights(const float *x, const float *z, float *out, size_t count,
+                            std::integer_sequence<int, Octaves...>)
+{
+    constexpr terrain_biome_t biome = TerrainGenerator::BIOMES[ Biome ];
+    for ( size_t i = 0; i < count; i++ ) {
+        float height = ( 0.0f + ... + ( SimplexNoise::noise(x[ i ] * ( 1.0f / biome.octaves[ Octaves ][ 0 ] ),
+                                                            z[ i ] * ( 1.0f / biome.octaves[ Octaves ][ 0 ] )) *
+                                        biome.octaves[ Octaves ][ 1 ] ));
+        out[ i ] = height * biome.height_scale;
+    }
+}
+
+template<int Biome>
+static void getBiomeHeights(const float *x, const float *z, float *out, size_t count)
+{
+    getBiomeHeights<Biome>(x, z, out, count,
+                           std::make_integer_sequence<int, TerrainGenerator::BIOMES[ Biome ].octave_count>());
+}
+
+typedef void (*biome_function_t)(const float *x, const float *z, float *out, size_t count);
+
+template<int... Biomes>
+static constexpr std::array<biome_function_t, CHUNK_BIOME_COUNT> getBiomeFunctions(std::integer_sequence<int, Biomes...>)
+{
+    return { &getBiomeHeights<Biomes>... };
+}
+
+static constexpr std::array<biome_function_t, CHUNK_BIOME_COUNT> BIOME_FUNCTIONS =
+        getBiomeFunctions(std::make_integer_sequence<int, CHUNK_BIOME_COUNT>());
+
+/**
+ * Get the heights of the terrain at up to `MaxCount` world space coordinates, given the biomes at them.
+ * The terrain function of a biome is only evaluated at the coordinates where it has a weight.
+ */
+template<int MaxCount>
+static void getBlendedHeights(const float *x, const float *z, const biome_sample_t *biomes, float *heights,
+                              size_t count)
+{
+    float noiseX[MaxCount], noiseZ[MaxCount], values[MaxCount];
+    size_t indices[MaxCount];
+
+    for ( size_t i = 0; i < count; i++ )
+        heights[ i ] = 0.0f;
+
+    for ( int biome = 0; biome < CHUNK_BIOME_COUNT; biome++ ) {
+        // Pack the coordinates where the biome is present, so it's evaluated for those only
+        size_t packed = 0;
+        for ( size_t i = 0; i < count; i++ ) {
+            if ( biomes[ i ].weights[ biome ] <= 0.0f )
+                continue;
+            noiseX[ packed ] = x[ i ] / 10.0f + seedOffset.x;
+            noiseZ[ packed ] = z[ i ] / 10.0f + seedOffset.y;
+            indices[ packed++ ] = i;
+        }
+        if ( packed == 0 )
+            continue;
+
+        if ( biomeSpecialization && !hasCustomGraph[ biome ] )
+            BIOME_FUNCTIONS[ biome ](noiseX, noiseZ, values, packed);
+        else
+            getBiomeGraphs()[ biome ].evaluate(noiseX, noiseZ, values, packed);
+        for ( size_t k = 0; k < packed; k++ )
+            heights[ indices[ k ]] += biomes[ indices[ k ]].weights[ biome ] * values[ k ];
+    }
+
+    for ( size_t i = 0; i < count; i++ )
+        heights[ i ] = biomes[ i ].noise * heights[ i ] * CHUNK_GENERATION_MAX_HEIGHT;
+}
+
+float TerrainGenerator::getHeight(float x, float z)
+{
+    float cellX = x / TERRAIN_BIOME_CELL_SIZE;
+    float cellZ = z / TERRAIN_BIOME_CELL_SIZE;
+    auto cornerX = (int32_t) std::floor(cellX);
+    auto cornerZ = (int32_t) std::floor(cellZ);
+
+    if ( !biomeCell.valid || biomeCell.x != cornerX || biomeCell.z != cornerZ || biomeCell.seed != terrainSeed ) {
+        for ( int corner = 0; corner < 4; corner++ )
+            biomeCell.corners[ corner ] = getBiomeCorner(cornerX + ( corner & 1 ), cornerZ + ( corner >> 1 ));
+        biomeCell.valid = true;
+        biomeCell.x = cornerX;
+        biomeCell.z = cornerZ;
+        biomeCell.seed = terrainSeed;
+    }
+
+    const biome_sample_t *corners[4] = { &biomeCell.corners[ 0 ], &biomeCell.corners[ 1 ],
+                                         &biomeCell.corners[ 2 ], &biomeCell.corners[ 3 ] };
+    biome_sample_t biomes = interpolateBiomes(corners, cellX - (float) cornerX, cellZ - (float) cornerZ);
+    float height;
+    getBlendedHeights<1>(&x, &z, &biomes, &height, 1);
+    return height;
+}
+
+/**
+ * Get the heights of a grid of height map cells, the rows along the x-axis being `depth` samples long.
+ * The rows are blended in segments of up to `Segment` samples.
+ *
+ * @param corners Space for the biome corners covering the grid, see `getCornerCount`
+ */
+template<int Segment>
+static void getGridHeights(int32_t x, int32_t z, int32_t width, int32_t depth, float *heights,
+                           biome_sample_t *corners)
+{
+    auto cornerOf = [](int32_t cell) {
+        return (int32_t) std::floor(((float) cell - 0.5f ) * CHUNK_COORDINATE_SCALING_FACTOR / TERRAIN_BIOME_CELL_SIZE);
+    };
+    // The biome corners covering the grid, calculated once instead of once per cell the samples enter
+    int32_t firstX = cornerOf(x), firstZ = cornerOf(z);
+    int32_t cornersX = cornerOf(x + width - 1) - firstX + 2;
+    int32_t cornersZ = cornerOf(z + depth - 1) - firstZ + 2;
+    for ( int32_t i = 0; i < cornersX; i++ )
+        for ( int32_t j = 0; j < cornersZ; j++ )
+            corners[ i * cornersZ + j ] = getBiomeCorner(firstX + i, firstZ + j);
+
+    float worldX[Segment], worldZ[Segment];
+    biome_sample_t biomes[Segment];
+    for ( int32_t i = 0; i < width; i++ ) {
+        for ( int32_t start = 0; start < depth; start += Segment ) {
+            int32_t length = std::min(depth - start, (int32_t) Segment);
+            for ( int32_t k = 0; k < length; k++ ) {
+                int32_t j = start + k;
+                worldX[ k ] = ((float) ( x + i ) - 0.5f ) * CHUNK_COORDINATE_SCALING_FACTOR;
+                worldZ[ k ] = ((float) ( z + j ) - 0.5f ) * CHUNK_COORDINATE_SCALING_FACTOR;
+                float cellX = worldX[ k ] / TERRAIN_BIOME_CELL_SIZE;
+                float cellZ = worldZ[ k ] / TERRAIN_BIOME_CELL_SIZE;
+                int32_t cornerX = (int32_t) std::floor(cellX) - firstX;
+                int32_t cornerZ = (int32_t) std::floor(cellZ) - firstZ;
+
+                const biome_sample_t *base = &corners[ cornerX * cornersZ + cornerZ ];
+                const biome_sample_t *cell[4] = { base, base + cornersZ, base + 1, base + cornersZ + 1 };
+                biomes[ k ] = interpolateBiomes(cell, cellX - (float) ( cornerX + firstX ),
+                                                cellZ - (float) ( cornerZ + firstZ ));
+            }
+            getBlendedHeights<Segment>(worldX, worldZ, biomes, &heights[ i * depth + start ], (size_t) length);
+        }
+    }
+}
+
+/**
+ * The amount of biome corners `getGridHeights` needs for a grid of at most `width` by `depth` cells.
+ */
+static constexpr int32_t getCornerCount(int32_t width, int32_t depth)
+{
+    // The biome cells a row of cells can touch, rounded up, plus the far corners
+    auto cornersAlong = [](int32_t cells) {
+        float biomeCells = (float) cells * CHUNK_COORDINATE_SCALING_FACTOR / TERRAIN_BIOME_CELL_SIZE;
+        auto count = (int32_t) biomeCells;
+        return ( (float) count < biomeCells ? count + 1 : count ) + 2;
+    };
+    return cornersAlong(width) * cornersAlong(depth);
+}
+
+template<int Size>
+void ChunkGenerator<Size>::getHeights(int32_t x, int32_t z, float *heights)
+{
+    biome_sample_t corners[getCornerCount(Size, Size)];
+    getGridHeights<Size>(x, z, Size, Size, heights, corners);
+}
+
+template class ChunkGenerator<32>;
+template class ChunkGenerator<64>;
+template class ChunkGenerator<128>;
+
+void TerrainGenerator::getChunkHeights(int32_t x, int32_t z, float *heights)
+{
+    ChunkGenerator<CHUNK_SIZE>::getHeights(x, z, heights);
+}
+
+void TerrainGenerator::getHeights(int32_t x, int32_t z, int32_t width, int32_t depth, float *heights)
+{
+    static thread_local std::vector<biome_sample_t> corners;
+    corners.resize(getCornerCount(width, depth));
+    getGridHeights<TERRAIN_GENERATOR_ROW_SEGMENT>(x, z, width, depth, heights, corners.data());
+}
+
+bool TerrainGenerator::getChunkHeights(int size, int32_t x, int32_t z, float *heights)
+{
+    switch ( size ) {
+        case 32:
+            ChunkGenerator<32>::getHeights(x, z, heights);
+            return true;
+        case 64:
+            ChunkGenerator<64>::getHeights(x, z, heights);
+            return true;
+        case 128:
+            ChunkGenerator<128>::getHeights(x, z, heights);
+            return true;
+        default:
+            return false;
+    }
+}
+
+glm::vec3 TerrainGenerator::getNormal(float x, float z)
+{
+    // Calculate the normal vectors
+    float height1 = getHeight(x - CHUNK_GENERATION_NORMAL_DELTA, z);
+    float height2 = getHeight(x + CHUNK_GENERATION_NORMAL_DELTA, z);
+    float height3 = getHeight(x, z - CHUNK_GENERATION_NORMAL_DELTA);
+    float height4 = getHeight(x, z + CHUNK_GENERATION_NORMAL_DELTA);
+
+    return glm::normalize(glm::vec3(height1 - height2, 2.0f * CHUNK_GENERATION_NORMAL_DELTA, height3 - height4));
+}
@@ -0,0 +1,168 @@
+//
+// Created by Luca Warmenhoven on 17/10/2026.
+//
+
+#ifndef GRAPHICS_TEST_TERRAIN_GENERATOR_H
+#define GRAPHICS_TEST_TERRAIN_GENERATOR_H
+
+#include <cstdint>
+#include <glm/glm.hpp>
+#include "world.h"
+#include "noise_graph.h"
+
+// The largest distance the seed moves the sampled area of the noise
+#define TERRAIN_SEED_MAX_OFFSET (100000.0f)
+
+#define TERRAIN_BIOME_MAX_OCTAVES (4)
+// The size of the cells the biome weights are calculated for, in world space units.
+// Within a cell the weights of its four corners are interpolated.
+#define TERRAIN_BIOME_CELL_SIZE (160.0f)
+// The width of the transition between two biomes, as a fraction of the biome noise range of one biome
+#define TERRAIN_BIOME_BLEND_WIDTH (0.25f)
+
+// The longest part of a row of a grid that's blended at once by TerrainGenerator::getHeights
+#define TERRAIN_GENERATOR_ROW_SEGMENT (128)
+
+// The chunk sizes ChunkGenerator is instantiated for
+#define CHUNK_GENERATOR_SIZES { 32, 64, 128 }
+
+/**
+ * The shape of the terrain in a biome.
+ * Each octave is a set of two numbers, the first one indicating the coordinate dividing
+ * factor, the second one the height factor.
+ */
+typedef struct {
+    float height_scale;
+    int octave_count;
+    float octaves[TERRAIN_BIOME_MAX_OCTAVES][2];
+} terrain_biome_t;
+
+/**
+ * The height function of the world.
+ * Everything that needs terrain heights (chunk generation, the clipmap renderer)
+ * samples it through here, so they always agree with each other.
+ * All methods are safe to call from any thread, except `setSeed` and `setBiomeGraph`:
+ * those change the terrain function, so they have to be called before any heights are
+ * sampled, while no other thread uses the generator.
+ */
+class TerrainGenerator
+{
+public:
+
+    /**
+     * The biomes, ordered by the biome noise value they appear at.
+     * Where the biome noise crosses from one biome into the next, the heights of both
+     * are blended over TERRAIN_BIOME_BLEND_WIDTH.
+     * The terrain function of every biome is a NoiseGraph built from its entry, see `getDefaultBiomeGraph`.
+     * While a biome has its default graph, it's evaluated by a specialization of that graph
+     * with the octaves unrolled at compile time instead.
+     */
+    static constexpr terrain_biome_t BIOMES[CHUNK_BIOME_COUNT] = {
+            { 0.5f, 2, {{ 500, 30 }, { 100, 0.5f }}},
+            { 0.7f, 2, {{ 500, 30 }, { 100, 1 }}},
+            { 1.0f, 2, {{ 500, 30 }, { 100, 1 }}},
+            { 1.2f, 3, {{ 500, 30 }, { 100, 1.5f }, { 25, 0.1f }}},
+            { 1.3f, 3, {{ 500, 30 }, { 150, 2 }, { 40, 0.2f }}}
+    };
+
+    /**
+     * Changes the seed of the terrain, 0 being the default terrain.
+     * This has to be set before any heights are sampled, usually by World::openStorage.
+     */
+    static void setSeed(uint32_t seed);
+
+    static uint32_t getSeed();
+
+    /**
+     * Replaces the default terrain function of a biome. The graph is sampled in noise coordinates
+     * (world space / 10, moved by the seed) and outputs the height of the biome before
+     * it's scaled by the biome noise and CHUNK_GENERATION_MAX_HEIGHT.
+     * Like the seed, this has to be set before any heights are sampled.
+     * @param biome The index of the biome in BIOMES
+     * @return Whether the biome exists and the graph compiled, the biome keeps its previous graph otherwise
+     */
+    static bool setBiomeGraph(int biome, const NoiseGraph &graph);
+
+    /**
+     * Get the graph of the terrain function a biome has by default, the sum of the octaves of its entry
+     * in BIOMES. Setting a graph equal to it brings back the specialized evaluation.
+     */
+    static NoiseGraph getDefaultBiomeGraph(int biome);
+
+    /**
+     * Whether biomes with their default graph are evaluated by the specialization with the unrolled octaves,
+     * enabled by default. Disabled, every biome is evaluated through its graph, which samples the same
+     * function. Like the seed, this has to be set before any heights are sampled.
+     */
+    static void setBiomeSpecialization(bool enabled);
+
+    /**
+     * Get the height of the terrain at a world space coordinate.
+     * The biome weights of the last biome cell are cached per thread, so sampling
+     * neighbouring coordinates one after the other is cheaper than sampling scattered ones.
+     */
+    static float getHeight(float x, float z);
+
+    /**
+     * Get the heights of a grid of height map cells, sampled like the height maps of chunks.
+     * Neighbouring chunks can be generated as one grid, which shares the biome
+     * calculations between them and blends long rows at once.
+     *
+     * @param x The x coordinate of the first cell, in height map cells
+     * @param z The z coordinate of the first cell, in height map cells
+     * @param width The amount of cells along the x-axis
+     * @param depth The amount of cells along the z-axis
+     * @param heights The width * depth heights, sample (i, j) is at [i * depth + j]
+     */
+    static void getHeights(int32_t x, int32_t z, int32_t width, int32_t depth, float *heights);
+
+    /**
+     * Get the CHUNK_SIZE^2 heights of the height map of a chunk, the samples World::generateChunk
+     * stores in the chunk. Sample (i, j) is at [i * CHUNK_SIZE + j].
+     *
+     * @param x The x coordinate of the chunk, in height map cells
+     * @param z The z coordinate of the chunk, in height map cells
+     */
+    static void getChunkHeights(int32_t x, int32_t z, float *heights);
+
+    /**
+     * Get the heights of a chunk of a size other than CHUNK_SIZE, laid out like `getChunkHeights`.
+     * Dispatches to the ChunkGenerator instantiated for that size.
+     *
+     * @param size One of the sizes in CHUNK_GENERATOR_SIZES
+     * @return Whether the generator was instantiated for the size
+     */
+    static bool getChunkHeights(int size, int32_t x, int32_t z, float *heights);
+
+    /**
+     * Get the normal vector at a world space coordinate.
+     * This calculates the normal vector based on the adjacent
+     * height points, which are calculated by the `getHeight` function.
+     */
+    static glm::vec3 getNormal(float x, float z);
+};
+
+/**
+ * Generates the height maps of chunks of `Size` by `Size` samples, with the
+ * stack buffers and loops sized at compile time.
+ * Instantiated for the sizes in CHUNK_GENERATOR_SIZES, use TerrainGenerator::getChunkHeights
+ * to pick one at runtime.
+ */
+template<int Size>
+class ChunkGenerator
+{
+public:
+
+    /**
+     * @param x The x coordinate of the chunk, in height map cells
+     * @param z The z coordinate of the chunk, in height map cells
+     * @param heights The Size^2 heights, sample (i, j) is at [i * Size + j]
+     */
+    static void getHeights(int32_t x, int32_t z, float *heights);
+};
+
+extern template class ChunkGenerator<32>;
+extern template class ChunkGenerator<64>;
+extern template class ChunkGenerator<128>;
+
+#endif //GRAPHICS_TEST_TERRAIN_GENERATOR_H
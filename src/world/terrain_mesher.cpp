@@ -0,0 +1,170 @@
+//
+// Created by Luca Warmenhoven on 17/10/2026.
+//
+
+#include "terrain_mesher.h"
+
+#include <cmath>
+#include <algorithm>
+
+/**
+ * State that is shared while extracting the adaptive mesh.
+ */
+typedef struct {
+    const float *errors;
+    int gridSize;
+    float maxError;
+    std::vector<int32_t> *vertexMap; // Grid index -> vertex index, or -1 if unused
+    std::vector<uint32_t> *vertices;
+    std::vector<unsigned int> *indices;
+} rtin_context_t;
+
+static unsigned int emitVertex(rtin_context_t &context, int i, int j)
+{
+    uint32_t gridIndex = i * context.gridSize + j;
+    int32_t &vertexIndex = ( *context.vertexMap )[ gridIndex ];
+    if ( vertexIndex < 0 ) {
+        vertexIndex = (int32_t) context.vertices->size();
+        context.vertices->push_back(gridIndex);
+    }
+    return vertexIndex;
+}
+
+static void emitTriangle(rtin_context_t &context, int ai, int aj, int bi, int bj, int ci, int cj)
+{
+    // Keep the same winding as the regular mesh, so the triangles face upwards
+    if (( bi - ai ) * ( cj - aj ) - ( bj - aj ) * ( ci - ai ) > 0 ) {
+        std::swap(bi, ci);
+        std::swap(bj, cj);
+    }
+    context.indices->push_back(emitVertex(context, ai, aj));
+    context.indices->push_back(emitVertex(context, bi, bj));
+    context.indices->push_back(emitVertex(context, ci, cj));
+}
+
+/**
+ * Recursively splits the triangle (a, b, c), with a-b being its hypotenuse,
+ * for as long as the error at the midpoint of the hypotenuse is too large.
+ */
+static void processTriangle(rtin_context_t &context, int ai, int aj, int bi, int bj, int ci, int cj)
+{
+    int mi = ( ai + bi ) >> 1;
+    int mj = ( aj + bj ) >> 1;
+
+    if ( std::abs(ai - ci) + std::abs(aj - cj) > 1 &&
+         context.errors[ mi * context.gridSize + mj ] > context.maxError ) {
+        processTriangle(context, ci, cj, ai, aj, mi, mj);
+        processTriangle(context, bi, bj, ci, cj, mi, mj);
+    } else {
+        emitTriangle(context, ai, aj, bi, bj, ci, cj);
+    }
+}
+
+void TerrainMesher::meshRegular(int gridSize, std::vector<uint32_t> &vertices, std::vector<unsigned int> &indices)
+{
+    int i, j;
+    int top_left, bottom_left, top_right, bottom_right;
+
+    for ( i = 0; i < gridSize * gridSize; i++ )
+        vertices.push_back(i);
+
+    for ( i = 0; i < gridSize - 1; i++ ) {
+        for ( j = 0; j < gridSize - 1; j++ ) {
+            top_left = i * gridSize + j;
+            bottom_left = ( i + 1 ) * gridSize + j;
+            top_right = i * gridSize + ( j + 1 );
+            bottom_right = ( i + 1 ) * gridSize + ( j + 1 );
+
+            indices.push_back(top_left);
+            indices.push_back(top_right);
+            indices.push_back(bottom_left);
+
+            indices.push_back(top_right);
+            indices.push_back(bottom_right);
+            indices.push_back(bottom_left);
+        }
+    }
+}
+
+/*
+ * Based on the RTIN approach of "Right-Triangulated Irregular Networks" (Evans et al.),
+ * with the error propagation scheme used by Mapbox' Martini.
+ */
+void TerrainMesher::meshAdaptive(const float *heights, int gridSize, float maxError,
+                                 std::vector<uint32_t> &vertices, std::vector<unsigned int> &indices)
+{
+    const int tileSize = gridSize - 1;
+    const int triangleCount = tileSize * tileSize * 2 - 2;
+    const int parentTriangleCount = triangleCount - tileSize * tileSize;
+
+    // Scratch buffers, reused between the calls on the same thread
+    static thread_local std::vector<float> errors;
+    static thread_local std::vector<int32_t> vertexMap;
+    errors.assign(gridSize * gridSize, 0.0f);
+
+    // Border vertices have infinite error, so they are always included.
+    // This keeps the borders identical to those of neighbouring grids.
+    for ( int k = 0; k < gridSize; k++ ) {
+        errors[ k ] = INFINITY;
+        errors[ tileSize * gridSize + k ] = INFINITY;
+        errors[ k * gridSize ] = INFINITY;
+        errors[ k * gridSize + tileSize ] = INFINITY;
+    }
+
+    // Walk the implicit binary triangle tree bottom-up, so the error of every
+    // midpoint includes the errors of the triangles below it.
+    for ( int t = triangleCount - 1; t >= 0; t-- ) {
+        int id = t + 2;
+        int ai = 0, aj = 0, bi = 0, bj = 0, ci = 0, cj = 0;
+
+        if ( id & 1 ) {
+            bi = bj = ci = tileSize;
+        } else {
+            ai = aj = cj = tileSize;
+        }
+        while (( id >>= 1 ) > 1 ) {
+            int mi = ( ai + bi ) >> 1;
+            int mj = ( aj + bj ) >> 1;
+            if ( id & 1 ) {
+                bi = ai;
+                bj = aj;
+                ai = ci;
+                aj = cj;
+            } else {
+                ai = bi;
+                aj = bj;
+                bi = ci;
+                bj = cj;
+            }
+            ci = mi;
+            cj = mj;
+        }
+
+        int mi = ( ai + bi ) >> 1;
+        int mj = ( aj + bj ) >> 1;
+        int middleIndex = mi * gridSize + mj;
+
+        float interpolatedHeight = ( heights[ ai * gridSize + aj ] + heights[ bi * gridSize + bj ] ) / 2.0f;
+        float middleError = std::abs(interpolatedHeight - heights[ middleIndex ]);
+
+        // Force a minimum resolution for the water surface
+        if ( heights[ middleIndex ] <= 0.0f &&
+             std::abs(ai - bi) + std::abs(aj - bj) > 2 * TERRAIN_MESH_WATER_MAX_CELLS )
+            middleError = INFINITY;
+
+        errors[ middleIndex ] = std::max(errors[ middleIndex ], middleError);
+
+        if ( t < parentTriangleCount ) {
+            int leftChildIndex = (( ai + ci ) >> 1 ) * gridSize + (( aj + cj ) >> 1 );
+            int rightChildIndex = (( bi + ci ) >> 1 ) * gridSize + (( bj + cj ) >> 1 );
+            errors[ middleIndex ] = std::max(errors[ middleIndex ],
+                                             std::max(errors[ leftChildIndex ], errors[ rightChildIndex ]));
+        }
+    }
+
+    vertexMap.assign(gridSize * gridSize, -1);
+    rtin_context_t context = { errors.data(), gridSize, maxError, &vertexMap, &vertices, &indices };
+
+    processTriangle(context, 0, 0, tileSize, tileSize, tileSize, 0);
+    processTriangle(context, tileSize, tileSize, 0, 0, 0, tileSize);
+}
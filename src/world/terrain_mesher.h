@@ -0,0 +1,57 @@
+//
+// Created by Luca Warmenhoven on 17/10/2026.
+//
+
+#ifndef GRAPHICS_TEST_TERRAIN_MESHER_H
+#define GRAPHICS_TEST_TERRAIN_MESHER_H
+
+#include <cstdint>
+#include <vector>
+
+#define TERRAIN_MESH_REGULAR (0)
+#define TERRAIN_MESH_ADAPTIVE (1)
+
+// The maximum vertical error of the adaptive mesh, in world units
+#define TERRAIN_MESH_MAX_ERROR (2.0f)
+
+// The maximum length of a triangle leg below the water level, in grid cells.
+// The water surface is displaced by the vertex shader and needs a minimum resolution.
+#define TERRAIN_MESH_WATER_MAX_CELLS (4)
+
+/**
+ * Triangulates square height grids.
+ *
+ * Both meshers output the vertices that are used as indices into the height
+ * grid (i * gridSize + j), and the triangles as indices into that vertex list.
+ */
+class TerrainMesher
+{
+public:
+
+    /**
+     * Regular triangulation with two triangles for every grid cell.
+     *
+     * @param gridSize The amount of samples along each side of the grid
+     * @param vertices The grid indices of the used vertices
+     * @param indices The triangles, as indices into `vertices`
+     */
+    static void meshRegular(int gridSize, std::vector<uint32_t> &vertices, std::vector<unsigned int> &indices);
+
+    /**
+     * Adaptive triangulation using a right-triangulated irregular network (RTIN).
+     * Triangles are only split where the linear interpolation of the surface
+     * deviates more than `maxError` from the height grid.
+     * The outer edges of the grid are always kept at full resolution, so two
+     * neighbouring grids always line up without cracks.
+     *
+     * @param heights The height grid, gridSize^2 samples
+     * @param gridSize The amount of samples along each side, must be 2^n + 1
+     * @param maxError The maximum vertical error
+     * @param vertices The grid indices of the used vertices
+     * @param indices The triangles, as indices into `vertices`
+     */
+    static void meshAdaptive(const float *heights, int gridSize, float maxError,
+                             std::vector<uint32_t> &vertices, std::vector<unsigned int> &indices);
+};
+
+#endif //GRAPHICS_TEST_TERRAIN_MESHER_H
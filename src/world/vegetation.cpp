@@ -0,0 +1,197 @@
+//
+// Created by Luca Warmenhoven on 17/10/2026.
+//
+
+#include "vegetation.h"
+#include "world.h"
+#include "terrain_generator.h"
+
+/**
+ * Small deterministic random number generator (SplitMix64).
+ * The standard distributions aren't guaranteed to produce the same
+ * sequence across standard library implementations, this is.
+ */
+typedef struct {
+    uint64_t state;
+} vegetation_random_t;
+
+static inline uint64_t nextRandom(vegetation_random_t &random)
+{
+    uint64_t z = ( random.state += 0x9E3779B97F4A7C15ULL );
+    z = ( z ^ ( z >> 30 )) * 0xBF58476D1CE4E5B9ULL;
+    z = ( z ^ ( z >> 27 )) * 0x94D049BB133111EBULL;
+    return z ^ ( z >> 31 );
+}
+
+/** Random float in [0, 1) */
+static inline float nextRandomFloat(vegetation_random_t &random)
+{
+    return (float) ( nextRandom(random) >> 40 ) / (float) ( 1ULL << 24 );
+}
+
+/**
+ * Bilinearly samples the height grid at a position in cells.
+ * The position must lie within [0, CHUNK_SIZE), the last cells interpolate
+ * towards the first row and column of the neighbouring chunks.
+ */
+static float sampleHeight(const float *heightMap, float u, float v, float *slope)
+{
+    int i = (int) u;
+    int j = (int) v;
+    float fu = u - (float) i;
+    float fv = v - (float) j;
+
+    const int width = CHUNK_SIZE + 1;
+    float h00 = heightMap[ i * width + j ];
+    float h10 = heightMap[ ( i + 1 ) * width + j ];
+    float h01 = heightMap[ i * width + j + 1 ];
+    float h11 = heightMap[ ( i + 1 ) * width + j + 1 ];
+
+    // Gradient of the bilinear patch, converted from cells to world units
+    float du = (( h10 - h00 ) * ( 1 - fv ) + ( h11 - h01 ) * fv ) / CHUNK_COORDINATE_SCALING_FACTOR;
+    float dv = (( h01 - h00 ) * ( 1 - fu ) + ( h11 - h10 ) * fu ) / CHUNK_COORDINATE_SCALING_FACTOR;
+    *slope = std::sqrt(du * du + dv * dv);
+
+    return ( h00 * ( 1 - fu ) + h10 * fu ) * ( 1 - fv ) + ( h01 * ( 1 - fu ) + h11 * fu ) * fv;
+}
+
+/**
+ * Picks a vegetation type that fits the provided height and slope.
+ * Returns -1 if no type fits.
+ */
+static int pickType(vegetation_random_t &random, float height, float slope)
+{
+    float totalWeight = 0.0f;
+    for ( const vegetation_type_t &type: Vegetation::TYPES ) {
+        if ( height >= type.min_height && height <= type.max_height && slope <= type.max_slope )
+            totalWeight += type.weight;
+    }
+    if ( totalWeight <= 0.0f )
+        return -1;
+
+    float pick = nextRandomFloat(random) * totalWeight;
+    for ( int i = 0; i < VEGETATION_TYPE_COUNT; i++ ) {
+        const vegetation_type_t &type = Vegetation::TYPES[ i ];
+        if ( height < type.min_height || height > type.max_height || slope > type.max_slope )
+            continue;
+        pick -= type.weight;
+        if ( pick <= 0.0f )
+            return i;
+    }
+    return VEGETATION_TYPE_COUNT - 1;
+}
+
+/*
+ * Poisson-disk sampling following Bridson's algorithm.
+ * Every accepted sample is then filtered on height and slope.
+ */
+void Vegetation::scatter(int32_t chunkX, int32_t chunkZ, const float *heightMap,
+                         std::vector<vegetation_instance_t> &instances)
+{
+    const float extent = (float) CHUNK_SIZE;
+    const float cellSize = VEGETATION_MIN_DISTANCE / std::sqrt(2.0f);
+    const int gridSize = (int) std::ceil(extent / cellSize);
+
+    // Mix the seed before the chunk coordinates, so every world gets its own vegetation
+    vegetation_random_t random = { TerrainGenerator::getSeed() };
+    random.state = nextRandom(random)
+                   ^ (((uint64_t) (uint32_t) ( chunkX / CHUNK_SIZE ) << 32 ) | (uint32_t) ( chunkZ / CHUNK_SIZE ));
+    nextRandom(random);
+
+    // Grid with the index of the sample in each cell, or -1 if it's empty.
+    // The buffers are reused between the calls on the same thread.
+    static thread_local std::vector<int> grid;
+    static thread_local std::vector<glm::vec2> samples;
+    static thread_local std::vector<int> active;
+    grid.assign(gridSize * gridSize, -1);
+    samples.clear();
+    active.clear();
+
+    auto insertSample = [&](glm::vec2 sample) {
+        grid[ (int) ( sample.x / cellSize ) * gridSize + (int) ( sample.y / cellSize ) ] = (int) samples.size();
+        active.push_back((int) samples.size());
+        samples.push_back(sample);
+    };
+
+    insertSample(glm::vec2(nextRandomFloat(random), nextRandomFloat(random)) * extent);
+
+    while ( !active.empty()) {
+        int activeIndex = (int) ( nextRandom(random) % active.size());
+        glm::vec2 origin = samples[ active[ activeIndex ]];
+        bool found = false;
+
+        for ( int attempt = 0; attempt < VEGETATION_SAMPLE_ATTEMPTS && !found; attempt++ ) {
+            float angle = nextRandomFloat(random) * 2.0f * (float) M_PI;
+            float distance = VEGETATION_MIN_DISTANCE * ( 1.0f + nextRandomFloat(random));
+            glm::vec2 candidate = origin + glm::vec2(std::cos(angle), std::sin(angle)) * distance;
+
+            if ( candidate.x < 0 || candidate.y < 0 || candidate.x >= extent || candidate.y >= extent )
+                continue;
+
+            // Check the surrounding cells for samples that are too close
+            int cellX = (int) ( candidate.x / cellSize );
+            int cellZ = (int) ( candidate.y / cellSize );
+            bool valid = true;
+            for ( int i = std::max(0, cellX - 2); i <= std::min(gridSize - 1, cellX + 2) && valid; i++ ) {
+                for ( int j = std::max(0, cellZ - 2); j <= std::min(gridSize - 1, cellZ + 2); j++ ) {
+                    int neighbour = grid[ i * gridSize + j ];
+                    if ( neighbour >= 0 && glm::length(samples[ neighbour ] - candidate) < VEGETATION_MIN_DISTANCE ) {
+                        valid = false;
+                        break;
+                    }
+                }
+            }
+            if ( valid ) {
+                insertSample(candidate);
+                found = true;
+            }
+        }
+
+        if ( !found ) {
+            active[ activeIndex ] = active.back();
+            active.pop_back();
+        }
+    }
+
+    for ( glm::vec2 sample: samples ) {
+        float slope;
+        float height = sampleHeight(heightMap, sample.x, sample.y, &slope);
+        int typeIndex = pickType(random, height, slope);
+
+        // Always consume the same amount of random numbers per sample,
+        // so the output stays stable when placement rules change.
+        float rotation = nextRandomFloat(random);
+        float scale = nextRandomFloat(random);
+
+        if ( typeIndex < 0 )
+            continue;
+
+        const vegetation_type_t &type = TYPES[ typeIndex ];
+        scale = type.min_scale + ( type.max_scale - type.min_scale ) * scale;
+
+        instances.push_back({
+                (((float) chunkX + sample.x ) - 0.5f ) * CHUNK_COORDINATE_SCALING_FACTOR,
+                height,
+                (((float) chunkZ + sample.y ) - 0.5f ) * CHUNK_COORDINATE_SCALING_FACTOR,
+                (uint16_t) ( rotation * 65535.0f ),
+                (uint8_t) (( scale - VEGETATION_MIN_SCALE ) / ( VEGETATION_MAX_SCALE - VEGETATION_MIN_SCALE ) * 255.0f ),
+                (uint8_t) typeIndex
+        });
+    }
+}
+
+glm::mat4 Vegetation::getTransform(const vegetation_instance_t &instance)
+{
+    float angle = (float) instance.rotation / 65535.0f * 2.0f * (float) M_PI;
+    float scale = VEGETATION_MIN_SCALE + ( VEGETATION_MAX_SCALE - VEGETATION_MIN_SCALE ) * (float) instance.scale / 255.0f;
+    float c = std::cos(angle) * scale;
+    float s = std::sin(angle) * scale;
+
+    // Translation * rotation around the y-axis * uniform scale
+    return {
+            glm::vec4(c, 0.0f, -s, 0.0f),
+            glm::vec4(0.0f, scale, 0.0f, 0.0f),
+            glm::vec4(s, 0.0f, c, 0.0f),
+            glm::vec4(instance.x, instance.y, instance.z, 1.0f)
+    };
+}
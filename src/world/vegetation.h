@@ -0,0 +1,84 @@
+//
+// Created by Luca Warmenhoven on 17/10/2026.
+//
+
+#ifndef GRAPHICS_TEST_VEGETATION_H
+#define GRAPHICS_TEST_VEGETATION_H
+
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+#define VEGETATION_TYPE_TREE (0)
+#define VEGETATION_TYPE_ROCK (1)
+#define VEGETATION_TYPE_COUNT (2)
+
+// Minimum distance between two props, in height map cells
+#define VEGETATION_MIN_DISTANCE (2.5f)
+
+// Amount of candidates that are tried around every sample before it is discarded
+#define VEGETATION_SAMPLE_ATTEMPTS (20)
+
+// Distance up to which vegetation is drawn, in chunks
+#define VEGETATION_DRAW_DISTANCE (4)
+
+#define VEGETATION_MIN_SCALE (0.5f)
+#define VEGETATION_MAX_SCALE (2.0f)
+
+/**
+ * Placement rules for a type of vegetation.
+ */
+typedef struct {
+    float min_height;
+    float max_height;
+    float max_slope;    // Maximum rise per horizontal world unit
+    float weight;       // Relative chance of being picked when multiple types fit
+    float min_scale;
+    float max_scale;
+} vegetation_type_t;
+
+/**
+ * A single placed prop. Kept compact (16 bytes), since every chunk
+ * keeps its instances in memory for as long as the chunk is loaded.
+ */
+typedef struct {
+    float x, y, z;      // World space position
+    uint16_t rotation;  // Rotation around the y-axis, quantized over [0, 2PI)
+    uint8_t scale;      // Quantized over [VEGETATION_MIN_SCALE, VEGETATION_MAX_SCALE]
+    uint8_t type;
+} vegetation_instance_t;
+
+class Vegetation
+{
+public:
+
+    /**
+     * The placement rules of all vegetation types, indexed by type.
+     */
+    static constexpr vegetation_type_t TYPES[VEGETATION_TYPE_COUNT] = {
+            { 5.0f,   400.0f, 0.6f, 3.0f, 0.8f, 1.6f }, // Tree
+            { -20.0f, 800.0f, 1.5f, 1.0f, 0.5f, 2.0f }  // Rock
+    };
+
+    /**
+     * Scatters vegetation over a chunk using Poisson-disk sampling.
+     * The result only depends on the terrain seed, the chunk coordinates and the heights,
+     * so regenerating a chunk always yields the same vegetation.
+     * This is safe to call from any thread.
+     *
+     * @param chunkX The x coordinate of the chunk, in height map cells
+     * @param chunkZ The z coordinate of the chunk, in height map cells
+     * @param heightMap The heights of the chunk, (CHUNK_SIZE + 1)^2 samples including
+     *                  the first row and column of the neighbouring chunks
+     * @param instances The vector to append the placed instances to
+     */
+    static void scatter(int32_t chunkX, int32_t chunkZ, const float *heightMap,
+                        std::vector<vegetation_instance_t> &instances);
+
+    /**
+     * Get the model matrix of a placed instance.
+     */
+    static glm::mat4 getTransform(const vegetation_instance_t &instance);
+};
+
+#endif //GRAPHICS_TEST_VEGETATION_H
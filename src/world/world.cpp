@@ -2,20 +2,28 @@
 // Created by Luca Warmenhoven on 20/05/2024.
 //
 #include "world.h"
-#include "noise.h"
+#include "terrain_generator.h"
+#include "../memory/size_class_allocator.h"
+#include "height_map_codec.h"
 #include <iostream>
 #include <random>
+#include <algorithm>
+#include <cstring>
 
 /** Global variables */
 glm::vec3 World::sunPosition = glm::normalize(glm::vec3(0.0f, 1.0f, 2.0f));
 glm::vec4 World::sunColor = glm::vec4(1.0f, 1.0f, .8f, 1.0f);
 
 float World::sunIntensity = 1.0f;
-float World::sunSize = 0.14f;
+float World::sunSize = 0.04f; // Angular radius of the sun disc, in radians
 float World::sunAmbient = 0.1f;
 
 float World::fogDensity = 0.0005f;
 
+bool World::hugePagePools = false;
+
+int World::pipelineStatsInterval = 0;
+
 glm::vec4 World::fogColor = glm::vec4(0.5f, 0.5f, 0.5f, 1.0f);
 glm::vec3 World::fogFactors = glm::vec3(0.1f, 0.5f, 0.5f);
 
@@ -24,7 +32,34 @@ glm::vec4 World::skyTopColor = glm::vec4(.23, .64, .97, 1.0);
 
 
 
-void worldGenerationFn(World *world, Transformation *observationPoint, glm::vec3 *lastObservationPoint)
+/*
+ * The chunk the provided point lies in, in height map cells.
+ */
+static glm::ivec2 getObservedChunk(glm::vec3 position)
+{
+    return glm::ivec2((((int32_t) position.x ) / (int) (CHUNK_COORDINATE_SCALAR)) * CHUNK_SIZE,
+                      (((int32_t) position.z ) / (int) (CHUNK_COORDINATE_SCALAR)) * CHUNK_SIZE);
+}
+
+/*
+ * The offsets of the chunks within the draw distance, in chunks, nearest first.
+ */
+static void getRingOffsets(int drawDistance, std::vector<glm::ivec2> &offsets)
+{
+    offsets.clear();
+    for ( int32_t x = -drawDistance; x < drawDistance; x++ )
+        for ( int32_t z = -drawDistance; z < drawDistance; z++ )
+            offsets.emplace_back(x, z);
+    std::sort(offsets.begin(), offsets.end(), [](glm::ivec2 a, glm::ivec2 b) {
+        return a.x * a.x + a.y * a.y < b.x * b.x + b.y * b.y;
+    });
+}
+
+/*
+ * Keeps requesting the chunks around the observation point, nearest first.
+ * The chunks are generated by the workers of the generation job system.
+ */
+void worldGenerationFn(World *world, Transformation *observationPoint)
 {
 
     if ( observationPoint == nullptr ) {
@@ -32,37 +67,98 @@ void worldGenerationFn(World *world, Transformation *observationPoint, glm::vec3
         return;
     }
 
-    // Generate chunkMap around the observation point in a circular manner
-    int32_t x, z, px, pz;
-    // Wait until the thread is stopped
-    std::chrono::nanoseconds interval(10);
-
-    while ( true ) {
-        if (
-                pow(lastObservationPoint->x - observationPoint->position.x , 2)
-              + pow(lastObservationPoint->z - observationPoint->position.z, 2) >=
-                pow(CHUNK_COORDINATE_SCALAR, 2)) {
-            *lastObservationPoint = observationPoint->position;
-            /*if ( world->chunkMap->size() > 5000 )
-                return;*/
-            px = (((int32_t) observationPoint->position.x ) / (int) (CHUNK_COORDINATE_SCALAR)) *
-                 CHUNK_SIZE;
-            pz = (((int32_t) observationPoint->position.z ) / (int) (CHUNK_COORDINATE_SCALAR)) *
-                 CHUNK_SIZE;
-
-            for ( x = -CHUNK_DRAW_DISTANCE; x < CHUNK_DRAW_DISTANCE; x++ ) {
-                for ( z = -CHUNK_DRAW_DISTANCE; z < CHUNK_DRAW_DISTANCE; z++ ) {
-                    std::this_thread::sleep_for(interval);
-                    world->generateChunk(
-                            px + x * CHUNK_SIZE,
-                            pz + z * CHUNK_SIZE
-                    );
-                }
+    int32_t px, pz;
+    int32_t lastX = INT32_MAX, lastZ = INT32_MAX;
+    int lastDrawDistance = -1;
+    std::vector<glm::ivec2> offsets, requests;
+    std::chrono::milliseconds interval(10);
+    int iterationsSinceTierUpdate = 0;
+    bool tiersOutdated = false;
+    double lastStatsLog = ChunkPipelineStats::now();
+
+    while ( world->generating ) {
+        // The observation point is moved by the entity update, so only its copy is read here
+        glm::vec3 position = world->getObservedPosition();
+        glm::ivec2 observedChunk = getObservedChunk(position);
+        px = observedChunk.x;
+        pz = observedChunk.y;
+        int drawDistance = world->drawDistance;
+
+        // Only request chunks when the observation point entered another chunk, or the draw distance changed.
+        if ( px != lastX || pz != lastZ || drawDistance != lastDrawDistance ) {
+            double scanStart = ChunkPipelineStats::now();
+            lastX = px;
+            lastZ = pz;
+            tiersOutdated = true;
+
+            if ( drawDistance != lastDrawDistance ) {
+                lastDrawDistance = drawDistance;
+                getRingOffsets(drawDistance, offsets);
             }
+
+            requests.clear();
+            for ( glm::ivec2 offset: offsets )
+                requests.emplace_back(px + offset.x * CHUNK_SIZE, pz + offset.y * CHUNK_SIZE);
+            world->requestChunks(requests);
+            world->evictionRequested = true;
+            world->pipelineStats.record(CHUNK_STAGE_SCAN, ChunkPipelineStats::now() - scanStart);
         }
+
+        if ( World::pipelineStatsInterval > 0 &&
+             ChunkPipelineStats::now() - lastStatsLog >= World::pipelineStatsInterval ) {
+            world->pipelineStats.log(std::cout);
+            lastStatsLog = ChunkPipelineStats::now();
+        }
+
+        // Also revisit the tiers periodically, as chunks keep arriving while the observation point stands still
+        if ( ++iterationsSinceTierUpdate >= CHUNK_HEIGHT_MAP_TIER_UPDATE_INTERVAL || tiersOutdated ) {
+            world->updateHeightMapTiers(position);
+            iterationsSinceTierUpdate = 0;
+            tiersOutdated = false;
+        }
+        std::this_thread::sleep_for(interval);
     }
 }
 
+/*
+ * Periodically saves the chunks that changed, and the entities.
+ * The entities are copied by the frame that updates them, the chunks are
+ * copied under a short lock, so the frame never waits for the disk.
+ */
+void worldAutosaveFn(World *world)
+{
+    std::unique_lock<std::mutex> lock(world->autosaveMutex);
+    while ( world->autosaving ) {
+        world->autosaveCondition.wait_for(lock, std::chrono::seconds(WORLD_AUTOSAVE_INTERVAL));
+        if ( !world->autosaving )
+            break;
+
+        world->entitySnapshotReady = false;
+        world->entitySnapshotRequested = true;
+        lock.unlock();
+        world->saveChunks();
+        // The chunks outside the draw distance that were just saved can go now
+        world->evictionRequested = true;
+        lock.lock();
+
+        // The snapshot is made during the next entity update, which has usually happened by now
+        world->autosaveCondition.wait(lock, [world] { return world->entitySnapshotReady || !world->autosaving; });
+        if ( !world->entitySnapshotReady )
+            break;
+        std::vector<world_storage_entity_t> entities = world->entitySnapshot;
+        lock.unlock();
+        world->storage->writeEntities(entities);
+        world->storage->flush();
+        lock.lock();
+    }
+}
+
+World::World()
+{
+    worldObjects = new std::vector<Entity *>();
+    chunkMap = new std::unordered_map<std::size_t, chunk_t *>();
+}
+
 /*
  * Start the world generation thread.
  * This method is called from the main thread and will startWorldGeneration
@@ -75,46 +171,199 @@ void World::startWorldGeneration(Transformation *observationPoint)
     if ( this->worldGenerationThread )
         return;
 
-    World::lastGenerationPoint = observationPoint->position + vec3(10000, 0, 0);
+    this->observationPoint = observationPoint;
+    if ( observationPoint ) {
+        std::lock_guard<std::mutex> lock(observedPositionMutex);
+        observedPosition = observationPoint->position;
+    }
 
-    drawables = new std::vector<Drawable *>();
-    worldObjects = new std::vector<Entity *>();
-    chunkMap = new std::unordered_map<std::size_t, chunk_t *>();
-    chunkMeshGenerationQueue = new std::queue<immature_chunk_data_t *>();
-    worldGenerationThread = new std::thread(worldGenerationFn, this, observationPoint, &lastGenerationPoint);
+    createPools();
+    generationJobs = new JobSystem(CHUNK_GENERATION_WORKER_COUNT);
+    generating = true;
+    worldGenerationThread = new std::thread(worldGenerationFn, this, observationPoint);
+    if ( storage ) {
+        autosaving = true;
+        autosaveThread = new std::thread(worldAutosaveFn, this);
+    }
 }
 
-inline bool shouldRenderChunk(chunk_t &chunk, Frustum *frustum)
+/*
+ * Creates the chunk memory pools, unless the warm start has created them already.
+ */
+void World::createPools()
 {
-    //return frustum->isWithin(vec3(chunk.x + offset, 0, chunk.z + offset), offset * 2);
+    if ( chunkPool )
+        return;
+    chunkPool = new SlabPool(sizeof(chunk_t), CHUNK_POOL_BLOCKS_PER_SLAB, hugePagePools);
+    heightMapPool = new SlabPool(sizeof(uint16_t) * CHUNK_SIZE * CHUNK_SIZE, CHUNK_POOL_BLOCKS_PER_SLAB,
+                                 hugePagePools);
+}
 
-    return frustum->isWithin(vec3(chunk.x, 0, chunk.z),
-                             CHUNK_SIZE * CHUNK_COORDINATE_SCALING_FACTOR * 2);
+void World::stopWorldGeneration()
+{
+    // Stop requesting chunks, and let the requested chunks run to completion.
+    // Chunks that haven't been generated yet return right away, now that generating is false.
+    generating = false;
+    if ( worldGenerationThread && worldGenerationThread->joinable())
+        worldGenerationThread->join();
+    if ( generationJobs )
+        generationJobs->wait();
 }
 
-/**
- * Render the world.
- * This function will render all the chunkMap that are within the frustum.
- */
-void World::render(float deltaTime, Frustum *frustum)
+void World::setChunkListener(ChunkListener *listener)
 {
-    int chunksRendered = 0;
-    for ( auto chunkPair: *chunkMap ) {
-        if ( !shouldRenderChunk(*chunkPair.second, frustum))
-            continue;
-        chunkPair.second->mesh->draw(deltaTime);
-        chunksRendered++;
+    if ( generating ) {
+        std::cerr << "The chunk listener can't be changed while the world is being generated." << std::endl;
+        return;
     }
-    for ( Drawable *drawable: *drawables ) {
-        drawable->draw(0);
+
+    // The previous listener still has to let go of the chunks that were removed last
+    {
+        std::lock_guard<std::mutex> lock(worldGenerationMutex);
+        for ( chunk_t *chunk: removedChunks ) {
+            if ( chunkListener )
+                chunkListener->onChunkRemoved(chunk);
+            retiredChunks.push_back(chunk);
+        }
+        removedChunks.clear();
     }
+    chunkListener = listener;
+}
 
-    // If there's chunkMap that need their meshes to be generated, then do so.
-    if ( !chunkMeshGenerationQueue->empty()) {
-        immature_chunk_data_t *chunk_mesh_data = chunkMeshGenerationQueue->front();
-        generateChunkMesh(chunk_mesh_data->chunk, chunk_mesh_data->mesh_data);
-        chunkMeshGenerationQueue->pop();
+void World::openStorage(const char *directory)
+{
+    if ( this->worldGenerationThread ) {
+        std::cerr << "The storage has to be opened before the world generation is started." << std::endl;
+        return;
     }
+    delete storage;
+    storage = new WorldStorage(directory, CHUNK_SIZE);
+
+    // The terrain follows the seed of the save, new saves keep the current seed
+    uint32_t seed;
+    if ( storage->readSeed(seed))
+        TerrainGenerator::setSeed(seed);
+    else
+        storage->writeSeed(TerrainGenerator::getSeed());
+}
+
+void World::connectChunkServer(const char *socketPath)
+{
+    if ( this->worldGenerationThread ) {
+        std::cerr << "The chunk server has to be connected before the world generation is started." << std::endl;
+        return;
+    }
+    delete chunkClient;
+    chunkClient = new ChunkClient(socketPath, CHUNK_SIZE, TerrainGenerator::getSeed());
+}
+
+bool World::loadEntities(const std::vector<Entity *> &entities)
+{
+    std::vector<world_storage_entity_t> stored;
+    if ( !storage || !storage->readEntities(stored))
+        return false;
+
+    for ( size_t i = 0; i < entities.size() && i < stored.size(); i++ ) {
+        entities[ i ]->position = stored[ i ].position;
+        entities[ i ]->velocity = stored[ i ].velocity;
+        entities[ i ]->rotation = stored[ i ].rotation;
+    }
+    return !stored.empty();
+}
+
+void World::snapshotEntities(std::vector<world_storage_entity_t> &snapshot) const
+{
+    snapshot.clear();
+    for ( Entity *entity: *worldObjects )
+        snapshot.push_back({ entity->position, entity->velocity, entity->rotation });
+}
+
+int World::saveChunks()
+{
+    if ( !storage )
+        return 0;
+
+    // The chunks are used without the chunk map lock, so they mustn't be freed meanwhile
+    std::shared_lock<std::shared_mutex> lifetimeLock(chunkLifetimeMutex);
+    std::vector<chunk_t *> chunks;
+    {
+        std::lock_guard<std::mutex> lock(worldGenerationMutex);
+        for ( auto chunkPair: *chunkMap )
+            chunks.push_back(chunkPair.second);
+    }
+
+    int written = 0;
+    uint16_t quantized[ CHUNK_SIZE * CHUNK_SIZE ];
+    for ( chunk_t *chunk: chunks ) {
+        float minimum, scale;
+        {
+            // Only held while copying, the chunk is encoded and written without it
+            std::unique_lock<std::shared_mutex> lock(heightMapMutex);
+            if ( !chunk->dirty )
+                continue;
+            if ( chunk->height_map )
+                memcpy(quantized, chunk->height_map, sizeof(quantized));
+            else
+                HeightMapCodec::decode(chunk->cold_height_map, chunk->cold_height_map_size, CHUNK_SIZE * CHUNK_SIZE,
+                                       CHUNK_SIZE, quantized);
+            minimum = chunk->height_map_minimum;
+            scale = chunk->height_map_scale;
+            chunk->dirty = false;
+        }
+
+        auto x = (int32_t) ( chunk->x / CHUNK_COORDINATE_SCALING_FACTOR );
+        auto z = (int32_t) ( chunk->z / CHUNK_COORDINATE_SCALING_FACTOR );
+        if ( storage->writeChunk(x, z, quantized, minimum, scale)) {
+            written++;
+            continue;
+        }
+
+        // Retried during the next save
+        std::unique_lock<std::shared_mutex> lock(heightMapMutex);
+        chunk->dirty = true;
+    }
+    return written;
+}
+
+void World::save()
+{
+    if ( !storage )
+        return;
+
+    saveChunks();
+    if ( worldObjects ) {
+        std::vector<world_storage_entity_t> entities;
+        snapshotEntities(entities);
+        storage->writeEntities(entities);
+    }
+    storage->flush();
+}
+
+void World::setGenerationWorkerCount(int workerCount)
+{
+    generationJobs->setWorkerCount(workerCount);
+}
+
+int World::getGenerationWorkerCount()
+{
+    return generationJobs->getWorkerCount();
+}
+
+glm::vec3 World::getObservedPosition() const
+{
+    std::lock_guard<std::mutex> lock(observedPositionMutex);
+    return observedPosition;
+}
+
+/**
+ * Whether a chunk, in height map cells, lies within the draw distance of the provided point.
+ * One chunk of slack is added, so chunks at the edge don't flicker in and out.
+ */
+bool World::isWithinDrawDistance(int32_t x, int32_t z, glm::vec3 center) const
+{
+    float limit = (float) ( drawDistance + 1 ) * CHUNK_COORDINATE_SCALAR;
+    return std::abs((float) x * CHUNK_COORDINATE_SCALING_FACTOR - center.x) <= limit &&
+           std::abs((float) z * CHUNK_COORDINATE_SCALING_FACTOR - center.z) <= limit;
 }
 
 /**
@@ -125,203 +374,1006 @@ size_t chunk_hash(int32_t x, int32_t z)
     return (( x << 16 ) | ( z & 0xFFFF )) ^ 0x9e3779b9;
 }
 
-/**
- * Get the biome noise height for a specific coordinate.
- * This can be used to scale certain biomes.
+/*
+ * Sets the vertical bounds of a chunk from the lowest and highest sample of its grid.
+ * Chunks reaching the sea level are extended by the height of the waves.
  */
-static float getBiomeNoise(float x, float z)
+static void setHeightBounds(chunk_t *chunk, float minHeight, float maxHeight)
 {
-    return ( SimplexNoise::noise((float) x / 100.0f, (float) z / 100.0f) + 1 ) / 2;
+    chunk->grid_min_height = minHeight;
+    chunk->grid_max_height = maxHeight;
+    chunk->min_height = minHeight;
+    chunk->max_height = maxHeight;
+    if ( minHeight <= 0.0f ) {
+        chunk->min_height -= CHUNK_WAVE_HEIGHT_MARGIN;
+        chunk->max_height = std::max(maxHeight, CHUNK_WAVE_HEIGHT_MARGIN);
+    }
 }
 
-/**
- * Get the height of the chunk at a certain coordinate.
+/*
+ * Adds a chunk to the chunks of its region, the regions are kept in the order in which they were first added.
+ * A scan touches few regions, so they're searched linearly instead of through a map that allocates its nodes.
  */
-static float getChunkHeight(float x, float z)
+static void addToRegion(std::vector<generation_region_t> &regions, glm::ivec2 chunk)
 {
-    x /= 10.0f;
-    z /= 10.0f;
-    float biome_noise = getBiomeNoise(x, z);
-    float biome_height_factor = World::BIOME_HEIGHT_SCALING_FACTORS[ (int) ( biome_noise * CHUNK_BIOME_COUNT) ];
-    biome_height_factor *= biome_noise;
-    float resultingHeight = 0.0f;
+    auto regionX = (int32_t) std::floor((float) chunk.x / ( WORLD_GENERATION_REGION_SIZE * CHUNK_SIZE ));
+    auto regionZ = (int32_t) std::floor((float) chunk.y / ( WORLD_GENERATION_REGION_SIZE * CHUNK_SIZE ));
+    for ( generation_region_t &region: regions ) {
+        // Chunks that aren't aligned to the chunk grid could overflow a region, those continue in a new one
+        if ( region.region_x == regionX && region.region_z == regionZ &&
+             region.count < WORLD_GENERATION_REGION_CHUNKS ) {
+            region.chunks[ region.count++ ] = chunk;
+            return;
+        }
+    }
+    generation_region_t &region = regions.emplace_back();
+    region.region_x = regionX;
+    region.region_z = regionZ;
+    region.chunks[ 0 ] = chunk;
+    region.count = 1;
+}
 
-    for ( auto octave: World::CHUNK_GENERATION_OCTAVES ) {
-        resultingHeight += SimplexNoise::noise(x / octave[ 0 ], z / octave[ 0 ]) * octave[ 1 ];
+void World::requestChunk(int32_t x, int32_t z)
+{
+    requestChunks({ glm::ivec2(x, z) });
+}
+
+void World::requestChunks(const std::vector<glm::ivec2> &chunks)
+{
+    // The chunks of every region, in the order in which the regions were first requested.
+    // Reused between the scans of the generation thread, so the steady state doesn't allocate.
+    static thread_local std::vector<generation_region_t> regions;
+    regions.clear();
+    {
+        std::lock_guard<std::mutex> lock(worldGenerationMutex);
+        for ( glm::ivec2 chunk: chunks ) {
+            size_t hash = chunk_hash(chunk.x, chunk.y);
+            if ( chunkMap->find(hash) != chunkMap->end() || !pendingChunks.insert(hash).second )
+                continue;
+
+            addToRegion(regions, chunk);
+        }
     }
-    resultingHeight = ( resultingHeight ) * CHUNK_GENERATION_MAX_HEIGHT;
-    return biome_height_factor * resultingHeight;
+
+    double requested = ChunkPipelineStats::now();
+    for ( const generation_region_t &region: regions )
+        spawn(streamRegion(region, requested));
 }
 
-/**
- * Get the normal vector at a specific location.
- * This calculates the normal vector based on the adjacent
- * height points, which are calculated by the `getChunkHeight` function.
- */
-static vec3 getNormalVector(float x, float z)
+Task<void> World::streamRegion(generation_region_t region, double requested)
 {
-    // Calculate the normal vectors
-    float height1 = getChunkHeight(x - CHUNK_GENERATION_NORMAL_DELTA, z);
-    float height2 = getChunkHeight(x + CHUNK_GENERATION_NORMAL_DELTA, z);
-    float height3 = getChunkHeight(x, z - CHUNK_GENERATION_NORMAL_DELTA);
-    float height4 = getChunkHeight(x, z + CHUNK_GENERATION_NORMAL_DELTA);
+    co_await resumeOn(generationJobs);
+    double generationStarted = ChunkPipelineStats::now();
 
-    return normalize(vec3(height1 - height2, 2.0f * CHUNK_GENERATION_NORMAL_DELTA, height3 - height4));
+    // The observation point might have moved away since the chunks were requested
+    glm::vec3 position = getObservedPosition();
+    glm::ivec2 *chunks = region.chunks;
+    glm::ivec2 *dropped = std::partition(chunks, chunks + region.count, [this, position](glm::ivec2 chunk) {
+        return generating && isWithinDrawDistance(chunk.x, chunk.y, position);
+    });
+    if ( dropped != chunks + region.count ) {
+        std::lock_guard<std::mutex> lock(worldGenerationMutex);
+        for ( glm::ivec2 *chunk = dropped; chunk != chunks + region.count; chunk++ )
+            pendingChunks.erase(chunk_hash(chunk->x, chunk->y));
+        region.count = dropped - chunks;
+    }
+    if ( region.count == 0 )
+        co_return;
+
+    // Kept in the coroutine frame, like the region
+    chunk_t *generated[WORLD_GENERATION_REGION_CHUNKS];
+    generateChunks(chunks, region.count, generated);
+    for ( size_t i = 0; i < region.count; i++ ) {
+        generated[ i ]->timestamps.requested = requested;
+        generated[ i ]->timestamps.generation_started = generationStarted;
+    }
+
+    // Every chunk takes one unit of the upload budget
+    for ( size_t i = 0; i < region.count; i++ ) {
+        co_await chunkUploads.nextFrame();
+        generated[ i ]->timestamps.upload_started = ChunkPipelineStats::now();
+
+        if ( !generating ) {
+            for ( ; i < region.count; i++ ) {
+                if ( chunkListener )
+                    chunkListener->onChunkDiscarded(generated[ i ]);
+                freeChunk(generated[ i ]);
+            }
+            co_return;
+        }
+        addChunk(generated[ i ]);
+        generated[ i ]->timestamps.uploaded = ChunkPipelineStats::now();
+        pipelineStats.recordUploaded(generated[ i ]->timestamps);
+    }
 }
 
 /*
- * Generate the Mesh for a chunk.
- * This function will startWorldGeneration a Mesh with the provided vertices and indices.
+ * Generates the initial ring of chunks with a worker per core, one region per job.
+ * The chunks are added on the calling thread as soon as they're handed over,
+ * so the uploads overlap with the generation of the remaining regions.
  */
-void World::generateChunkMesh(chunk_t *chunk, vbo_data_t *vbo_data) const
+void World::warmStart(Transformation *observationPoint, const std::function<void(size_t, size_t)> &progress)
+{
+    if ( this->worldGenerationThread ) {
+        std::cerr << "The warm start has to happen before the world generation is started." << std::endl;
+        return;
+    }
+    if ( observationPoint == nullptr ) {
+        std::cerr << "No observation point provided, skipping the warm start." << std::endl;
+        return;
+    }
+    createPools();
+
+    std::vector<glm::ivec2> offsets;
+    getRingOffsets(drawDistance, offsets);
+    glm::ivec2 observedChunk = getObservedChunk(observationPoint->position);
+
+    std::vector<generation_region_t> regions;
+    size_t total = 0;
+    for ( glm::ivec2 offset: offsets ) {
+        glm::ivec2 chunk(observedChunk.x + offset.x * CHUNK_SIZE, observedChunk.y + offset.y * CHUNK_SIZE);
+        if ( chunkMap->find(chunk_hash(chunk.x, chunk.y)) != chunkMap->end())
+            continue;
+        addToRegion(regions, chunk);
+        total++;
+    }
+    if ( total == 0 )
+        return;
+
+    // The generated chunks that haven't been added yet, handed over by the workers
+    std::mutex readyMutex;
+    std::condition_variable readyCondition;
+    std::vector<chunk_t *> ready, added;
+    double requested = ChunkPipelineStats::now();
+
+    JobSystem warmStartJobs(std::max(1, (int) std::thread::hardware_concurrency()));
+    for ( generation_region_t &region: regions ) {
+        warmStartJobs.submit([this, &region, &readyMutex, &readyCondition, &ready, requested] {
+            double generationStarted = ChunkPipelineStats::now();
+            chunk_t *generated[WORLD_GENERATION_REGION_CHUNKS];
+            generateChunks(region.chunks, region.count, generated);
+            for ( size_t i = 0; i < region.count; i++ ) {
+                generated[ i ]->timestamps.requested = requested;
+                generated[ i ]->timestamps.generation_started = generationStarted;
+            }
+            {
+                std::lock_guard<std::mutex> lock(readyMutex);
+                ready.insert(ready.end(), generated, generated + region.count);
+            }
+            readyCondition.notify_one();
+        });
+    }
+
+    // No upload budget applies here, the first frame waits for all chunks anyway
+    size_t addedCount = 0;
+    while ( addedCount < total ) {
+        {
+            std::unique_lock<std::mutex> lock(readyMutex);
+            readyCondition.wait(lock, [&ready] { return !ready.empty(); });
+            added.swap(ready);
+        }
+        for ( chunk_t *chunk: added ) {
+            chunk->timestamps.upload_started = ChunkPipelineStats::now();
+            addChunk(chunk);
+            chunk->timestamps.uploaded = ChunkPipelineStats::now();
+            pipelineStats.recordUploaded(chunk->timestamps);
+        }
+        addedCount += added.size();
+        added.clear();
+        if ( progress )
+            progress(addedCount, total);
+    }
+    warmStartJobs.wait();
+}
+
+void World::freeChunk(chunk_t *chunk)
 {
-    VBO *mesh = new VBO();
-    mesh->withVertices(vbo_data->vertices, vbo_data->vertices_count);
-    mesh->withIndices(vbo_data->indices, vbo_data->indices_count);
-    mesh->build();
-    chunk->mesh = mesh;
-    // Add chunk to world
-    chunkMap->insert({ chunk_hash(chunk->x, chunk->z), chunk });
-    // Free old memory, it's been copied video memory.
-    free(vbo_data->indices);
-    free(vbo_data->vertices);
-    free(vbo_data);
+    heightMapPool->release(chunk->height_map);
+    SizeClassAllocator::release(chunk->cold_height_map, chunk->cold_height_map_size);
+    SizeClassAllocator::release(chunk->vegetation, sizeof(vegetation_instance_t) * chunk->vegetation_count);
+    chunkPool->release(chunk);
 }
 
-void World::update(float deltaTime) const
+void World::applyChanges()
 {
-    for ( Entity *entities: *worldObjects ) {
-        entities->update(deltaTime);
+    // Let the chunks that are waiting to be added continue, up to the upload budget.
+    chunkUploads.resume(uploadBudget);
+    applyTerrainEdits();
+    evictChunks();
+}
+
+/*
+ * Chunks go through three steps when they're evicted, so no thread uses a chunk when it's freed:
+ * removed from the chunk map, so no new draw list contains them, then handed to the chunk
+ * listener during the next call, after the draw list built before the removal has been drawn,
+ * and finally freed when no other thread holds on to chunks.
+ */
+void World::evictChunks()
+{
+    std::vector<chunk_t *> released;
+    {
+        std::lock_guard<std::mutex> lock(worldGenerationMutex);
+        released.swap(removedChunks);
+    }
+    for ( chunk_t *chunk: released )
+        if ( chunkListener )
+            chunkListener->onChunkRemoved(chunk);
+
+    std::lock_guard<std::mutex> lock(worldGenerationMutex);
+    retiredChunks.insert(retiredChunks.end(), released.begin(), released.end());
+    freeRetiredChunks();
+
+    if ( !evictionRequested.exchange(false))
+        return;
+
+    glm::vec3 position = getObservedPosition();
+    float limit = (float) ( drawDistance + CHUNK_EVICTION_MARGIN ) * CHUNK_COORDINATE_SCALAR;
+    std::shared_lock<std::shared_mutex> heightMapLock(heightMapMutex);
+    for ( auto entry = chunkMap->begin(); entry != chunkMap->end(); ) {
+        chunk_t *chunk = entry->second;
+        bool outside = std::abs(chunk->x - position.x) > limit || std::abs(chunk->z - position.z) > limit;
+
+        // Changed chunks are saved by the next autosave first, which requests another eviction
+        if ( !outside || ( storage && chunk->dirty )) {
+            entry++;
+            continue;
+        }
+        removedChunks.push_back(chunk);
+        entry = chunkMap->erase(entry);
+        chunkRevision++;
+        evictionRevision++;
     }
 }
 
 /*
- * Generate a chunk at the given coordinates.
- * This function will startWorldGeneration both the height-map coordinates for the chunk, and the Mesh mesh_data.
- * This Mesh mesh_data can then be fed into the GPU for rendering.
+ * Frees the retired chunks, unless another thread is using chunks right now,
+ * in which case they're freed during a later call. The caller holds worldGenerationMutex.
  */
-void World::generateChunk(int32_t x, int32_t z)
+void World::freeRetiredChunks()
 {
-    worldGenerationMutex.lock();
+    if ( retiredChunks.empty())
+        return;
 
-    // Check if the chunk already exists
-    if ( chunkMap->find(chunk_hash(x, z)) != chunkMap->end()) {
-        worldGenerationMutex.unlock();
+    std::unique_lock<std::shared_mutex> lifetimeLock(chunkLifetimeMutex, std::try_to_lock);
+    if ( !lifetimeLock.owns_lock())
         return;
+    for ( chunk_t *chunk: retiredChunks )
+        freeChunk(chunk);
+    retiredChunks.clear();
+
+    // The decoded height maps cached by chunk may now belong to another chunk at the same address
+    heightMapRevision++;
+}
+
+/*
+ * Add a generated chunk to the world, after the chunk listener has had the chance to follow it.
+ */
+void World::addChunk(chunk_t *chunk)
+{
+    if ( chunkListener )
+        chunkListener->onChunkAdded(chunk);
+    chunk->revision = ++chunkRevision;
+
+    size_t hash = chunk_hash((int32_t) ( chunk->x / CHUNK_COORDINATE_SCALING_FACTOR ),
+                             (int32_t) ( chunk->z / CHUNK_COORDINATE_SCALING_FACTOR ));
+    {
+        std::lock_guard<std::mutex> lock(worldGenerationMutex);
+        chunkMap->insert({ hash, chunk });
+        pendingChunks.erase(hash);
     }
+}
 
-    worldGenerationMutex.unlock();
-    auto *data_points = (float *) malloc(sizeof(float) * CHUNK_SIZE * CHUNK_SIZE);
+chunk_t *World::findChunk(int32_t x, int32_t z)
+{
+    std::lock_guard<std::mutex> lock(worldGenerationMutex);
+    auto entry = chunkMap->find(chunk_hash(x, z));
+    return entry == chunkMap->end() ? nullptr : entry->second;
+}
 
-    int32_t chunk_x, chunk_z, i, j;
+void World::decodeHeightMap(chunk_t *chunk, float *heights)
+{
+    const uint16_t *quantized = chunk->height_map;
+    if ( !quantized ) {
+        static thread_local uint16_t decoded[ CHUNK_SIZE * CHUNK_SIZE ];
+        HeightMapCodec::decode(chunk->cold_height_map, chunk->cold_height_map_size, CHUNK_SIZE * CHUNK_SIZE,
+                               CHUNK_SIZE, decoded);
+        quantized = decoded;
+    }
+    HeightMapCodec::dequantize(quantized, CHUNK_SIZE * CHUNK_SIZE, chunk->height_map_minimum,
+                               chunk->height_map_scale, heights);
+}
+
+bool World::getChunkHeights(int32_t x, int32_t z, float *heights)
+{
+    std::shared_lock<std::shared_mutex> lifetimeLock(chunkLifetimeMutex);
+    chunk_t *chunk = findChunk(x, z);
+    if ( !chunk )
+        return false;
+
+    std::shared_lock<std::shared_mutex> lock(heightMapMutex);
+    decodeHeightMap(chunk, heights);
+    return true;
+}
 
-    float cx, cy, cz;
+bool World::readLoadedCellHeight(int32_t x, int32_t z, float &height)
+{
+    int32_t originX = (int32_t) std::floor((float) x / CHUNK_SIZE) * CHUNK_SIZE;
+    int32_t originZ = (int32_t) std::floor((float) z / CHUNK_SIZE) * CHUNK_SIZE;
+    int index = ( x - originX ) * CHUNK_SIZE + ( z - originZ );
 
-    // Memory for Mesh
-    int mesh_width = CHUNK_SIZE + 1;
-    const int indices_count = CHUNK_SIZE * CHUNK_SIZE * 6;
+    // The last decoded cold height map is kept, as queries tend to hit the same chunk
+    static thread_local chunk_t *cachedChunk = nullptr;
+    static thread_local unsigned long cachedRevision = 0;
+    static thread_local float cachedHeights[ CHUNK_SIZE * CHUNK_SIZE ];
 
-    int top_left, bottom_left, top_right, bottom_right;
+    chunk_t *chunk = findChunk(originX, originZ);
+    if ( !chunk )
+        return false;
 
-    int indices_index = 0;
-    int vertices_index = 0;
+    std::shared_lock<std::shared_mutex> lock(heightMapMutex);
+    if ( chunk->height_map ) {
+        height = HeightMapCodec::dequantize(chunk->height_map[ index ], chunk->height_map_minimum,
+                                            chunk->height_map_scale);
+        return true;
+    }
+    if ( chunk != cachedChunk || cachedRevision != heightMapRevision ) {
+        decodeHeightMap(chunk, cachedHeights);
+        cachedChunk = chunk;
+        cachedRevision = heightMapRevision;
+    }
+    height = cachedHeights[ index ];
+    return true;
+}
 
-    // Vector chunk_mesh_data that will be passed to the main thread.
-    auto *indices = (unsigned int *) malloc(sizeof(unsigned int) * indices_count);
-    auto *vertices = (vertex_t *) malloc(sizeof(vertex_t) * mesh_width * mesh_width);
+bool World::getLoadedCellHeight(int32_t x, int32_t z, float &height)
+{
+    std::shared_lock<std::shared_mutex> lifetimeLock(chunkLifetimeMutex);
+    return readLoadedCellHeight(x, z, height);
+}
+
+float World::getCellHeight(int32_t x, int32_t z)
+{
+    int32_t originX = (int32_t) std::floor((float) x / CHUNK_SIZE) * CHUNK_SIZE;
+    int32_t originZ = (int32_t) std::floor((float) z / CHUNK_SIZE) * CHUNK_SIZE;
+    int index = ( x - originX ) * CHUNK_SIZE + ( z - originZ );
+
+    std::shared_lock<std::shared_mutex> lifetimeLock(chunkLifetimeMutex);
+    float height;
+    if ( readLoadedCellHeight(x, z, height))
+        return height;
+
+    // Likewise for the last few chunks read from the save, as the apron of a chunk alternates
+    // between its neighbours. Stored chunks only change while they're loaded, in which case
+    // they're found in the chunk map instead, so the entries are dropped when chunks are evicted.
+    static thread_local int32_t storedX[ 4 ] = { INT32_MAX, INT32_MAX, INT32_MAX, INT32_MAX };
+    static thread_local int32_t storedZ[ 4 ];
+    static thread_local bool stored[ 4 ];
+    static thread_local float storedHeights[ 4 ][ CHUNK_SIZE * CHUNK_SIZE ];
+    static thread_local int storedNext = 0;
+    static thread_local unsigned long storedRevision = 0;
+    if ( storage ) {
+        if ( storedRevision != evictionRevision ) {
+            std::fill(storedX, storedX + 4, INT32_MAX);
+            storedRevision = evictionRevision;
+        }
+        int entry = 0;
+        while ( entry < 4 && ( storedX[ entry ] != originX || storedZ[ entry ] != originZ ))
+            entry++;
+        if ( entry == 4 ) {
+            entry = storedNext;
+            storedNext = ( storedNext + 1 ) % 4;
+
+            uint16_t quantized[ CHUNK_SIZE * CHUNK_SIZE ];
+            float minimum, scale;
+            stored[ entry ] = storage->readChunk(originX, originZ, quantized, minimum, scale);
+            if ( stored[ entry ] )
+                HeightMapCodec::dequantize(quantized, CHUNK_SIZE * CHUNK_SIZE, minimum, scale, storedHeights[ entry ]);
+            storedX[ entry ] = originX;
+            storedZ[ entry ] = originZ;
+        }
+        if ( stored[ entry ] )
+            return storedHeights[ entry ][ index ];
+    }
 
-    glm::vec3 normal;
+    return TerrainGenerator::getHeight(((float) x - 0.5f ) * CHUNK_COORDINATE_SCALING_FACTOR,
+                                       ((float) z - 0.5f ) * CHUNK_COORDINATE_SCALING_FACTOR);
+}
 
-    float delta = 0.5f;
+float World::getHeightAt(float x, float z)
+{
+    // The samples of a chunk at (x, z) lie at ((x + i) - 0.5) * CHUNK_COORDINATE_SCALING_FACTOR
+    float cellX = x / CHUNK_COORDINATE_SCALING_FACTOR + 0.5f;
+    float cellZ = z / CHUNK_COORDINATE_SCALING_FACTOR + 0.5f;
+    auto baseX = (int32_t) std::floor(cellX);
+    auto baseZ = (int32_t) std::floor(cellZ);
 
-    // Generate height chunk_mesh_data points
-    for ( i = 0; i <= CHUNK_SIZE; i++ ) {
-        for ( j = 0; j <= CHUNK_SIZE; j++ ) {
-            // Calculate height for chunk at specific coordinate
-            chunk_x = x + i;
-            chunk_z = z + j;
-            cx = (((float) chunk_x ) - delta ) * CHUNK_COORDINATE_SCALING_FACTOR;
-            cz = (((float) chunk_z ) - delta ) * CHUNK_COORDINATE_SCALING_FACTOR;
-            cy = getChunkHeight(cx, cz);
+    float samples[ 4 ];
+    for ( int corner = 0; corner < 4; corner++ )
+        samples[ corner ] = getCellHeight(baseX + ( corner & 1 ), baseZ + ( corner >> 1 ));
 
-            normal = getNormalVector(cx, cz);
-            // Add regular vertex
-            vertices[ vertices_index++ ] = {
-                    cx, cy, cz,
-                    normal.x, normal.y, normal.z
-            };
+    float fractionX = cellX - (float) baseX;
+    float fractionZ = cellZ - (float) baseZ;
+    return glm::mix(glm::mix(samples[ 0 ], samples[ 1 ], fractionX),
+                    glm::mix(samples[ 2 ], samples[ 3 ], fractionX), fractionZ);
+}
 
-            // Generate indices for the Mesh
-            if ( i < CHUNK_SIZE && j < CHUNK_SIZE) {
+void World::updateHeightMapTiers(glm::vec3 center)
+{
+    // Collect the chunks first, so the chunk map isn't locked while coding
+    std::shared_lock<std::shared_mutex> lifetimeLock(chunkLifetimeMutex);
+    std::vector<chunk_t *> chunks;
+    {
+        std::lock_guard<std::mutex> lock(worldGenerationMutex);
+        chunks.reserve(chunkMap->size());
+        for ( auto chunkPair: *chunkMap )
+            chunks.push_back(chunkPair.second);
+    }
 
-                data_points[ i * CHUNK_SIZE + j ] = cy;
+    float limit = CHUNK_HEIGHT_MAP_COLD_DISTANCE * CHUNK_COORDINATE_SCALAR;
+    std::vector<uint8_t> encoded;
+    for ( chunk_t *chunk: chunks ) {
+        bool cold = std::abs((float) chunk->x - center.x) > limit || std::abs((float) chunk->z - center.z) > limit;
 
-                top_left = i * mesh_width + j;
-                bottom_left = ( i + 1 ) * mesh_width + j;
-                top_right = i * mesh_width + ( j + 1 );
-                bottom_right = ( i + 1 ) * mesh_width + ( j + 1 );
+        // Coded under a shared lock, so terrain edits can't change the height map meanwhile.
+        // If one happened before the exclusive lock is taken, the chunk is moved during the next update instead.
+        std::shared_lock<std::shared_mutex> readLock(heightMapMutex);
+        unsigned long revision = heightMapRevision;
+        if ( cold && chunk->height_map ) {
+            HeightMapCodec::encode(chunk->height_map, CHUNK_SIZE * CHUNK_SIZE, CHUNK_SIZE, encoded);
+            readLock.unlock();
+            auto *coldHeightMap = (uint8_t *) SizeClassAllocator::allocate(encoded.size());
+            memcpy(coldHeightMap, encoded.data(), encoded.size());
 
-                indices[ indices_index++ ] = top_left;
-                indices[ indices_index++ ] = top_right;
-                indices[ indices_index++ ] = bottom_left;
+            std::unique_lock<std::shared_mutex> lock(heightMapMutex);
+            if ( revision != heightMapRevision ) {
+                SizeClassAllocator::release(coldHeightMap, encoded.size());
+                continue;
+            }
+            heightMapPool->release(chunk->height_map);
+            chunk->height_map = nullptr;
+            chunk->cold_height_map = coldHeightMap;
+            chunk->cold_height_map_size = (uint32_t) encoded.size();
+            heightMapRevision++;
+        } else if ( !cold && chunk->cold_height_map ) {
+            auto *heightMap = (uint16_t *) heightMapPool->allocate();
+            HeightMapCodec::decode(chunk->cold_height_map, chunk->cold_height_map_size, CHUNK_SIZE * CHUNK_SIZE,
+                                   CHUNK_SIZE, heightMap);
+            readLock.unlock();
 
-                indices[ indices_index++ ] = top_right;
-                indices[ indices_index++ ] = bottom_right;
-                indices[ indices_index++ ] = bottom_left;
+            std::unique_lock<std::shared_mutex> lock(heightMapMutex);
+            if ( revision != heightMapRevision ) {
+                heightMapPool->release(heightMap);
+                continue;
             }
+            SizeClassAllocator::release(chunk->cold_height_map, chunk->cold_height_map_size);
+            chunk->height_map = heightMap;
+            chunk->cold_height_map = nullptr;
+            chunk->cold_height_map_size = 0;
+            heightMapRevision++;
         }
     }
+}
 
-    // Create chunk object
-    auto *generated = (chunk_t *) malloc(sizeof(chunk_t));
-    generated->height_map = data_points;
-    generated->x = x * CHUNK_COORDINATE_SCALING_FACTOR;
-    generated->z = z * CHUNK_COORDINATE_SCALING_FACTOR;
+void World::editTerrain(terrain_edit_t edit)
+{
+    if ( edit.radius <= 0.0f )
+        return;
+    std::lock_guard<std::mutex> lock(terrainEditMutex);
+    pendingTerrainEdits.push_back(edit);
+}
 
-    // Store chunk_mesh_data in destination. The memory can be freed
-    // after the Mesh has been generated.
-    auto *chunk_mesh_data = (immature_chunk_data_t *) malloc(sizeof(immature_chunk_data_t));
-    chunk_mesh_data->mesh_data = (vbo_data_t *) malloc(sizeof(vbo_data_t));
-    chunk_mesh_data->mesh_data->indices = indices;
-    chunk_mesh_data->mesh_data->vertices = vertices;
-    chunk_mesh_data->mesh_data->indices_count = indices_count;
-    chunk_mesh_data->mesh_data->vertices_count = mesh_width * mesh_width;
-    chunk_mesh_data->chunk = generated;
+void World::raiseTerrain(float x, float z, float radius, float amount)
+{
+    editTerrain({ TERRAIN_EDIT_RAISE, x, z, radius, amount });
+}
 
-    // Add to Mesh generation queue
-    chunkMeshGenerationQueue->push(chunk_mesh_data);
+void World::lowerTerrain(float x, float z, float radius, float amount)
+{
+    editTerrain({ TERRAIN_EDIT_LOWER, x, z, radius, amount });
 }
 
-World::~World()
+void World::flattenTerrain(float x, float z, float radius, float height)
 {
-    // Delete content of queue
-    immature_chunk_data_t *data;
+    editTerrain({ TERRAIN_EDIT_FLATTEN, x, z, radius, height });
+}
 
-    // Clear all memory from the queue
-    while ( !chunkMeshGenerationQueue->empty()) {
-        data = chunkMeshGenerationQueue->front();
-        free(data->mesh_data->indices);
-        free(data->mesh_data->vertices);
-        free(data->mesh_data);
-        free(data->chunk);
-        chunkMeshGenerationQueue->pop();
+/**
+ * A loaded chunk changed by the terrain edits of a frame, with the rectangle of samples that changed.
+ */
+typedef struct {
+    chunk_t *chunk;
+    int32_t x;
+    int32_t z;
+    int32_t min_i, min_j, max_i, max_j;
+} edited_chunk_t;
+
+void World::applyTerrainEdits()
+{
+    static thread_local std::vector<terrain_edit_t> edits;
+    {
+        std::lock_guard<std::mutex> lock(terrainEditMutex);
+        if ( pendingTerrainEdits.empty())
+            return;
+        edits.swap(pendingTerrainEdits);
     }
 
-    // Clear the chunk map
-    for ( auto entry: *chunkMap ) {
-        free(entry.second->height_map);
-        delete entry.second->mesh;
-        free(entry.second);
+    // All edits of the frame are applied to the decoded heights first,
+    // so every chunk is only quantized and uploaded once.
+    static thread_local std::vector<float> editedHeights;
+    static thread_local std::vector<float> originalHeights;
+    std::vector<edited_chunk_t> editedChunks;
+    for ( terrain_edit_t &edit: edits ) {
+        auto minX = (int32_t) std::ceil(( edit.x - edit.radius ) / CHUNK_COORDINATE_SCALING_FACTOR + 0.5f);
+        auto maxX = (int32_t) std::floor(( edit.x + edit.radius ) / CHUNK_COORDINATE_SCALING_FACTOR + 0.5f);
+        auto minZ = (int32_t) std::ceil(( edit.z - edit.radius ) / CHUNK_COORDINATE_SCALING_FACTOR + 0.5f);
+        auto maxZ = (int32_t) std::floor(( edit.z + edit.radius ) / CHUNK_COORDINATE_SCALING_FACTOR + 0.5f);
+        int32_t firstX = (int32_t) std::floor((float) minX / CHUNK_SIZE) * CHUNK_SIZE;
+        int32_t firstZ = (int32_t) std::floor((float) minZ / CHUNK_SIZE) * CHUNK_SIZE;
+
+        for ( int32_t originX = firstX; originX <= maxX; originX += CHUNK_SIZE ) {
+            for ( int32_t originZ = firstZ; originZ <= maxZ; originZ += CHUNK_SIZE ) {
+                // Only the loaded chunks can be edited
+                size_t index = 0;
+                while ( index < editedChunks.size() &&
+                        ( editedChunks[ index ].x != originX || editedChunks[ index ].z != originZ ))
+                    index++;
+                if ( index == editedChunks.size()) {
+                    chunk_t *chunk = findChunk(originX, originZ);
+                    if ( !chunk )
+                        continue;
+                    editedHeights.resize(( index + 1 ) * CHUNK_SIZE * CHUNK_SIZE);
+                    originalHeights.resize(( index + 1 ) * CHUNK_SIZE * CHUNK_SIZE);
+                    getChunkHeights(originX, originZ, &editedHeights[ index * CHUNK_SIZE * CHUNK_SIZE ]);
+                    memcpy(&originalHeights[ index * CHUNK_SIZE * CHUNK_SIZE ],
+                           &editedHeights[ index * CHUNK_SIZE * CHUNK_SIZE ], sizeof(float) * CHUNK_SIZE * CHUNK_SIZE);
+                    editedChunks.push_back({ chunk, originX, originZ, CHUNK_SIZE, CHUNK_SIZE, -1, -1 });
+                }
+                edited_chunk_t &edited = editedChunks[ index ];
+                float *heights = &editedHeights[ index * CHUNK_SIZE * CHUNK_SIZE ];
+
+                for ( int32_t i = std::max(minX - originX, 0); i <= std::min(maxX - originX, CHUNK_SIZE - 1); i++ ) {
+                    for ( int32_t j = std::max(minZ - originZ, 0); j <= std::min(maxZ - originZ, CHUNK_SIZE - 1); j++ ) {
+                        float dx = ((float) ( originX + i ) - 0.5f ) * CHUNK_COORDINATE_SCALING_FACTOR - edit.x;
+                        float dz = ((float) ( originZ + j ) - 0.5f ) * CHUNK_COORDINATE_SCALING_FACTOR - edit.z;
+                        float distance = std::sqrt(dx * dx + dz * dz);
+                        if ( distance > edit.radius )
+                            continue;
+
+                        float weight = 0.5f + 0.5f * std::cos((float) M_PI * distance / edit.radius);
+                        float &height = heights[ i * CHUNK_SIZE + j ];
+                        if ( edit.type == TERRAIN_EDIT_RAISE )
+                            height += edit.amount * weight;
+                        else if ( edit.type == TERRAIN_EDIT_LOWER )
+                            height -= edit.amount * weight;
+                        else
+                            height = glm::mix(height, edit.amount, weight);
+
+                        edited.min_i = std::min(edited.min_i, i);
+                        edited.min_j = std::min(edited.min_j, j);
+                        edited.max_i = std::max(edited.max_i, i);
+                        edited.max_j = std::max(edited.max_j, j);
+                    }
+                }
+            }
+        }
     }
+    edits.clear();
+
+    // Store the new heights, cold chunks are moved back into the resident tier
+    uint16_t quantized[ CHUNK_SIZE * CHUNK_SIZE ];
+    for ( size_t index = 0; index < editedChunks.size(); index++ ) {
+        edited_chunk_t &edited = editedChunks[ index ];
+        if ( edited.max_i < 0 )
+            continue;
+
+        // The edited heights are replaced by what's stored, so they can stand in for the height map below
+        float minimum, scale;
+        HeightMapCodec::quantize(&editedHeights[ index * CHUNK_SIZE * CHUNK_SIZE ], CHUNK_SIZE * CHUNK_SIZE,
+                                 quantized, minimum, scale);
+        HeightMapCodec::dequantize(quantized, CHUNK_SIZE * CHUNK_SIZE, minimum, scale,
+                                   &editedHeights[ index * CHUNK_SIZE * CHUNK_SIZE ]);
+
+        std::unique_lock<std::shared_mutex> lock(heightMapMutex);
+        chunk_t *chunk = edited.chunk;
+        if ( !chunk->height_map ) {
+            chunk->height_map = (uint16_t *) heightMapPool->allocate();
+            SizeClassAllocator::release(chunk->cold_height_map, chunk->cold_height_map_size);
+            chunk->cold_height_map = nullptr;
+            chunk->cold_height_map_size = 0;
+        }
+        memcpy(chunk->height_map, quantized, sizeof(quantized));
+        chunk->height_map_minimum = minimum;
+        chunk->height_map_scale = scale;
+        chunk->dirty = true;
+        heightMapRevision++;
+    }
+
+    // A sample is part of the grid of its own chunk, and of the last row or column of the chunks before it.
+    // The normals of the surrounding vertices change as well, so the rectangle is widened by one.
+    // The listener is told about the samples one vertex beyond the grid too, where the apron of a height grid lies.
+    int32_t lower = -1;
+    int32_t upper = CHUNK_SIZE + 1;
+    std::vector<edited_chunk_t> chunkChanges;
+    for ( edited_chunk_t &edited: editedChunks ) {
+        if ( edited.max_i < 0 )
+            continue;
+
+        for ( int32_t originX = edited.x - CHUNK_SIZE; originX <= edited.x + CHUNK_SIZE; originX += CHUNK_SIZE ) {
+            for ( int32_t originZ = edited.z - CHUNK_SIZE; originZ <= edited.z + CHUNK_SIZE; originZ += CHUNK_SIZE ) {
+                int32_t minI = std::max(edited.x + edited.min_i - 1 - originX, lower);
+                int32_t maxI = std::min(edited.x + edited.max_i + 1 - originX, upper);
+                int32_t minJ = std::max(edited.z + edited.min_j - 1 - originZ, lower);
+                int32_t maxJ = std::min(edited.z + edited.max_j + 1 - originZ, upper);
+                if ( minI > maxI || minJ > maxJ )
+                    continue;
+
+                size_t index = 0;
+                while ( index < chunkChanges.size() &&
+                        ( chunkChanges[ index ].x != originX || chunkChanges[ index ].z != originZ ))
+                    index++;
+                if ( index == chunkChanges.size()) {
+                    chunk_t *chunk = findChunk(originX, originZ);
+                    if ( !chunk )
+                        continue;
+                    chunkChanges.push_back({ chunk, originX, originZ, minI, minJ, maxI, maxJ });
+                    continue;
+                }
+                edited_chunk_t &update = chunkChanges[ index ];
+                update.min_i = std::min(update.min_i, minI);
+                update.min_j = std::min(update.min_j, minJ);
+                update.max_i = std::max(update.max_i, maxI);
+                update.max_j = std::max(update.max_j, maxJ);
+            }
+        }
+    }
+
+    // The samples of the edited chunks are taken from the edited heights, only those of the chunks
+    // around them are looked up in the world.
+    auto findEdited = [&](int32_t x, int32_t z) {
+        int32_t originX = (int32_t) std::floor((float) x / CHUNK_SIZE) * CHUNK_SIZE;
+        int32_t originZ = (int32_t) std::floor((float) z / CHUNK_SIZE) * CHUNK_SIZE;
+        for ( size_t index = 0; index < editedChunks.size(); index++ )
+            if ( editedChunks[ index ].x == originX && editedChunks[ index ].z == originZ )
+                return &editedHeights[ index * CHUNK_SIZE * CHUNK_SIZE + ( x - originX ) * CHUNK_SIZE +
+                                       ( z - originZ ) ];
+        return (float *) nullptr;
+    };
+    auto sampleAt = [&](int32_t x, int32_t z) {
+        float *height = findEdited(x, z);
+        return height ? *height : getCellHeight(x, z);
+    };
+
+    static thread_local std::vector<float> changedHeights;
+    float chunkHeights[ CHUNK_SIZE * CHUNK_SIZE ];
+    for ( edited_chunk_t &update: chunkChanges ) {
+        chunk_t *chunk = update.chunk;
+
+        // The heights of the rectangle, with a border of one sample for the normals
+        int32_t width = update.max_i - update.min_i + 3;
+        int32_t depth = update.max_j - update.min_j + 3;
+        changedHeights.resize(width * depth);
+        for ( int32_t i = 0; i < width; i++ )
+            for ( int32_t j = 0; j < depth; j++ )
+                changedHeights[ i * depth + j ] = sampleAt(update.x + update.min_i + i - 1,
+                                                           update.z + update.min_j + j - 1);
+
+        // Keep the bounds used for culling and shadows up to date. Only the grid samples within the rectangle
+        // moved, so they widen the bounds. All samples are only visited again when the lowest or the highest
+        // sample might have moved inward.
+        float minHeight = chunk->grid_min_height;
+        float maxHeight = chunk->grid_max_height;
+        bool rescan = false;
+        for ( int32_t i = std::max(update.min_i, 0); i <= std::min(update.max_i, CHUNK_SIZE); i++ ) {
+            for ( int32_t j = std::max(update.min_j, 0); j <= std::min(update.max_j, CHUNK_SIZE); j++ ) {
+                float *edited = findEdited(update.x + i, update.z + j);
+                if ( !edited )
+                    continue;
+                float before = originalHeights[ edited - editedHeights.data() ];
+                float after = *edited;
+                if (( before <= chunk->grid_min_height && after > before ) ||
+                    ( before >= chunk->grid_max_height && after < before ))
+                    rescan = true;
+                minHeight = std::min(minHeight, after);
+                maxHeight = std::max(maxHeight, after);
+            }
+        }
+        if ( rescan ) {
+            float *ownHeights = findEdited(update.x, update.z);
+            if ( !ownHeights ) {
+                getChunkHeights(update.x, update.z, chunkHeights);
+                ownHeights = chunkHeights;
+            }
+            minHeight = INFINITY;
+            maxHeight = -INFINITY;
+            for ( int32_t i = 0; i <= CHUNK_SIZE; i++ ) {
+                for ( int32_t j = 0; j <= CHUNK_SIZE; j++ ) {
+                    float height = i < CHUNK_SIZE && j < CHUNK_SIZE ? ownHeights[ i * CHUNK_SIZE + j ]
+                                                                    : sampleAt(update.x + i, update.z + j);
+                    minHeight = std::min(minHeight, height);
+                    maxHeight = std::max(maxHeight, height);
+                }
+            }
+        }
+        setHeightBounds(chunk, minHeight, maxHeight);
+
+        // Keep the vegetation on the ground
+        for ( uint32_t i = 0; i < chunk->vegetation_count; i++ ) {
+            vegetation_instance_t &instance = chunk->vegetation[ i ];
+            instance.y = getHeightAt(instance.x, instance.z);
+        }
+        chunk->revision = ++chunkRevision;
+
+        if ( chunkListener )
+            chunkListener->onChunkChanged(chunk, update.min_i, update.min_j, update.max_i, update.max_j,
+                                          changedHeights.data());
+    }
+}
+
+void World::update(float deltaTime)
+{
+    for ( Entity *entities: *worldObjects ) {
+        entities->update(deltaTime);
+    }
+    if ( observationPoint ) {
+        std::lock_guard<std::mutex> lock(observedPositionMutex);
+        observedPosition = observationPoint->position;
+    }
+
+    // Hand a consistent copy of the entities to the autosave thread
+    if ( entitySnapshotRequested.exchange(false)) {
+        std::lock_guard<std::mutex> lock(autosaveMutex);
+        snapshotEntities(entitySnapshot);
+        entitySnapshotReady = true;
+        autosaveCondition.notify_all();
+    }
+}
+
+/**
+ * A chunk read from the save or received from the chunk server, instead of generated.
+ */
+typedef struct {
+    bool loaded;
+    float minimum, scale;
+    uint16_t height_map[ CHUNK_SIZE * CHUNK_SIZE ];
+} loaded_chunk_t;
+
+/**
+ * A rectangle of generated heights, see World::generateChunks.
+ */
+typedef struct {
+    int32_t x, z;       // The first cell
+    int32_t width, depth;
+    size_t offset;      // Where its heights start, sample (i, j) is at [offset + i * depth + j]
+} height_grid_t;
+
+chunk_t *World::generateChunk(int32_t x, int32_t z)
+{
+    glm::ivec2 chunk(x, z);
+    chunk_t *generated;
+    generateChunks(&chunk, 1, &generated);
+    return generated;
+}
+
+/*
+ * Generate the chunks at the given coordinates.
+ * The heights of all chunks that aren't loaded are generated as a single grid, covering them
+ * and the first samples of their neighbours, and then sliced into the chunks. Chunks that are
+ * requested together (see `requestChunks`) lie in the same region, which keeps the grid compact.
+ * When loaded chunks take up most of that grid, each generated chunk gets a grid of its own instead.
+ * The vegetation is placed per chunk, after which the chunk listener gets the heights of the
+ * grid of the chunk to build its own data from, like a mesh.
+ */
+void World::generateChunks(const glm::ivec2 *chunks, size_t count, chunk_t **generated)
+{
+    // Chunks that have been saved before are loaded instead of generated
+    static thread_local std::vector<loaded_chunk_t> loadedChunks;
+    loadedChunks.resize(count);
+    for ( size_t k = 0; k < count; k++ ) {
+        loaded_chunk_t &loaded = loadedChunks[ k ];
+        loaded.loaded = storage && storage->readChunk(chunks[ k ].x, chunks[ k ].y, loaded.height_map,
+                                                      loaded.minimum, loaded.scale);
+    }
+
+    // The chunk server is asked for the others when there is one, all in a single round trip
+    if ( chunkClient ) {
+        static thread_local std::vector<size_t> fetchIndices;
+        static thread_local std::vector<glm::ivec2> fetchChunks;
+        static thread_local std::vector<chunk_fetch_result_t> fetchResults;
+        fetchIndices.clear();
+        fetchChunks.clear();
+        fetchResults.clear();
+        for ( size_t k = 0; k < count; k++ ) {
+            if ( loadedChunks[ k ].loaded )
+                continue;
+            fetchIndices.push_back(k);
+            fetchChunks.push_back(chunks[ k ]);
+            fetchResults.push_back({ loadedChunks[ k ].height_map, 0, 0, false });
+        }
+        if ( !fetchChunks.empty() &&
+             chunkClient->fetch(fetchChunks.data(), fetchChunks.size(), fetchResults.data()) > 0 ) {
+            for ( size_t f = 0; f < fetchIndices.size(); f++ ) {
+                loaded_chunk_t &loaded = loadedChunks[ fetchIndices[ f ]];
+                loaded.loaded = fetchResults[ f ].fetched;
+                loaded.minimum = fetchResults[ f ].minimum;
+                loaded.scale = fetchResults[ f ].scale;
+            }
+        }
+    }
+
+    int32_t boxX = INT32_MAX, boxZ = INT32_MAX, boxEndX = INT32_MIN, boxEndZ = INT32_MIN;
+    size_t generatedCount = 0;
+    for ( size_t k = 0; k < count; k++ ) {
+        int32_t x = chunks[ k ].x, z = chunks[ k ].y;
+        if ( loadedChunks[ k ].loaded )
+            continue;
+        boxX = std::min(boxX, x);
+        boxZ = std::min(boxZ, z);
+        boxEndX = std::max(boxEndX, x + CHUNK_SIZE + 1);
+        boxEndZ = std::max(boxEndZ, z + CHUNK_SIZE + 1);
+        generatedCount++;
+    }
+
+    // The generated heights, including the first row and column of the neighbouring chunks.
+    // A single grid over the bounding box shares the biome calculations between the chunks,
+    // unless more than half of the box would be spent on loaded chunks.
+    static thread_local std::vector<height_grid_t> grids;
+    static thread_local std::vector<int> chunkGrids; // The grid of every chunk, -1 when it was loaded
+    static thread_local std::vector<float> gridHeights;
+    grids.clear();
+    chunkGrids.assign(count, -1);
+    if ( generatedCount > 0 ) {
+        size_t chunkCells = ( CHUNK_SIZE + 1 ) * ( CHUNK_SIZE + 1 );
+        size_t boxCells = (size_t) ( boxEndX - boxX ) * ( boxEndZ - boxZ );
+        bool singleGrid = boxCells <= 2 * generatedCount * chunkCells;
+        if ( singleGrid )
+            grids.push_back({ boxX, boxZ, boxEndX - boxX, boxEndZ - boxZ, 0 });
+        for ( size_t k = 0; k < count; k++ ) {
+            if ( loadedChunks[ k ].loaded )
+                continue;
+            if ( !singleGrid )
+                grids.push_back({ chunks[ k ].x, chunks[ k ].y, CHUNK_SIZE + 1, CHUNK_SIZE + 1,
+                                  grids.size() * chunkCells });
+            chunkGrids[ k ] = (int) grids.size() - 1;
+        }
+        gridHeights.resize(singleGrid ? boxCells : grids.size() * chunkCells);
+        for ( height_grid_t &grid: grids )
+            TerrainGenerator::getHeights(grid.x, grid.z, grid.width, grid.depth, &gridHeights[ grid.offset ]);
+    }
+    auto generatedHeight = [](int gridIndex, int32_t x, int32_t z) {
+        if ( gridIndex >= 0 ) {
+            const height_grid_t &grid = grids[ gridIndex ];
+            return gridHeights[ grid.offset + ( x - grid.x ) * grid.depth + ( z - grid.z ) ];
+        }
+        return TerrainGenerator::getHeight(((float) x - 0.5f ) * CHUNK_COORDINATE_SCALING_FACTOR,
+                                           ((float) z - 0.5f ) * CHUNK_COORDINATE_SCALING_FACTOR);
+    };
+    auto findInBatch = [chunks, count](int32_t x, int32_t z) {
+        for ( size_t k = 0; k < count; k++ )
+            if ( chunks[ k ].x == x && chunks[ k ].y == z )
+                return (int) k;
+        return -1;
+    };
+
+    for ( size_t k = 0; k < count; k++ ) {
+        int32_t x = chunks[ k ].x, z = chunks[ k ].y;
+        loaded_chunk_t &loaded = loadedChunks[ k ];
+        float data_points[ CHUNK_SIZE * CHUNK_SIZE ];
+
+        // The grid of the chunk, including the first samples of the neighbouring chunks
+        int grid_width = CHUNK_SIZE + 1;
+        float heights[ ( CHUNK_SIZE + 1 ) * ( CHUNK_SIZE + 1 ) ];
+
+        // The neighbours that own the last row, the last column and the last sample, when they're in this batch
+        int neighbours[ 3 ] = { findInBatch(x + CHUNK_SIZE, z), findInBatch(x, z + CHUNK_SIZE),
+                                findInBatch(x + CHUNK_SIZE, z + CHUNK_SIZE) };
+
+        float min_height = INFINITY;
+        float max_height = -INFINITY;
+
+        if ( loaded.loaded )
+            HeightMapCodec::dequantize(loaded.height_map, CHUNK_SIZE * CHUNK_SIZE, loaded.minimum, loaded.scale,
+                                       data_points);
+
+        for ( int32_t i = 0; i <= CHUNK_SIZE; i++ ) {
+            for ( int32_t j = 0; j <= CHUNK_SIZE; j++ ) {
+                float cy;
+                // The last row and column belong to the neighbouring chunks. Those in this batch are read
+                // from what was loaded or generated for them, the others might have been saved or edited.
+                if ( i == CHUNK_SIZE || j == CHUNK_SIZE ) {
+                    int owner = neighbours[ ( i == CHUNK_SIZE ? 1 : 0 ) + ( j == CHUNK_SIZE ? 2 : 0 ) - 1 ];
+                    if ( owner >= 0 && loadedChunks[ owner ].loaded ) {
+                        const loaded_chunk_t &neighbour = loadedChunks[ owner ];
+                        cy = HeightMapCodec::dequantize(
+                                neighbour.height_map[ ( i % CHUNK_SIZE ) * CHUNK_SIZE + j % CHUNK_SIZE ],
+                                neighbour.minimum, neighbour.scale);
+                    } else if ( owner >= 0 ) {
+                        cy = generatedHeight(chunkGrids[ owner ], x + i, z + j);
+                    } else {
+                        // Loaded neighbours might have been edited, getCellHeight generates the others
+                        cy = getCellHeight(x + i, z + j);
+                    }
+                } else if ( loaded.loaded ) {
+                    cy = data_points[ i * CHUNK_SIZE + j ];
+                } else {
+                    data_points[ i * CHUNK_SIZE + j ] = cy = generatedHeight(chunkGrids[ k ], x + i, z + j);
+                }
+                min_height = std::min(min_height, cy);
+                max_height = std::max(max_height, cy);
+                heights[ i * grid_width + j ] = cy;
+            }
+        }
+
+        // Create chunk object
+        auto *chunk = (chunk_t *) chunkPool->allocate();
+        chunk->listener_data = nullptr;
+        chunk->height_map = (uint16_t *) heightMapPool->allocate();
+        chunk->cold_height_map = nullptr;
+        chunk->cold_height_map_size = 0;
+        if ( loaded.loaded ) {
+            memcpy(chunk->height_map, loaded.height_map, sizeof(loaded.height_map));
+            chunk->height_map_minimum = loaded.minimum;
+            chunk->height_map_scale = loaded.scale;
+        } else {
+            HeightMapCodec::quantize(data_points, CHUNK_SIZE * CHUNK_SIZE, chunk->height_map,
+                                     chunk->height_map_minimum, chunk->height_map_scale);
+        }
+        chunk->dirty = !loaded.loaded;
+        chunk->x = x * CHUNK_COORDINATE_SCALING_FACTOR;
+        chunk->z = z * CHUNK_COORDINATE_SCALING_FACTOR;
+
+        // Place the vegetation, copied into a compactly sized buffer that lives as long as the chunk
+        static thread_local std::vector<vegetation_instance_t> vegetation;
+        vegetation.clear();
+        Vegetation::scatter(x, z, heights, vegetation);
+        chunk->vegetation_count = (uint32_t) vegetation.size();
+        chunk->vegetation = (vegetation_instance_t *) SizeClassAllocator::allocate(
+                sizeof(vegetation_instance_t) * vegetation.size());
+        memcpy(chunk->vegetation, vegetation.data(), sizeof(vegetation_instance_t) * vegetation.size());
+
+        setHeightBounds(chunk, min_height, max_height);
+
+        if ( chunkListener )
+            chunkListener->onChunkGenerated(chunk, heights, loaded.loaded);
+        chunk->timestamps = {};
+        chunk->timestamps.generated = ChunkPipelineStats::now();
+        generated[ k ] = chunk;
+    }
+}
+
+World::~World()
+{
+    stopWorldGeneration();
+    delete generationJobs;
+    delete chunkClient;
+
+    if ( autosaveThread ) {
+        {
+            std::lock_guard<std::mutex> lock(autosaveMutex);
+            autosaving = false;
+        }
+        autosaveCondition.notify_all();
+        autosaveThread->join();
+        delete autosaveThread;
+    }
+    delete storage;
+
+    // The chunks waiting to be added free their data instead
+    chunkUploads.resume(-1);
+
+    // Clear the chunk map, and the evicted chunks that haven't been freed yet
+    for ( auto entry: *chunkMap )
+        freeChunk(entry.second);
+    for ( chunk_t *chunk: removedChunks )
+        freeChunk(chunk);
+    for ( chunk_t *chunk: retiredChunks )
+        freeChunk(chunk);
 
-    drawables->clear();
     worldObjects->clear();
     chunkMap->clear();
-    if ( worldGenerationThread )
-        worldGenerationThread->detach();
 
     delete worldGenerationThread;
-    delete drawables;
+    delete chunkPool;
+    delete heightMapPool;
     delete worldObjects;
     delete chunkMap;
-}
\ No newline at end of file
+}
@@ -7,29 +7,109 @@
 
 #include <thread>
 #include <queue>
-#include "../rendering/renderer.h"
+#include <atomic>
+#include <unordered_set>
+#include <unordered_map>
+#include <shared_mutex>
+#include <condition_variable>
+#include <functional>
+#include <glm/glm.hpp>
+#include "../math/transformation.h"
 #include "entity/entity.h"
-#include "entity/player.h"
-#include "../rendering/culling/frustum.h"
-#include "../rendering/vbo.h"
+#include "../threading/job_system.h"
+#include "../threading/task.h"
+#include "../threading/main_thread_scheduler.h"
+#include "../memory/slab_pool.h"
+#include "vegetation.h"
+#include "chunk_listener.h"
+#include "chunk_pipeline_stats.h"
+#include "world_storage.h"
+#include "../net/chunk_client.h"
 
 #define CHUNK_RENDER_DISTANCE (20)
-#define CHUNK_DRAW_DISTANCE (15)
+#define CHUNK_DRAW_DISTANCE (15) // The initial draw distance, in chunks
+#define CHUNK_UPLOAD_BUDGET (2) // The initial amount of chunks added to the world per frame
+// Chunks requested together are generated per region of this many chunks along each side
+#define WORLD_GENERATION_REGION_SIZE (4)
+#define WORLD_GENERATION_REGION_CHUNKS (WORLD_GENERATION_REGION_SIZE * WORLD_GENERATION_REGION_SIZE)
+#define CHUNK_GENERATION_WORKER_COUNT (2) // The initial amount of chunk generation workers
 #define CHUNK_SIZE (64)
 #define CHUNK_BASE_WATER_LEVEL (10.0f)
 #define CHUNK_COORDINATE_SCALING_FACTOR (20.0f)
 #define CHUNK_COORDINATE_SCALAR (CHUNK_COORDINATE_SCALING_FACTOR * CHUNK_SIZE)
 
+#define CHUNK_POOL_BLOCKS_PER_SLAB (64)
+
+// Chunks further away than this, in chunks, keep their height map in the compressed cold tier
+#define CHUNK_HEIGHT_MAP_COLD_DISTANCE (6)
+// The amount of world generation iterations, of about 10 ms, between two tier updates
+#define CHUNK_HEIGHT_MAP_TIER_UPDATE_INTERVAL (100)
+
+// Chunks further than the draw distance plus this margin, in chunks, are removed from the world
+#define CHUNK_EVICTION_MARGIN (2)
+
+// The interval between two autosaves of the changed chunks and the entities, in seconds
+#define WORLD_AUTOSAVE_INTERVAL (30)
+
+// The interval between two logs of the chunk pipeline stats when they're enabled, in seconds
+#define WORLD_PIPELINE_STATS_INTERVAL (10)
+
 #define CHUNK_GENERATION_MAX_HEIGHT (25)
-#define CHUNK_BIOME_COUNT (5)
+#define CHUNK_BIOME_COUNT (5) // See TerrainGenerator::BIOMES
 #define CHUNK_GENERATION_NORMAL_DELTA (0.1f)
 
+// Vertices below the water level are displaced by the waves in the vertex shader,
+// the bounds of chunks with water are extended by this amount.
+#define CHUNK_WAVE_HEIGHT_MARGIN (64.0f)
+
+// Terrain edits, see World::editTerrain
+#define TERRAIN_EDIT_RAISE (0)
+#define TERRAIN_EDIT_LOWER (1)
+#define TERRAIN_EDIT_FLATTEN (2)
+
+/**
+ * A change to the height of the terrain within a radius, falling off smoothly towards the edge.
+ */
+typedef struct {
+    unsigned char type;
+    float x;            // The world space center
+    float z;
+    float radius;
+    float amount;       // The height change at the center, or the height to flatten to
+} terrain_edit_t;
+
 typedef struct chunk_t {
-    VBO *mesh;
-    float *height_map; // Size is always CHUNK_SIZE^2
+    // The height map, CHUNK_SIZE^2 samples quantized by HeightMapCodec. Read through World::getChunkHeights.
+    uint16_t *height_map;           // nullptr while the chunk is in the cold tier
+    uint8_t *cold_height_map;       // The delta and Rice coded height map in the cold tier, nullptr otherwise
+    uint32_t cold_height_map_size;
+    float height_map_minimum;
+    float height_map_scale;
+    bool dirty;                     // Whether the height map changed since it was saved, guarded by World::heightMapMutex
     int32_t x;
     int32_t z;
 
+    // The vertical bounds of the chunk
+    float min_height;
+    float max_height;
+
+    // The lowest and highest sample of the grid of the chunk, without the margin for the waves
+    float grid_min_height;
+    float grid_max_height;
+
+    // The value of World::chunkRevision at the time this chunk was added
+    unsigned long revision;
+
+    // Vegetation placed on this chunk during generation
+    vegetation_instance_t *vegetation;
+    uint32_t vegetation_count;
+
+    // Owned by the ChunkListener of the world, for example the GPU resources of the chunk
+    void *listener_data;
+
+    // When the chunk passed through the stages of the pipeline, see World::pipelineStats
+    chunk_timestamps_t timestamps;
+
     // For checking whether the chunk is the same.
     // This is always the case if the coordinates are the same due
     // to how world generation works.
@@ -39,11 +119,23 @@ typedef struct chunk_t {
     }
 } chunk_t;
 
+/**
+ * The chunks requested in a region, in the order in which they were requested.
+ * Fixed in size so a region is passed around without allocating, it lives in the
+ * (pooled) frame of the coroutine generating it.
+ */
 typedef struct {
-    vbo_data_t *mesh_data;
-    chunk_t *chunk;
-} immature_chunk_data_t;
+    int32_t region_x;
+    int32_t region_z;
+    glm::ivec2 chunks[WORLD_GENERATION_REGION_CHUNKS];
+    size_t count;
+} generation_region_t;
 
+/**
+ * The world model: the chunks around an observation point, their generation and storage, and the entities.
+ * Doesn't use OpenGL or GLFW, so it also runs headless. Rendering is done by a WorldRenderer,
+ * which follows the chunks through the ChunkListener interface.
+ */
 class World
 {
 
@@ -53,25 +145,169 @@ private:
      * This thread is responsible for performing all the calculations
      * regarding the chunk generation.
      */
-    std::thread *worldGenerationThread;
+    std::thread *worldGenerationThread = nullptr;
 
     /**
      * Mutex for locking the generation of chunkMap to prevent
-     * duplicate chunk generation.
+     * duplicate chunk generation. Guards the lookups in and insertions
+     * into the chunk map, and the pending chunks.
      */
     std::mutex worldGenerationMutex;
 
     /**
-     * The queue of chunkMap that need their meshes to be generated.e
+     * The hashes of the chunks that have been requested, but haven't been added to the chunk map yet.
+     */
+    std::unordered_set<std::size_t> pendingChunks;
+
+    /**
+     * The workers that generate the requested chunks.
+     */
+    JobSystem *generationJobs = nullptr;
+
+    /**
+     * The chunk streaming coroutines waiting to add their chunk to the world.
+     * Resumed by `applyChanges`, up to the upload budget per call.
+     */
+    MainThreadScheduler chunkUploads;
+
+    /**
+     * The point around which chunks are generated.
+     * Only read by the thread updating the entities, the other threads read `observedPosition`.
+     */
+    Transformation *observationPoint = nullptr;
+
+    /**
+     * The position of the observation point, copied after every entity update.
+     */
+    mutable std::mutex observedPositionMutex;
+    glm::vec3 observedPosition = glm::vec3(0.0f);
+
+    /**
+     * The chunks that were removed from the chunk map during the last eviction, and the chunks
+     * of which the chunk listener has been told, which are freed once no other thread uses them.
+     * Guarded by worldGenerationMutex.
+     */
+    std::vector<chunk_t *> removedChunks;
+    std::vector<chunk_t *> retiredChunks;
+
+    /** Set when the chunks outside the draw distance should be removed during the next `applyChanges` */
+    std::atomic<bool> evictionRequested = false;
+
+    /** Incremented every time a chunk is evicted */
+    std::atomic<unsigned long> evictionRevision = 0;
+
+    /**
+     * Held shared by the threads that use chunks without holding worldGenerationMutex,
+     * the retired chunks are only freed while it's held exclusively.
+     */
+    std::shared_mutex chunkLifetimeMutex;
+
+    /**
+     * Removes the chunks outside the draw distance from the chunk map, and frees the chunks
+     * that were removed before. Chunks with changes that haven't been saved yet stay until they are.
+     */
+    void evictChunks();
+
+    void freeRetiredChunks();
+
+    /**
+     * Receives the changes to the chunks, nullptr when nothing follows them.
      */
-    std::queue<immature_chunk_data_t *> *chunkMeshGenerationQueue;
+    ChunkListener *chunkListener = nullptr;
 
     /**
-     * The location where the last chunk generation was performed.
-     * This is used to determine when the chunk generation thread should
-     * continue generating chunks depending on the distance of the player to this point.
+     * Generates the requested chunks of a region on a generation worker, and adds them
+     * to the world one by one during the following calls to `applyChanges`.
      */
-    glm::vec3 lastGenerationPoint;
+    Task<void> streamRegion(generation_region_t region, double requested);
+
+    /**
+     * Adds a generated chunk to the chunk map.
+     */
+    void addChunk(chunk_t *chunk);
+
+    /**
+     * Frees the memory of a chunk.
+     */
+    void freeChunk(chunk_t *chunk);
+
+    /**
+     * Pools for the memory of chunks, all sizes are fixed by CHUNK_SIZE.
+     * The chunk_t and height map live as long as the chunk.
+     */
+    SlabPool *chunkPool = nullptr;
+    SlabPool *heightMapPool = nullptr;
+
+    void createPools();
+
+    /**
+     * Guards the height maps of the chunks against moving between tiers while they're read.
+     */
+    std::shared_mutex heightMapMutex;
+
+    /** Incremented every time a height map moves between tiers */
+    std::atomic<unsigned long> heightMapRevision = 0;
+
+    /**
+     * Decodes the height map of a chunk, the caller has to hold heightMapMutex.
+     */
+    void decodeHeightMap(chunk_t *chunk, float *heights);
+
+    chunk_t *findChunk(int32_t x, int32_t z);
+
+    /**
+     * `getLoadedCellHeight`, for callers that already hold chunkLifetimeMutex.
+     */
+    bool readLoadedCellHeight(int32_t x, int32_t z, float &height);
+
+    /**
+     * The terrain edits made since the last frame, applied together by `applyTerrainEdits`.
+     */
+    std::mutex terrainEditMutex;
+    std::vector<terrain_edit_t> pendingTerrainEdits;
+
+    /**
+     * Applies the pending terrain edits to the height maps of the loaded chunks,
+     * and tells the chunk listener which parts of the chunks changed.
+     */
+    void applyTerrainEdits();
+
+    /**
+     * The save the chunks are loaded from and saved to, nullptr when the world isn't saved.
+     */
+    WorldStorage *storage = nullptr;
+
+    /**
+     * The chunk server the height maps of new chunks are fetched from, nullptr when they're generated locally.
+     */
+    ChunkClient *chunkClient = nullptr;
+
+    /**
+     * Saves the changed chunks and the entities every WORLD_AUTOSAVE_INTERVAL seconds.
+     */
+    std::thread *autosaveThread = nullptr;
+    std::mutex autosaveMutex;
+    std::condition_variable autosaveCondition;
+    bool autosaving = false;
+
+    /**
+     * The state of the entities, copied by `update` when the autosave thread requests it,
+     * so the entities don't have to be read while they're being updated.
+     */
+    std::vector<world_storage_entity_t> entitySnapshot;
+    std::atomic<bool> entitySnapshotRequested = false;
+    bool entitySnapshotReady = false; // Guarded by autosaveMutex
+
+    void snapshotEntities(std::vector<world_storage_entity_t> &snapshot) const;
+
+    /**
+     * Writes the chunks that changed since they were last saved.
+     * @return The amount of chunks written
+     */
+    int saveChunks();
+
+    friend void worldAutosaveFn(World *world);
+    friend void worldGenerationFn(World *world, Transformation *observationPoint);
 
 public:
 
@@ -88,30 +324,55 @@ public:
     static glm::vec4 skyBottomColor;
     static glm::vec4 skyTopColor;
 
+    /**
+     * Whether the chunk memory pools are backed by huge pages, when the OS provides them.
+     * This has to be set before the world generation is started.
+     */
+    static bool hugePagePools;
+
+    /**
+     * The interval between two logs of `pipelineStats` to the standard output, in seconds.
+     * 0 disables the periodic log.
+     */
+    static int pipelineStatsInterval;
 
 public:
+    /**
+     * The loaded chunks. Only changed by `applyChanges`, so the thread calling it can
+     * read the map without locking, as can threads it hands work to in between.
+     */
     std::unordered_map<std::size_t, chunk_t *> *chunkMap;
     std::vector<Entity *> *worldObjects;
-    std::vector<Drawable *> *drawables;
 
     /**
-     * Chunk generation octaves.
-     * These octaves are a set of two numbers, the first one indicating the coordinate dividing
-     * factor, the second one the height factor.
-     * CHUNK_GENERATION_OCTAVES[0] - The coordinate scaling factor for which to retrieve the noise for
-     * CHUNK_GENERATION_OCTAVES[1] - The height multiplier
+     * Incremented every time a chunk is added to the chunk map or changed.
+     * This can be used to check whether cached renderings of the world are outdated.
      */
-    static constexpr float CHUNK_GENERATION_OCTAVES[][2] = {
-            { 500, 30 },
-            { 100,   1 },
-            /*{ 4,   .1 },*/
-            /*{ 1,   .005 }*/
-    };
+    unsigned long chunkRevision = 0;
+
     /**
-     * The biome height scaling factors.
-     * These factors are used to scale the height of the terrain based on the biome.
+     * Whether the world generation thread should keep running.
      */
-    static constexpr float BIOME_HEIGHT_SCALING_FACTORS[CHUNK_BIOME_COUNT] = { 0.5f, 0.7f, 1.0f, 1.2f, 1.3f };
+    std::atomic<bool> generating = false;
+
+    /**
+     * The distance up to which chunks are generated and drawn, in chunks.
+     * Can be changed at runtime, for example by the FrameGovernor.
+     */
+    std::atomic<int> drawDistance = CHUNK_DRAW_DISTANCE;
+
+    /**
+     * The maximum amount of generated chunks that are added to the world per call to `applyChanges`.
+     */
+    int uploadBudget = CHUNK_UPLOAD_BUDGET;
+
+    /**
+     * How long the chunks took from being requested to being drawn, per stage.
+     * The stages up to the upload are recorded by the world, the first draw by the renderer.
+     */
+    ChunkPipelineStats pipelineStats;
+
+    World();
 
     /**
      * Destructor
@@ -120,24 +381,164 @@ public:
 
     void startWorldGeneration(Transformation *observationPoint);
 
-    void render(float deltaTime, Frustum *frustum);
+    /**
+     * Generates the chunks within the draw distance of the observation point on all cores,
+     * and adds them to the world, so the first frame shows the full terrain. Blocks until all chunks are added.
+     * The chunk listener is notified on the calling thread, so this has to be called from the thread
+     * that calls `applyChanges`, before the world generation is started.
+     *
+     * @param progress Called after every batch of added chunks, with the amount added so far and the total
+     */
+    void warmStart(Transformation *observationPoint, const std::function<void(size_t, size_t)> &progress = nullptr);
+
+    /**
+     * Stops requesting and generating chunks, and waits for the generation workers to finish.
+     * The chunks that were generated but not added yet are discarded by the destructor.
+     */
+    void stopWorldGeneration();
+
+    /**
+     * Sets the listener that follows the changes to the chunks.
+     * This has to be set before the world generation is started, or after it has been stopped.
+     */
+    void setChunkListener(ChunkListener *listener);
+
+    /**
+     * Adds the generated chunks to the world, up to the upload budget, and applies the pending terrain edits.
+     * Must be called regularly from a single thread, while no other thread iterates the chunk map.
+     * The chunk listener is notified on this thread.
+     */
+    void applyChanges();
+
+    /**
+     * Updates the entities of the world.
+     */
+    void update(float deltaTime);
+
+    /**
+     * Get the position of the observation point as of the last entity update.
+     * Safe to call from any thread.
+     */
+    glm::vec3 getObservedPosition() const;
+
+    /**
+     * Whether a chunk, in height map cells, lies within the draw distance of the provided point.
+     */
+    bool isWithinDrawDistance(int32_t x, int32_t z, glm::vec3 center) const;
+
+    /**
+     * Get the heights of a chunk, decoded from its resident or cold height map.
+     * Safe to call from any thread.
+     *
+     * @param x The x coordinate of the chunk, in height map cells
+     * @param z The z coordinate of the chunk, in height map cells
+     * @param heights The destination of the CHUNK_SIZE^2 heights
+     * @return Whether the chunk exists
+     */
+    bool getChunkHeights(int32_t x, int32_t z, float *heights);
 
-    void update(float deltaTime) const;
+    /**
+     * Get the height of a single height map sample, only when it lies in a loaded chunk.
+     * Unlike `getCellHeight` this never reads the save, so it's cheap enough to call for samples far away.
+     * Safe to call from any thread.
+     *
+     * @param x The x coordinate of the sample, in height map cells
+     * @param z The z coordinate of the sample, in height map cells
+     * @param height Set to the height of the sample, when it's loaded
+     * @return Whether the sample lies in a loaded chunk
+     */
+    bool getLoadedCellHeight(int32_t x, int32_t z, float &height);
 
     /**
-     * Function for generating a chunk at a certain position.
+     * Get the height of a single height map sample, from a loaded chunk, the save or the terrain generator.
+     * Safe to call from any thread.
      *
-     * @param position The location to startWorldGeneration the chunk at.
-     * @return
+     * @param x The x coordinate of the sample, in height map cells
+     * @param z The z coordinate of the sample, in height map cells
+     */
+    float getCellHeight(int32_t x, int32_t z);
+
+    /**
+     * Get the height of the terrain at a world space coordinate, interpolated between the
+     * height map samples of the loaded chunks. Outside the loaded chunks the terrain generator is sampled.
+     * Safe to call from any thread.
      */
-    void generateChunk(int32_t x, int32_t z);
+    float getHeightAt(float x, float z);
 
     /**
-     * Function for generating the Mesh for a chunk.
+     * Moves the height maps of chunks further than CHUNK_HEIGHT_MAP_COLD_DISTANCE from
+     * the provided point into the cold tier, and those within it back into the resident tier.
+     */
+    void updateHeightMapTiers(glm::vec3 center);
+
+    /**
+     * Changes the height of the terrain of the loaded chunks, see terrain_edit_t.
+     * Safe to call from any thread. The edits made between two calls to `applyChanges` are applied together.
+     */
+    void editTerrain(terrain_edit_t edit);
+
+    void raiseTerrain(float x, float z, float radius, float amount);
+
+    void lowerTerrain(float x, float z, float radius, float amount);
+
+    void flattenTerrain(float x, float z, float radius, float height);
+
+    /**
+     * Loads and saves the world from and to the provided directory.
+     * Chunks that are stored are loaded instead of generated, as they're streamed in
+     * around the observation point. The terrain generator takes the seed of the save.
+     * This has to be called before the world generation is started.
+     */
+    void openStorage(const char *directory);
+
+    /**
+     * Fetches the height maps of new chunks from the chunk server listening on the provided socket,
+     * instead of generating them. When the server can't be reached, or generates another seed, the chunks
+     * are generated locally. The current seed is sent along, so this has to be called after `openStorage`,
+     * and before the world generation is started.
+     */
+    void connectChunkServer(const char *socketPath);
+
+    /**
+     * Restores the stored state of the provided entities, matched by their order.
+     * @return Whether any entities were stored
+     */
+    bool loadEntities(const std::vector<Entity *> &entities);
+
+    /**
+     * Saves the changed chunks and the entities right away, and waits until they're written.
+     */
+    void save();
+
+    /**
+     * Changes the amount of workers that generate chunks.
+     */
+    void setGenerationWorkerCount(int workerCount);
+
+    int getGenerationWorkerCount();
+
+    /**
+     * Requests chunks to be generated by the generation workers, except for the ones that
+     * already exist or have been requested before. The chunks are grouped by region, and the
+     * requested chunks of a region are generated together, in the order the regions first
+     * appear in the requests.
+     * Requests that fall outside the draw distance by the time
+     * a worker picks them up are dropped.
+     */
+    void requestChunks(const std::vector<glm::ivec2> &chunks);
+
+    void requestChunk(int32_t x, int32_t z);
+
+    /**
+     * Function for generating chunks at certain positions, in height map cells.
+     * Chunks should be requested through `requestChunks`, which prevents duplicate generation.
+     * Can be called from any thread.
      *
-     * @param chunk The chunk to startWorldGeneration the Mesh for.
+     * @param generated Set to the generated chunks, which still have to be added to the world.
      */
-    void generateChunkMesh(chunk_t *chunk, vbo_data_t *vbo_data) const;
+    void generateChunks(const glm::ivec2 *chunks, size_t count, chunk_t **generated);
+
+    chunk_t *generateChunk(int32_t x, int32_t z);
 };
 
 
@@ -0,0 +1,304 @@
+//
+// Created by Luca Warmenhoven on 17/10/2026.
+//
+
+#include "world_storage.h"
+#include "height_map_codec.h"
+#include <filesystem>
+#include <iostream>
+#include <cmath>
+
+WorldStorage::WorldStorage(const char *directory, int chunkSize)
+{
+    this->directory = directory;
+    this->chunkSize = chunkSize;
+
+    std::error_code error;
+    std::filesystem::create_directories(this->directory, error);
+    if ( error )
+        std::cerr << "Failed to create the save directory " << directory << ": " << error.message() << std::endl;
+    this->readWorldFile();
+}
+
+WorldStorage::~WorldStorage()
+{
+    for ( auto region: this->regions )
+        fclose(region.second);
+}
+
+/**
+ * Opens a region file, creating it with an empty offset table when requested.
+ * The caller has to hold the mutex.
+ */
+FILE *WorldStorage::openRegion(int32_t regionX, int32_t regionZ, bool create)
+{
+    uint64_t key = ((uint64_t) (uint32_t) regionX << 32 ) | (uint32_t) regionZ;
+    auto open = this->regions.find(key);
+    if ( open != this->regions.end())
+        return open->second;
+
+    std::string path = this->directory + "/r." + std::to_string(regionX) + "." + std::to_string(regionZ) + ".dat";
+    FILE *file = fopen(path.c_str(), "r+b");
+    world_storage_region_header_t header;
+
+    if ( file ) {
+        if ( fread(&header, sizeof(header), 1, file) != 1 || header.magic != WORLD_STORAGE_REGION_MAGIC ||
+             header.version != WORLD_STORAGE_VERSION || header.region_size != WORLD_STORAGE_REGION_SIZE ||
+             header.chunk_size != (uint32_t) this->chunkSize ) {
+            std::cerr << "Region file " << path << " is incompatible, it's ignored." << std::endl;
+            fclose(file);
+            return nullptr;
+        }
+    } else {
+        if ( !create )
+            return nullptr;
+        file = fopen(path.c_str(), "w+b");
+        if ( !file ) {
+            std::cerr << "Failed to create region file " << path << std::endl;
+            return nullptr;
+        }
+        header = { WORLD_STORAGE_REGION_MAGIC, WORLD_STORAGE_VERSION, WORLD_STORAGE_REGION_SIZE,
+                   (uint32_t) this->chunkSize };
+        world_storage_region_entry_t table[ WORLD_STORAGE_REGION_SIZE * WORLD_STORAGE_REGION_SIZE ] = {};
+        fwrite(&header, sizeof(header), 1, file);
+        fwrite(table, sizeof(table), 1, file);
+    }
+
+    // Keep a bounded amount of files open, regions are mostly accessed around the player
+    if ( this->regions.size() >= WORLD_STORAGE_MAX_OPEN_REGIONS ) {
+        for ( auto region: this->regions )
+            fclose(region.second);
+        this->regions.clear();
+    }
+    this->regions[ key ] = file;
+    return file;
+}
+
+/**
+ * Get the region of a chunk, and the offset of its entry in the offset table of the region file.
+ */
+static void locateChunk(int32_t x, int32_t z, int chunkSize, int32_t &regionX, int32_t &regionZ, long &entryOffset)
+{
+    auto chunkX = (int32_t) std::floor((float) x / (float) chunkSize);
+    auto chunkZ = (int32_t) std::floor((float) z / (float) chunkSize);
+    regionX = (int32_t) std::floor((float) chunkX / WORLD_STORAGE_REGION_SIZE);
+    regionZ = (int32_t) std::floor((float) chunkZ / WORLD_STORAGE_REGION_SIZE);
+    int index = ( chunkX - regionX * WORLD_STORAGE_REGION_SIZE ) * WORLD_STORAGE_REGION_SIZE +
+                ( chunkZ - regionZ * WORLD_STORAGE_REGION_SIZE );
+    entryOffset = (long) ( sizeof(world_storage_region_header_t) + index * sizeof(world_storage_region_entry_t));
+}
+
+bool WorldStorage::writeChunk(int32_t x, int32_t z, const uint16_t *quantized, float minimum, float scale)
+{
+    // Encode before locking, so other threads can keep reading and writing in the meantime
+    static thread_local std::vector<uint8_t> encoded;
+    int sampleCount = this->chunkSize * this->chunkSize;
+    HeightMapCodec::encode(quantized, sampleCount, this->chunkSize, encoded);
+    world_storage_chunk_header_t chunkHeader = { x, z, minimum, scale, (uint32_t) encoded.size() };
+    uint32_t size = (uint32_t) ( sizeof(chunkHeader) + encoded.size());
+
+    int32_t regionX, regionZ;
+    long entryOffset;
+    locateChunk(x, z, this->chunkSize, regionX, regionZ, entryOffset);
+
+    std::lock_guard<std::mutex> lock(this->mutex);
+    FILE *file = this->openRegion(regionX, regionZ, true);
+    if ( !file )
+        return false;
+
+    world_storage_region_entry_t entry;
+    fseek(file, entryOffset, SEEK_SET);
+    if ( fread(&entry, sizeof(entry), 1, file) != 1 )
+        return false;
+
+    // Rewrite the record in place when it fits, append it to the file otherwise
+    if ( entry.offset == 0 || entry.capacity < size ) {
+        fseek(file, 0, SEEK_END);
+        entry.offset = (uint32_t) ftell(file);
+        entry.capacity = size;
+    }
+    entry.size = size;
+
+    fseek(file, entry.offset, SEEK_SET);
+    bool written = fwrite(&chunkHeader, sizeof(chunkHeader), 1, file) == 1 &&
+                   fwrite(encoded.data(), encoded.size(), 1, file) == 1;
+
+    // The entry is only updated once the record is complete
+    if ( written ) {
+        fseek(file, entryOffset, SEEK_SET);
+        written = fwrite(&entry, sizeof(entry), 1, file) == 1;
+    }
+    return written;
+}
+
+bool WorldStorage::readChunk(int32_t x, int32_t z, uint16_t *quantized, float &minimum, float &scale)
+{
+    int32_t regionX, regionZ;
+    long entryOffset;
+    locateChunk(x, z, this->chunkSize, regionX, regionZ, entryOffset);
+
+    static thread_local std::vector<uint8_t> encoded;
+    world_storage_chunk_header_t chunkHeader;
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        FILE *file = this->openRegion(regionX, regionZ, false);
+        if ( !file )
+            return false;
+
+        world_storage_region_entry_t entry;
+        fseek(file, entryOffset, SEEK_SET);
+        if ( fread(&entry, sizeof(entry), 1, file) != 1 || entry.offset == 0 )
+            return false;
+
+        fseek(file, entry.offset, SEEK_SET);
+        if ( fread(&chunkHeader, sizeof(chunkHeader), 1, file) != 1 ||
+             chunkHeader.x != x || chunkHeader.z != z ||
+             sizeof(chunkHeader) + chunkHeader.encoded_size != entry.size )
+            return false;
+
+        encoded.resize(chunkHeader.encoded_size);
+        if ( fread(encoded.data(), encoded.size(), 1, file) != 1 )
+            return false;
+    }
+
+    // Decoded without holding the lock, a corrupt chunk is treated as if it was never saved
+    if ( !HeightMapCodec::decode(encoded.data(), encoded.size(), this->chunkSize * this->chunkSize,
+                                 this->chunkSize, quantized)) {
+        std::cerr << "Chunk (" << x << ", " << z << ") in " << this->directory << " is corrupt." << std::endl;
+        return false;
+    }
+    minimum = chunkHeader.minimum;
+    scale = chunkHeader.scale;
+    return true;
+}
+
+bool WorldStorage::hasChunk(int32_t x, int32_t z)
+{
+    int32_t regionX, regionZ;
+    long entryOffset;
+    locateChunk(x, z, this->chunkSize, regionX, regionZ, entryOffset);
+
+    std::lock_guard<std::mutex> lock(this->mutex);
+    FILE *file = this->openRegion(regionX, regionZ, false);
+    if ( !file )
+        return false;
+
+    world_storage_region_entry_t entry;
+    fseek(file, entryOffset, SEEK_SET);
+    return fread(&entry, sizeof(entry), 1, file) == 1 && entry.offset != 0;
+}
+
+bool WorldStorage::writeWorldFile()
+{
+    // Written to a temporary file first, so a crash while saving never leaves a broken world file behind
+    std::string path = this->directory + "/world.dat";
+    std::string temporaryPath = path + ".tmp";
+    FILE *file = fopen(temporaryPath.c_str(), "wb");
+    if ( !file ) {
+        std::cerr << "Failed to write " << temporaryPath << std::endl;
+        return false;
+    }
+
+    uint32_t header[ 2 ] = { WORLD_STORAGE_WORLD_MAGIC, WORLD_STORAGE_VERSION };
+    bool written = fwrite(header, sizeof(header), 1, file) == 1;
+    if ( this->hasSeed ) {
+        uint32_t section[ 2 ] = { WORLD_STORAGE_SECTION_SEED, sizeof(this->seed) };
+        written = written && fwrite(section, sizeof(section), 1, file) == 1 &&
+                  fwrite(&this->seed, sizeof(this->seed), 1, file) == 1;
+    }
+    if ( this->hasEntities ) {
+        uint32_t entityCount = (uint32_t) this->entities.size();
+        uint32_t section[ 2 ] = { WORLD_STORAGE_SECTION_ENTITIES,
+                                  (uint32_t) ( sizeof(entityCount) + entityCount * sizeof(world_storage_entity_t)) };
+        written = written && fwrite(section, sizeof(section), 1, file) == 1 &&
+                  fwrite(&entityCount, sizeof(entityCount), 1, file) == 1 &&
+                  ( entityCount == 0 ||
+                    fwrite(this->entities.data(), sizeof(world_storage_entity_t), entityCount, file) == entityCount );
+    }
+    written = fclose(file) == 0 && written;
+
+    std::error_code error;
+    if ( written )
+        std::filesystem::rename(temporaryPath, path, error);
+    return written && !error;
+}
+
+void WorldStorage::readWorldFile()
+{
+    std::string path = this->directory + "/world.dat";
+    FILE *file = fopen(path.c_str(), "rb");
+    if ( !file )
+        return;
+
+    uint32_t header[ 2 ];
+    if ( fread(header, sizeof(header), 1, file) == 1 && header[ 0 ] == WORLD_STORAGE_WORLD_MAGIC &&
+         header[ 1 ] <= WORLD_STORAGE_VERSION ) {
+        // A section is followed by the next one at its start plus its length, whatever the version that
+        // wrote it appended to the sections this version knows
+        uint32_t section[ 2 ];
+        while ( fread(section, sizeof(section), 1, file) == 1 ) {
+            long start = ftell(file);
+            if ( section[ 0 ] == WORLD_STORAGE_SECTION_SEED ) {
+                this->hasSeed = section[ 1 ] >= sizeof(this->seed) &&
+                                fread(&this->seed, sizeof(this->seed), 1, file) == 1;
+                if ( !this->hasSeed )
+                    break;
+            } else if ( section[ 0 ] == WORLD_STORAGE_SECTION_ENTITIES ) {
+                uint32_t entityCount;
+                if ( section[ 1 ] < sizeof(entityCount) || fread(&entityCount, sizeof(entityCount), 1, file) != 1 ||
+                     entityCount > ( section[ 1 ] - sizeof(entityCount)) / sizeof(world_storage_entity_t))
+                    break;
+                this->entities.resize(entityCount);
+                this->hasEntities = entityCount == 0 ||
+                                    fread(this->entities.data(), sizeof(world_storage_entity_t), entityCount, file) ==
+                                    entityCount;
+                if ( !this->hasEntities ) {
+                    this->entities.clear();
+                    break;
+                }
+            }
+            if ( fseek(file, start + (long) section[ 1 ], SEEK_SET) != 0 )
+                break;
+        }
+    }
+    fclose(file);
+}
+
+bool WorldStorage::writeEntities(const std::vector<world_storage_entity_t> &entities)
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->entities = entities;
+    this->hasEntities = true;
+    return this->writeWorldFile();
+}
+
+bool WorldStorage::readEntities(std::vector<world_storage_entity_t> &entities)
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+    if ( !this->hasEntities )
+        return false;
+    entities = this->entities;
+    return true;
+}
+
+bool WorldStorage::writeSeed(uint32_t seed)
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->seed = seed;
+    this->hasSeed = true;
+    return this->writeWorldFile();
+}
+
+bool WorldStorage::readSeed(uint32_t &seed)
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+    seed = this->seed;
+    return this->hasSeed;
+}
+
+void WorldStorage::flush()
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+    for ( auto region: this->regions )
+        fflush(region.second);
+}
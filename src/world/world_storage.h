@@ -0,0 +1,145 @@
+//
+// Created by Luca Warmenhoven on 17/10/2026.
+//
+
+#ifndef GRAPHICS_TEST_WORLD_STORAGE_H
+#define GRAPHICS_TEST_WORLD_STORAGE_H
+
+#include <cstdio>
+#include <cstdint>
+#include <string>
+#include <mutex>
+#include <vector>
+#include <unordered_map>
+#include <glm/glm.hpp>
+
+#define WORLD_STORAGE_VERSION (1)
+#define WORLD_STORAGE_WORLD_MAGIC (0x44575447) // "GTWD"
+#define WORLD_STORAGE_REGION_MAGIC (0x47525447) // "GTRG"
+
+// The amount of chunks along each side of a region file
+#define WORLD_STORAGE_REGION_SIZE (16)
+#define WORLD_STORAGE_MAX_OPEN_REGIONS (16)
+
+// The sections of the world file, sections with an unknown type are skipped when loading
+#define WORLD_STORAGE_SECTION_ENTITIES (1)
+#define WORLD_STORAGE_SECTION_SEED (2)
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t region_size;
+    uint32_t chunk_size;
+} world_storage_region_header_t;
+
+/**
+ * Where a chunk is stored in a region file. An offset of 0 means the chunk isn't stored.
+ */
+typedef struct {
+    uint32_t offset;
+    uint32_t size;
+    uint32_t capacity; // The space available at the offset, the record is moved to the end of the file if it grows beyond it
+} world_storage_region_entry_t;
+
+typedef struct {
+    int32_t x;          // In height map cells
+    int32_t z;
+    float minimum;      // The quantization of the height map, see HeightMapCodec
+    float scale;
+    uint32_t encoded_size;
+} world_storage_chunk_header_t;
+
+typedef struct {
+    glm::vec3 position;
+    glm::vec3 velocity;
+    glm::vec3 rotation;
+} world_storage_entity_t;
+
+/**
+ * Reads and writes a world save, stored in a directory.
+ *
+ * Chunks are stored in region files of WORLD_STORAGE_REGION_SIZE^2 chunks, each starting with an
+ * offset table, so a single chunk can be read or rewritten without touching the rest of the file.
+ * The height maps are stored in their compressed cold tier encoding.
+ * The entities and the terrain seed are stored in a separate world file made of typed sections,
+ * which is read when the storage is opened, and replaced atomically when it's written.
+ *
+ * All methods are safe to call from any thread.
+ */
+class WorldStorage
+{
+
+private:
+
+    std::string directory;
+    int chunkSize;
+
+    /** The open region files, guarded by mutex */
+    std::unordered_map<uint64_t, FILE *> regions;
+    std::mutex mutex;
+
+    /** The contents of the world file, guarded by mutex */
+    std::vector<world_storage_entity_t> entities;
+    bool hasEntities = false;
+    uint32_t seed = 0;
+    bool hasSeed = false;
+
+    FILE *openRegion(int32_t regionX, int32_t regionZ, bool create);
+
+    void readWorldFile();
+
+    /**
+     * Replaces the world file with the current contents, the caller has to hold the mutex.
+     */
+    bool writeWorldFile();
+
+public:
+
+    /**
+     * @param directory The directory of the save, created when it doesn't exist
+     * @param chunkSize The amount of height map samples along each side of a chunk
+     */
+    WorldStorage(const char *directory, int chunkSize);
+
+    ~WorldStorage();
+
+    /**
+     * Stores the quantized height map of a chunk, replacing the previously stored one.
+     * @param x The x coordinate of the chunk, in height map cells
+     * @param z The z coordinate of the chunk, in height map cells
+     * @return Whether the chunk was written
+     */
+    bool writeChunk(int32_t x, int32_t z, const uint16_t *quantized, float minimum, float scale);
+
+    /**
+     * Reads the quantized height map of a chunk.
+     * @return Whether the chunk is stored
+     */
+    bool readChunk(int32_t x, int32_t z, uint16_t *quantized, float &minimum, float &scale);
+
+    /**
+     * Whether a chunk is stored, without reading it.
+     */
+    bool hasChunk(int32_t x, int32_t z);
+
+    bool writeEntities(const std::vector<world_storage_entity_t> &entities);
+
+    bool readEntities(std::vector<world_storage_entity_t> &entities);
+
+    /**
+     * Stores the seed of the terrain of the save, see TerrainGenerator::setSeed.
+     */
+    bool writeSeed(uint32_t seed);
+
+    /**
+     * @return Whether the save has a seed
+     */
+    bool readSeed(uint32_t &seed);
+
+    /**
+     * Flushes the written chunks to the OS.
+     */
+    void flush();
+};
+
+#endif //GRAPHICS_TEST_WORLD_STORAGE_H
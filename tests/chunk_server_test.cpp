@@ -0,0 +1,123 @@
+//
+// Created by Luca Warmenhoven on 17/10/2026.
+//
+
+#include <iostream>
+#include <cstring>
+#include <cstdlib>
+#include <thread>
+#include <chrono>
+#include <unistd.h>
+#include "../src/world/world.h"
+#include "../src/world/terrain_generator.h"
+#include "../src/world/height_map_codec.h"
+#include "../src/net/chunk_server.h"
+#include "../src/net/chunk_client.h"
+
+// How long the client keeps trying to connect while the server starts listening, in milliseconds
+#define CHUNK_SERVER_TEST_CONNECT_TIMEOUT (5000)
+#define CHUNK_SERVER_TEST_SEED (1234)
+
+/**
+ * Compares a fetched chunk with the height map the terrain generator produces for it.
+ */
+static bool matchesGenerator(glm::ivec2 chunk, const uint16_t *quantized, float minimum, float scale)
+{
+    float heights[ CHUNK_SIZE * CHUNK_SIZE ];
+    uint16_t expected[ CHUNK_SIZE * CHUNK_SIZE ];
+    float expectedMinimum, expectedScale;
+    TerrainGenerator::getChunkHeights(chunk.x, chunk.y, heights);
+    HeightMapCodec::quantize(heights, CHUNK_SIZE * CHUNK_SIZE, expected, expectedMinimum, expectedScale);
+
+    if ( minimum != expectedMinimum || scale != expectedScale ||
+         memcmp(quantized, expected, sizeof(expected)) != 0 ) {
+        std::cerr << "Chunk (" << chunk.x << ", " << chunk.y << ") differs from the terrain generator." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Starts a chunk server on a temporary socket, and checks that the chunks fetched from it,
+ * one by one and batched, are the chunks the terrain generator produces for its seed.
+ */
+int main()
+{
+    char directory[] = "/tmp/chunk-server-test-XXXXXX";
+    if ( !mkdtemp(directory)) {
+        std::cerr << "Failed to create a temporary directory: " << strerror(errno) << std::endl;
+        return 1;
+    }
+    std::string socketPath = std::string(directory) + "/chunks.sock";
+
+    // The server runs until the process exits
+    auto *server = new ChunkServer(socketPath.c_str(), CHUNK_SERVER_TEST_SEED, 2, 64);
+    std::thread(&ChunkServer::run, server).detach();
+
+    ChunkClient *client = nullptr;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(CHUNK_SERVER_TEST_CONNECT_TIMEOUT);
+    while ( true ) {
+        if ( access(socketPath.c_str(), F_OK) == 0 ) {
+            client = new ChunkClient(socketPath.c_str(), CHUNK_SIZE, CHUNK_SERVER_TEST_SEED);
+            if ( client->isConnected())
+                break;
+            delete client;
+            client = nullptr;
+        }
+        if ( std::chrono::steady_clock::now() > deadline ) {
+            std::cerr << "The chunk server didn't start listening." << std::endl;
+            return 1;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    bool passed = true;
+
+    // A single chunk
+    uint16_t quantized[ CHUNK_SIZE * CHUNK_SIZE ];
+    float minimum, scale;
+    glm::ivec2 single(3 * CHUNK_SIZE, -2 * CHUNK_SIZE);
+    if ( !client->fetch(single.x, single.y, quantized, minimum, scale)) {
+        std::cerr << "Failed to fetch a single chunk." << std::endl;
+        passed = false;
+    } else {
+        passed = matchesGenerator(single, quantized, minimum, scale) && passed;
+    }
+
+    // A batch larger than CHUNK_PROTOCOL_MAX_BATCH, so it takes more than one round trip,
+    // including the chunk above, which is answered from the cache of the server
+    std::vector<glm::ivec2> chunks = { single };
+    for ( int32_t i = -5; i < 5; i++ )
+        for ( int32_t j = -5; j < 5; j++ )
+            chunks.emplace_back(i * CHUNK_SIZE, j * CHUNK_SIZE);
+
+    std::vector<uint16_t> heightMaps(chunks.size() * CHUNK_SIZE * CHUNK_SIZE);
+    std::vector<chunk_fetch_result_t> results(chunks.size());
+    for ( size_t i = 0; i < chunks.size(); i++ )
+        results[ i ] = { &heightMaps[ i * CHUNK_SIZE * CHUNK_SIZE ], 0, 0, false };
+    size_t fetched = client->fetch(chunks.data(), chunks.size(), results.data());
+    if ( fetched != chunks.size()) {
+        std::cerr << "Fetched " << fetched << " of " << chunks.size() << " chunks." << std::endl;
+        passed = false;
+    }
+    for ( size_t i = 0; i < chunks.size(); i++ ) {
+        if ( results[ i ].fetched )
+            passed = matchesGenerator(chunks[ i ], results[ i ].quantized, results[ i ].minimum,
+                                      results[ i ].scale) && passed;
+    }
+
+    delete client;
+
+    // A client with another seed is refused, its fetches fail so it generates the chunks itself
+    ChunkClient otherSeed(socketPath.c_str(), CHUNK_SIZE, CHUNK_SERVER_TEST_SEED + 1);
+    if ( otherSeed.fetch(single.x, single.y, quantized, minimum, scale)) {
+        std::cerr << "A chunk was fetched for another seed." << std::endl;
+        passed = false;
+    }
+
+    unlink(socketPath.c_str());
+    rmdir(directory);
+
+    std::cout << ( passed ? "Chunk server test passed." : "Chunk server test failed." ) << std::endl;
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,69 @@
+//
+// Created by Luca Warmenhoven on 17/10/2026.
+//
+
+#include <iostream>
+#include <cstring>
+#include <cmath>
+#include <vector>
+#include "../src/world/world.h"
+#include "../src/world/terrain_generator.h"
+#include "../src/world/height_map_codec.h"
+
+#define HEIGHT_MAP_CODEC_TEST_SAMPLES (CHUNK_SIZE * CHUNK_SIZE)
+
+/**
+ * Round trips a generated chunk through the cold tier, and checks that truncated
+ * or corrupt encodings are rejected instead of decoded.
+ */
+int main()
+{
+    bool passed = true;
+
+    float heights[ HEIGHT_MAP_CODEC_TEST_SAMPLES ];
+    uint16_t quantized[ HEIGHT_MAP_CODEC_TEST_SAMPLES ];
+    uint16_t decoded[ HEIGHT_MAP_CODEC_TEST_SAMPLES ];
+    float minimum, scale;
+    TerrainGenerator::getChunkHeights(5 * CHUNK_SIZE, -3 * CHUNK_SIZE, heights);
+    HeightMapCodec::quantize(heights, HEIGHT_MAP_CODEC_TEST_SAMPLES, quantized, minimum, scale);
+
+    // Quantization is only off by half a step
+    for ( size_t i = 0; i < HEIGHT_MAP_CODEC_TEST_SAMPLES; i++ ) {
+        float height = HeightMapCodec::dequantize(quantized[ i ], minimum, scale);
+        if ( std::abs(height - heights[ i ]) > scale * 0.5f + 1e-4f ) {
+            std::cerr << "Sample " << i << " quantizes to " << height << " instead of " << heights[ i ] << "."
+                      << std::endl;
+            passed = false;
+            break;
+        }
+    }
+
+    std::vector<uint8_t> encoded;
+    HeightMapCodec::encode(quantized, HEIGHT_MAP_CODEC_TEST_SAMPLES, CHUNK_SIZE, encoded);
+    if ( !HeightMapCodec::decode(encoded.data(), encoded.size(), HEIGHT_MAP_CODEC_TEST_SAMPLES, CHUNK_SIZE,
+                                 decoded) || memcmp(decoded, quantized, sizeof(quantized)) != 0 ) {
+        std::cerr << "The encoded chunk doesn't decode to its quantized heights." << std::endl;
+        passed = false;
+    }
+
+    // The last byte always holds coded bits, so any truncation has to be noticed
+    for ( size_t size : { encoded.size() - 1, encoded.size() / 2, (size_t) 0 } ) {
+        if ( HeightMapCodec::decode(encoded.data(), size, HEIGHT_MAP_CODEC_TEST_SAMPLES, CHUNK_SIZE, decoded)) {
+            std::cerr << "An encoding truncated to " << size << " of " << encoded.size() << " bytes was decoded."
+                      << std::endl;
+            passed = false;
+        }
+    }
+
+    // The Rice parameter of the first row is stored in the highest bits of the first byte
+    std::vector<uint8_t> corrupt = encoded;
+    corrupt[ 0 ] |= 0xFF << ( 8 - HEIGHT_MAP_RICE_PARAMETER_BITS );
+    if ( HeightMapCodec::decode(corrupt.data(), corrupt.size(), HEIGHT_MAP_CODEC_TEST_SAMPLES, CHUNK_SIZE, decoded)) {
+        std::cerr << "An encoding with a Rice parameter of " << ( corrupt[ 0 ] >> ( 8 - HEIGHT_MAP_RICE_PARAMETER_BITS ))
+                  << " was decoded." << std::endl;
+        passed = false;
+    }
+
+    std::cout << ( passed ? "Height map codec test passed." : "Height map codec test failed." ) << std::endl;
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,299 @@
+//
+// Created by Luca Warmenhoven on 17/10/2026.
+//
+
+#include <iostream>
+#include <cmath>
+#include <functional>
+#include <vector>
+#include <algorithm>
+#include "../src/world/noise.h"
+#include "../src/world/noise_graph.h"
+
+// Not a multiple of NOISE_GRAPH_TILE_SIZE, so the last tile is a partial one
+#define NOISE_GRAPH_TEST_POINTS (200)
+
+typedef std::function<float(float, float)> reference_node_t;
+
+/**
+ * Builds a NoiseGraph, and next to it a reference that evaluates every node on its own
+ * at a single point, without any folding, fusing or register allocation.
+ */
+class ReferenceGraph
+{
+
+private:
+
+    std::vector<reference_node_t> references;
+
+    int set(int node, reference_node_t reference)
+    {
+        if ( node >= (int) this->references.size())
+            this->references.resize(node + 1);
+        this->references[ node ] = std::move(reference);
+        return node;
+    }
+
+public:
+
+    NoiseGraph graph;
+    int output = -1;
+
+    ReferenceGraph()
+    {
+        this->set(this->graph.getX(), [](float x, float) { return x; });
+        this->set(this->graph.getZ(), [](float, float z) { return z; });
+    }
+
+    int x() const
+    {
+        return this->graph.getX();
+    }
+
+    int z() const
+    {
+        return this->graph.getZ();
+    }
+
+    int constant(float value)
+    {
+        return this->set(this->graph.constant(value), [value](float, float) { return value; });
+    }
+
+    int simplex(float frequency, float amplitude, int x = -1, int z = -1)
+    {
+        reference_node_t sx = this->references[ x < 0 ? this->x() : x ];
+        reference_node_t sz = this->references[ z < 0 ? this->z() : z ];
+        return this->set(this->graph.simplex(frequency, amplitude, x, z), [=](float x, float z) {
+            return SimplexNoise::noise(sx(x, z) * frequency, sz(x, z) * frequency) * amplitude;
+        });
+    }
+
+    int fbm(int octaves, float frequency, float amplitude)
+    {
+        return this->set(this->graph.fbm(octaves, frequency, amplitude), [=](float x, float z) {
+            float sum = 0.0f, f = frequency, a = amplitude;
+            for ( int octave = 0; octave < octaves; octave++, f *= 2.0f, a *= 0.5f )
+                sum += SimplexNoise::noise(x * f, z * f) * a;
+            return sum;
+        });
+    }
+
+    int domainWarp(int coordinate, int offset, float strength)
+    {
+        reference_node_t c = this->references[ coordinate ], o = this->references[ offset ];
+        return this->set(this->graph.domainWarp(coordinate, offset, strength), [=](float x, float z) {
+            return c(x, z) + o(x, z) * strength;
+        });
+    }
+
+    int add(int a, int b)
+    {
+        reference_node_t ra = this->references[ a ], rb = this->references[ b ];
+        return this->set(this->graph.add(a, b), [=](float x, float z) { return ra(x, z) + rb(x, z); });
+    }
+
+    int multiply(int a, int b)
+    {
+        reference_node_t ra = this->references[ a ], rb = this->references[ b ];
+        return this->set(this->graph.multiply(a, b), [=](float x, float z) { return ra(x, z) * rb(x, z); });
+    }
+
+    int scaleBias(int a, float scale, float bias)
+    {
+        reference_node_t ra = this->references[ a ];
+        return this->set(this->graph.scaleBias(a, scale, bias), [=](float x, float z) {
+            return ra(x, z) * scale + bias;
+        });
+    }
+
+    int blend(int a, int b, int t)
+    {
+        reference_node_t ra = this->references[ a ], rb = this->references[ b ], rt = this->references[ t ];
+        return this->set(this->graph.blend(a, b, t), [=](float x, float z) {
+            float weight = std::clamp(rt(x, z), 0.0f, 1.0f);
+            return ra(x, z) * ( 1.0f - weight ) + rb(x, z) * weight;
+        });
+    }
+
+    int curve(int a, const std::vector<glm::vec2> &points)
+    {
+        reference_node_t ra = this->references[ a ];
+        return this->set(this->graph.curve(a, points), [=](float x, float z) {
+            float value = ra(x, z);
+            if ( value <= points.front().x )
+                return points.front().y;
+            for ( size_t i = 1; i < points.size(); i++ )
+                if ( value < points[ i ].x )
+                    return glm::mix(points[ i - 1 ].y, points[ i ].y,
+                                    ( value - points[ i - 1 ].x ) / ( points[ i ].x - points[ i - 1 ].x ));
+            return points.back().y;
+        });
+    }
+
+    int clamp(int a, float minimum, float maximum)
+    {
+        reference_node_t ra = this->references[ a ];
+        return this->set(this->graph.clamp(a, minimum, maximum), [=](float x, float z) {
+            return std::clamp(ra(x, z), minimum, maximum);
+        });
+    }
+
+    void setOutput(int node)
+    {
+        this->output = node;
+        this->graph.setOutput(node);
+    }
+
+    float reference(float x, float z) const
+    {
+        return this->references[ this->output ](x, z);
+    }
+};
+
+/**
+ * Compiles the graph, and compares it with its reference at a grid of points.
+ * @param instructions The amount of instructions the graph has to compile to, or 0 when it isn't checked
+ */
+static bool check(const char *name, ReferenceGraph &reference, size_t instructions)
+{
+    if ( !reference.graph.compile()) {
+        std::cerr << "Graph '" << name << "' doesn't compile." << std::endl;
+        return false;
+    }
+    if ( instructions > 0 && reference.graph.getInstructionCount() != instructions ) {
+        std::cerr << "Graph '" << name << "' compiles to " << reference.graph.getInstructionCount()
+                  << " instructions instead of " << instructions << "." << std::endl;
+        return false;
+    }
+
+    float x[ NOISE_GRAPH_TEST_POINTS ], z[ NOISE_GRAPH_TEST_POINTS ], out[ NOISE_GRAPH_TEST_POINTS ];
+    for ( int i = 0; i < NOISE_GRAPH_TEST_POINTS; i++ ) {
+        x[ i ] = (float) ( i % 20 ) * 37.25f - 300.0f;
+        z[ i ] = (float) ( i / 20 ) * 53.5f - 200.0f;
+    }
+    reference.graph.evaluate(x, z, out, NOISE_GRAPH_TEST_POINTS);
+
+    for ( int i = 0; i < NOISE_GRAPH_TEST_POINTS; i++ ) {
+        float expected = reference.reference(x[ i ], z[ i ]);
+        if ( std::abs(out[ i ] - expected) > 1e-4f * std::max(1.0f, std::abs(expected))) {
+            std::cerr << "Graph '" << name << "' evaluates to " << out[ i ] << " instead of " << expected
+                      << " at (" << x[ i ] << ", " << z[ i ] << ")." << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Compiles the graph of each fold and fuse rule of NoiseGraph::compile, and compares it with
+ * a per-node evaluation. Graphs that have to be rejected are checked to evaluate to 0.
+ */
+int main()
+{
+    bool passed = true;
+
+    // Constant subgraphs fold into a single fill, through every kind of node
+    {
+        ReferenceGraph graph;
+        int sum = graph.add(graph.constant(1.0f), graph.constant(3.0f));
+        int product = graph.multiply(graph.constant(2.0f), sum);
+        int scaled = graph.scaleBias(graph.scaleBias(product, 0.5f, 1.0f), 3.0f, -2.0f);
+        int curved = graph.curve(scaled, { { 0.0f, 0.0f }, { 10.0f, 5.0f }, { 20.0f, 40.0f }});
+        int mixed = graph.blend(curved, graph.constant(-7.0f), graph.constant(1.5f));
+        graph.setOutput(graph.clamp(mixed, -5.0f, 5.0f));
+        passed &= check("constants", graph, 1);
+    }
+
+    // Constants added to or multiplied with a variable turn into scale and bias, which merge with each other
+    {
+        ReferenceGraph graph;
+        int warped = graph.add(graph.constant(10.0f), graph.multiply(graph.x(), graph.constant(0.5f)));
+        int source = graph.add(graph.simplex(0.01f, 1.0f, warped), graph.constant(2.0f));
+        graph.setOutput(graph.scaleBias(graph.multiply(graph.constant(3.0f), source), 2.0f, 1.0f));
+        passed &= check("scale and bias", graph, 2);
+    }
+
+    // Blends with a constant weight of 0 or 1, or beyond, pick one of their inputs
+    {
+        ReferenceGraph graph;
+        int a = graph.simplex(0.003f, 20.0f);
+        int b = graph.simplex(0.02f, 4.0f);
+        int first = graph.blend(a, b, graph.constant(-1.0f));
+        int second = graph.blend(a, b, graph.constant(4.0f));
+        int half = graph.blend(first, second, graph.constant(0.25f));
+        graph.setOutput(half);
+        passed &= check("constant blends", graph, 0);
+    }
+
+    // Sums of simplex noises accumulate into one another, scaling fuses into the amplitude and bias
+    {
+        ReferenceGraph graph;
+        graph.setOutput(graph.fbm(5, 0.002f, 60.0f));
+        passed &= check("fbm", graph, 5);
+    }
+    {
+        ReferenceGraph graph;
+        int fused = graph.scaleBias(graph.simplex(0.01f, 3.0f), -2.0f, 7.0f);
+        graph.setOutput(graph.add(graph.scaleBias(graph.fbm(3, 0.004f, 10.0f), 0.5f, 1.0f), fused));
+        passed &= check("scaled sums", graph, 5);
+    }
+
+    // Sources used more than once keep their own register
+    {
+        ReferenceGraph graph;
+        int shared = graph.simplex(0.005f, 8.0f);
+        int twice = graph.add(shared, shared);
+        int again = graph.add(graph.simplex(0.03f, 1.0f), shared);
+        graph.setOutput(graph.multiply(twice, graph.add(again, graph.multiply(shared, shared))));
+        passed &= check("shared sources", graph, 0);
+    }
+
+    // Warped coordinates, curves and clamps
+    {
+        ReferenceGraph graph;
+        int warpX = graph.domainWarp(graph.x(), graph.simplex(0.004f, 1.0f), 40.0f);
+        int warpZ = graph.domainWarp(graph.z(), graph.simplex(0.004f, 1.0f, graph.z(), graph.x()), 40.0f);
+        int warped = graph.simplex(0.002f, 1.0f, warpX, warpZ);
+        int curved = graph.curve(warped, { { -0.5f, -10.0f }, { 0.0f, 0.0f }, { 0.3f, 25.0f }, { 0.8f, 30.0f }});
+        graph.setOutput(graph.clamp(curved, -5.0f, 28.0f));
+        passed &= check("domain warp", graph, 0);
+    }
+
+    // Many values alive at once, of which some die at the instruction that writes to their register
+    {
+        ReferenceGraph graph;
+        std::vector<int> values;
+        for ( int i = 0; i < 8; i++ )
+            values.push_back(graph.simplex(0.001f * (float) ( i + 1 ), (float) ( 8 - i )));
+        int mask = graph.clamp(graph.scaleBias(values[ 0 ], 0.125f, 0.5f), 0.0f, 1.0f);
+        int result = graph.blend(values[ 1 ], values[ 2 ], mask);
+        for ( int i = 3; i < 8; i++ )
+            result = graph.blend(result, graph.multiply(values[ i ], result), values[ i - 3 ]);
+        // The register of `result` is only freed once, even though both inputs of `squared` use it last
+        int squared = graph.multiply(result, result);
+        int late = graph.clamp(graph.simplex(0.05f, 2.0f), -1.0f, 1.0f);
+        graph.setOutput(graph.add(squared, graph.add(late, graph.curve(values[ 7 ], { { 0.0f, 1.0f }}))));
+        passed &= check("register reuse", graph, 0);
+    }
+
+    // Graphs that have to be rejected: no output, an input that isn't an earlier node, and an empty curve
+    {
+        NoiseGraph noOutput;
+        noOutput.simplex(0.01f);
+        NoiseGraph laterInput;
+        laterInput.setOutput(laterInput.add(laterInput.simplex(0.01f), 8));
+        NoiseGraph emptyCurve;
+        emptyCurve.setOutput(emptyCurve.curve(emptyCurve.simplex(0.01f), {}));
+
+        for ( NoiseGraph *graph: { &noOutput, &laterInput, &emptyCurve } ) {
+            if ( graph->compile() || graph->evaluate(12.0f, 34.0f) != 0.0f ) {
+                std::cerr << "An invalid graph compiled or didn't evaluate to 0." << std::endl;
+                passed = false;
+            }
+        }
+    }
+
+    std::cout << ( passed ? "Noise graph test passed." : "Noise graph test failed." ) << std::endl;
+    return passed ? 0 : 1;
+}